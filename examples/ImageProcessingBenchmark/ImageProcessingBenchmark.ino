@@ -0,0 +1,499 @@
+/*
+ * Measures the throughput of the image processing kernels, in source megapixels per second,
+ * and checks that the accelerated kernels return the same result as the portable
+ * scalar reference implementations. The kernels run on synthetic QQVGA frames,
+ * so no camera is needed.
+ */
+#include "arducam_dvp.h"
+#include "ImageProcessing/convert.h"
+#include "ImageProcessing/bayer.h"
+#include "ImageProcessing/resize.h"
+#include "ImageProcessing/tensor.h"
+#include "ImageProcessing/rotate.h"
+#include "ImageProcessing/bin.h"
+#include "ImageProcessing/stats.h"
+#include "ImageProcessing/motion.h"
+#include "ImageProcessing/background.h"
+#include "ImageProcessing/gradient.h"
+#include "ImageProcessing/integral.h"
+#include "ImageProcessing/blob.h"
+#include "ImageProcessing/flow.h"
+#include "ImageProcessing/corner.h"
+#include "ImageProcessing/quality.h"
+#include "ImageProcessing/equalize.h"
+#include "ImageProcessing/threshold.h"
+
+#define WIDTH   160
+#define HEIGHT  120
+#define RUNS    20
+
+static uint8_t src_buf[WIDTH * HEIGHT * 2];
+static uint8_t dst_buf[WIDTH * HEIGHT * 4];
+static uint8_t ref_buf[WIDTH * HEIGHT * 4];
+
+template <typename Kernel>
+uint32_t timeKernel(Kernel kernel)
+{
+    uint32_t start = micros();
+    for (int i = 0; i < RUNS; i++) {
+        kernel();
+    }
+    return micros() - start;
+}
+
+template <typename Kernel>
+void benchmark(const char *name, Kernel kernel, uint32_t pixels = WIDTH * HEIGHT)
+{
+    uint32_t t = timeKernel(kernel);
+
+    // Pixels per microsecond is megapixels per second
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print((float) pixels * RUNS / t, 2);
+    Serial.println(" Mpix/s");
+}
+
+template <typename Fast, typename Reference>
+void benchmark(const char *name, Fast fast, Reference reference)
+{
+    memset(dst_buf, 0, sizeof(dst_buf));
+    memset(ref_buf, 0, sizeof(ref_buf));
+
+    uint32_t t_fast = timeKernel(fast);
+    uint32_t t_ref = timeKernel(reference);
+    bool match = memcmp(dst_buf, ref_buf, sizeof(dst_buf)) == 0;
+
+    // Pixels per microsecond is megapixels per second
+    float pixels = (float) WIDTH * HEIGHT * RUNS;
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(pixels / t_fast, 2);
+    Serial.print(" Mpix/s, reference ");
+    Serial.print(pixels / t_ref, 2);
+    Serial.print(" Mpix/s, speedup ");
+    Serial.print((float) t_ref / t_fast, 2);
+    Serial.println(match ? "x, OK" : "x, MISMATCH");
+}
+
+void check(const char *name, bool ok)
+{
+    Serial.print(name);
+    Serial.println(ok ? ": OK" : ": MISMATCH");
+}
+
+// Resize results computed by hand: a black and a white pixel stretched to 4 pixels with the
+// pixel centers aligned, and 2x2 blocks averaged.
+bool checkResizeGolden()
+{
+    static uint8_t line[2] = { 0, 255 }, stretched[4];
+    static uint8_t blocks[8] = { 0, 2, 10, 20, 4, 6, 30, 40 }, averaged[2];
+    static const uint8_t stretched_golden[4] = { 0, 64, 191, 255 };
+    static const uint8_t averaged_golden[2] = { 3, 25 };
+    ImageView<PixelGrayscale> line_src(line, 2, 1), line_dst(stretched, 4, 1);
+    ImageView<PixelGrayscale> blocks_src(blocks, 4, 2), blocks_dst(averaged, 2, 1);
+
+    return resizeImage(line_src, line_dst, RESIZE_BILINEAR) == 0
+        && memcmp(stretched, stretched_golden, sizeof(stretched)) == 0
+        && resizeImage(blocks_src, blocks_dst, RESIZE_AREA) == 0
+        && memcmp(averaged, averaged_golden, sizeof(averaged)) == 0;
+}
+
+// The fixed-point bilinear resize is within 2 levels of the same resize in floating point,
+// the weights are rounded to 1/256.
+bool checkResizeModel(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst)
+{
+    if (resizeImage(src, dst, RESIZE_BILINEAR) != 0) {
+        return false;
+    }
+    uint32_t sw = src.getWidth(), sh = src.getHeight();
+    for (uint32_t y = 0; y < dst.getHeight(); y++) {
+        float sy = (y + 0.5f) * sh / dst.getHeight() - 0.5f;
+        sy = (sy < 0.0f) ? 0.0f : (sy > sh - 1) ? sh - 1 : sy;
+        uint32_t y0 = (uint32_t) sy, y1 = (y0 + 1 < sh) ? y0 + 1 : y0;
+        float fy = sy - y0;
+        for (uint32_t x = 0; x < dst.getWidth(); x++) {
+            float sx = (x + 0.5f) * sw / dst.getWidth() - 0.5f;
+            sx = (sx < 0.0f) ? 0.0f : (sx > sw - 1) ? sw - 1 : sx;
+            uint32_t x0 = (uint32_t) sx, x1 = (x0 + 1 < sw) ? x0 + 1 : x0;
+            float fx = sx - x0;
+            float top = src.at(x0, y0) * (1.0f - fx) + src.at(x1, y0) * fx;
+            float bottom = src.at(x0, y1) * (1.0f - fx) + src.at(x1, y1) * fx;
+            if (fabsf(top * (1.0f - fy) + bottom * fy - dst.at(x, y)) > 2.0f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Quantized values computed by hand: a black and a white pixel stretched to 4 pixels, mapped
+// to [-1, 1] and quantized with a scale of 1/128, the white pixel saturates.
+bool checkTensorGolden()
+{
+    static uint8_t line[2] = { 0, 255 };
+    static int8_t quantized[4];
+    static const int8_t quantized_golden[4] = { -128, -64, 64, 127 };
+    ImageView<PixelGrayscale> line_src(line, 2, 1);
+    TensorDescriptor tensor = { quantized, 4, 1, 1, TENSOR_INT8, 1.0f / 128.0f, 0, -1.0f, 1.0f };
+
+    return imageToTensor(line_src, tensor, RESIZE_BILINEAR) == 0
+        && memcmp(quantized, quantized_golden, sizeof(quantized)) == 0;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+
+    randomSeed(42);
+    for (uint32_t i = 0; i < sizeof(src_buf); i++) {
+        src_buf[i] = random(256);
+    }
+
+    ImageView<PixelYUV422> yuv(src_buf, WIDTH, HEIGHT);
+    ImageView<PixelGrayscale> gray(dst_buf, WIDTH, HEIGHT), gray_ref(ref_buf, WIDTH, HEIGHT);
+    ImageView<PixelRGB565> rgb565(dst_buf, WIDTH, HEIGHT), rgb565_ref(ref_buf, WIDTH, HEIGHT);
+    ImageView<PixelRGB888> rgb888(dst_buf, WIDTH, HEIGHT), rgb888_ref(ref_buf, WIDTH, HEIGHT);
+
+    benchmark("YUV422 to grayscale",
+            [&]() { yuv422ToGrayscale(yuv, gray); },
+            [&]() { yuv422ToGrayscaleReference(yuv, gray_ref); });
+    benchmark("YUV422 to RGB565",
+            [&]() { yuv422ToRGB565(yuv, rgb565); },
+            [&]() { yuv422ToRGB565Reference(yuv, rgb565_ref); });
+    benchmark("YUV422 to RGB888",
+            [&]() { yuv422ToRGB888(yuv, rgb888); },
+            [&]() { yuv422ToRGB888Reference(yuv, rgb888_ref); });
+
+    // RGB565 byte order: sensors that can swap the bytes themselves (CAMERA_RGB565_LE on the
+    // OV767X) deliver little-endian pixels without any CPU time, the others need a swap.
+    ImageView<PixelRGB565> rgb565_src(src_buf, WIDTH, HEIGHT);
+    ImageView<PixelRGB565LE> rgb565le(dst_buf, WIDTH, HEIGHT), rgb565le_ref(ref_buf, WIDTH, HEIGHT);
+    ImageView<PixelARGB8888> argb8888(dst_buf, WIDTH, HEIGHT), argb8888_ref(ref_buf, WIDTH, HEIGHT);
+    Serial.println("RGB565 byte swap by the sensor: no CPU time");
+    benchmark("RGB565 byte swap",
+            [&]() { rgb565SwapBytes(rgb565_src, rgb565le); },
+            [&]() { rgb565SwapBytesReference(rgb565_src, rgb565le_ref); });
+    benchmark("RGB565 to RGB888",
+            [&]() { rgb565ToRGB888(rgb565_src, rgb888); },
+            [&]() { rgb565ToRGB888Reference(rgb565_src, rgb888_ref); });
+    benchmark("RGB565 to ARGB8888",
+            [&]() { rgb565ToARGB8888(rgb565_src, argb8888); },
+            [&]() { rgb565ToARGB8888Reference(rgb565_src, argb8888_ref); });
+
+    ImageView<PixelBayer> bayer(src_buf, WIDTH, HEIGHT);
+    ImageView<PixelRGB565> rgb565_half(dst_buf, WIDTH / 2, HEIGHT / 2);
+    benchmark("Bayer to RGB565, nearest",
+            [&]() { bayerToRGB565(bayer, rgb565, CAMERA_BAYER, DEMOSAIC_NEAREST); });
+    benchmark("Bayer to RGB565, bilinear",
+            [&]() { bayerToRGB565(bayer, rgb565, CAMERA_BAYER, DEMOSAIC_BILINEAR); });
+    benchmark("Bayer to RGB565, half size",
+            [&]() { bayerToRGB565(bayer, rgb565_half, CAMERA_BAYER, DEMOSAIC_HALF); });
+    benchmark("Bayer to RGB888, bilinear",
+            [&]() { bayerToRGB888(bayer, rgb888, CAMERA_BAYER, DEMOSAIC_BILINEAR); });
+    benchmark("Bayer to grayscale, bilinear",
+            [&]() { bayerToGrayscale(bayer, gray, CAMERA_BAYER, DEMOSAIC_BILINEAR); });
+    benchmark("Bayer to luma",
+            [&]() { bayerToLuma(bayer, gray, CAMERA_BAYER); });
+
+    ImageView<PixelGrayscale> gray_src(src_buf, WIDTH, HEIGHT);
+    ImageView<PixelGrayscale> gray_96(dst_buf, 96, 96), gray_quarter(dst_buf, WIDTH / 2, HEIGHT / 2);
+    ImageView<PixelRGB565> rgb565_96(dst_buf, 96, 96);
+    benchmark("Resize grayscale to 96x96, nearest",
+            [&]() { resizeImage(gray_src, gray_96, RESIZE_NEAREST); });
+    benchmark("Resize grayscale to 96x96, bilinear",
+            [&]() { resizeImage(gray_src, gray_96, RESIZE_BILINEAR); });
+    benchmark("Resize grayscale to half size, area",
+            [&]() { resizeImage(gray_src, gray_quarter, RESIZE_AREA); });
+    benchmark("Resize RGB565 to 96x96, bilinear",
+            [&]() { resizeImage(rgb565_src, rgb565_96, RESIZE_BILINEAR); });
+
+    // The coordinate tables and the scratch rows kept by the caller, against the resize that allocates them.
+    static ResizeCoord xc[96], yc[96];
+    static uint32_t scratch[RESIZE_SCRATCH_WORDS(96, 3)];
+    resizeCoords(WIDTH, 96, RESIZE_BILINEAR, xc);
+    resizeCoords(HEIGHT, 96, RESIZE_BILINEAR, yc);
+    ImageView<PixelGrayscale> gray_96_ref(ref_buf, 96, 96);
+    ImageView<PixelRGB565> rgb565_96_ref(ref_buf, 96, 96);
+    benchmark("Resize grayscale to 96x96, bilinear, caller tables",
+            [&]() { resizeImage(gray_src, gray_96, RESIZE_BILINEAR, xc, yc, scratch); },
+            [&]() { resizeImage(gray_src, gray_96_ref, RESIZE_BILINEAR); });
+    benchmark("Resize RGB565 to 96x96, bilinear, caller tables",
+            [&]() { resizeImage(rgb565_src, rgb565_96, RESIZE_BILINEAR, xc, yc, scratch); },
+            [&]() { resizeImage(rgb565_src, rgb565_96_ref, RESIZE_BILINEAR); });
+    check("Resize golden values", checkResizeGolden());
+    check("Resize bilinear float model", checkResizeModel(gray_src, gray_96));
+
+    // Model input: the fused kernel against a resize followed by a quantization pass,
+    // for an int8 tensor with inputs in [0, 1] (scale 1/255, zero point -128).
+    TensorDescriptor tensor = { dst_buf, 96, 96, 1, TENSOR_INT8, 1.0f / 255.0f, -128, 0.0f, 1.0f };
+    ImageView<PixelGrayscale> input_ref(ref_buf, 96, 96);
+    benchmark("Grayscale to int8 tensor 96x96, fused",
+            [&]() { imageToTensor(gray_src, tensor, RESIZE_BILINEAR); },
+            [&]() {
+                resizeImage(gray_src, input_ref, RESIZE_BILINEAR);
+                for (uint32_t i = 0; i < 96 * 96; i++) {
+                    ref_buf[i] = (uint8_t) (ref_buf[i] - 128);
+                }
+            });
+    tensor.channels = 3;
+    benchmark("RGB565 to int8 tensor 96x96x3, fused",
+            [&]() { imageToTensor(rgb565_src, tensor, RESIZE_BILINEAR); });
+
+    // The tables kept from frame to frame by a converter, against the conversion that builds them.
+    static TensorConverter tc;
+    TensorDescriptor tensor_ref = tensor;
+    tensor_ref.data = ref_buf;
+    if (tensorBegin(tc, tensor, WIDTH, HEIGHT) == 0) {
+        benchmark("RGB565 to int8 tensor 96x96x3, converter",
+                [&]() { imageToTensor(tc, rgb565_src); },
+                [&]() { imageToTensor(rgb565_src, tensor_ref, RESIZE_BILINEAR); });
+    }
+    tensorEnd(tc);
+    check("Tensor golden values", checkTensorGolden());
+
+    // Software flip and rotation, for sensors without a hardware mirror.
+    ImageView<PixelGrayscale> gray_rotated(dst_buf, HEIGHT, WIDTH), gray_rotated_ref(ref_buf, HEIGHT, WIDTH);
+    ImageView<PixelRGB565> rgb565_rotated(dst_buf, HEIGHT, WIDTH), rgb565_rotated_ref(ref_buf, HEIGHT, WIDTH);
+    benchmark("Flip grayscale 180",
+            [&]() { flipImage(gray_src, gray, true, true); },
+            [&]() { flipImageReference(gray_src, gray_ref, true, true); });
+    benchmark("Flip RGB565 180",
+            [&]() { flipImage(rgb565_src, rgb565, true, true); },
+            [&]() { flipImageReference(rgb565_src, rgb565_ref, true, true); });
+    benchmark("Rotate grayscale 90",
+            [&]() { rotateImage(gray_src, gray_rotated, ROTATE_90); },
+            [&]() { rotateImageReference(gray_src, gray_rotated_ref, ROTATE_90); });
+    benchmark("Rotate RGB565 270",
+            [&]() { rotateImage(rgb565_src, rgb565_rotated, ROTATE_270); },
+            [&]() { rotateImageReference(rgb565_src, rgb565_rotated_ref, ROTATE_270); });
+    benchmark("Mirror grayscale in place",
+            [&]() { flipImage(gray, gray, false, true); });
+    benchmark("Flip RGB565 vertically in place",
+            [&]() { flipImage(rgb565, rgb565, true, false); });
+
+    // A QVGA frame doesn't fit in the cache like the smaller frames above. The grayscale
+    // frame and its rotation fit in the destination and reference buffers.
+    const uint32_t qvga_pixels = 320 * 240;
+    ImageView<PixelGrayscale> qvga(dst_buf, 320, 240), qvga_rotated(ref_buf, 240, 320);
+    for (uint32_t y = 0; y < 240; y++) {
+        for (uint32_t x = 0; x < 320; x++) {
+            qvga.at(x, y) = (uint8_t) (x * 7 + y * 13);
+        }
+    }
+    benchmark("Rotate grayscale 90, QVGA",
+            [&]() { rotateImage(qvga, qvga_rotated, ROTATE_90); }, qvga_pixels);
+    benchmark("Flip grayscale 180 in place, QVGA",
+            [&]() { flipImage(qvga, qvga, true, true); }, qvga_pixels);
+    // An even number of flips and a rotation back give the frame again.
+    bool qvga_ok = rotateImage(qvga_rotated, qvga, ROTATE_270) == 0;
+    for (uint32_t y = 0; y < 240; y++) {
+        for (uint32_t x = 0; x < 320; x++) {
+            qvga_ok = qvga_ok && qvga.at(x, y) == (uint8_t) (x * 7 + y * 13);
+        }
+    }
+    check("Rotate grayscale QVGA round trip", qvga_ok);
+
+    // Binning, a low resolution copy without reconfiguring the sensor.
+    ImageView<PixelGrayscale> gray_bin4(dst_buf, WIDTH / 4, HEIGHT / 4), gray_bin4_ref(ref_buf, WIDTH / 4, HEIGHT / 4);
+    ImageView<PixelRGB565> rgb565_bin2(dst_buf, WIDTH / 2, HEIGHT / 2), rgb565_bin2_ref(ref_buf, WIDTH / 2, HEIGHT / 2);
+    ImageView<PixelGrayscale> gray_half_ref(ref_buf, WIDTH / 2, HEIGHT / 2);
+    benchmark("Bin grayscale 2x2",
+            [&]() { binImage(gray_src, gray_quarter, 2); },
+            [&]() { binImageReference(gray_src, gray_half_ref, 2); });
+    benchmark("Bin grayscale 4x4",
+            [&]() { binImage(gray_src, gray_bin4, 4); },
+            [&]() { binImageReference(gray_src, gray_bin4_ref, 4); });
+    benchmark("Bin RGB565 2x2",
+            [&]() { binImage(rgb565_src, rgb565_bin2, 2); },
+            [&]() { binImageReference(rgb565_src, rgb565_bin2_ref, 2); });
+
+    // Statistics, copied to the output buffers so that the results are compared.
+    static ImageStats stats, stats_ref;
+    benchmark("Statistics grayscale, 4x4 grid",
+            [&]() {
+                statsBegin(stats, WIDTH, HEIGHT, 4, 4);
+                statsUpdate(stats, gray_src, 0);
+                memcpy(dst_buf, &stats, sizeof(stats));
+            },
+            [&]() {
+                statsBegin(stats_ref, WIDTH, HEIGHT, 4, 4);
+                statsUpdateReference(stats_ref, gray_src, 0);
+                memcpy(ref_buf, &stats_ref, sizeof(stats_ref));
+            });
+    benchmark("Statistics RGB565, 4x4 grid",
+            [&]() { statsBegin(stats, WIDTH, HEIGHT, 4, 4); statsUpdate(stats, rgb565_src, 0); });
+
+    // Motion detection, both detectors see the same frames so their states are compared.
+    static MotionDetector md, md_ref;
+    motionBegin(md);
+    motionBegin(md_ref);
+    benchmark("Motion detection grayscale, 8x6 grid",
+            [&]() { motionUpdate(md, gray_src); memcpy(dst_buf, &md, sizeof(md)); },
+            [&]() { motionUpdateReference(md_ref, gray_src); memcpy(ref_buf, &md_ref, sizeof(md_ref)); });
+    benchmark("Motion detection RGB565, 8x6 grid",
+            [&]() { motionUpdate(md, rgb565_src); });
+
+    // Background subtraction, the models and the masks are copied to the output buffers.
+    static BackgroundModel bg, bg_ref;
+    if (backgroundBegin(bg, WIDTH, HEIGHT) == 0 && backgroundBegin(bg_ref, WIDTH, HEIGHT) == 0) {
+        uint32_t model_size = WIDTH * HEIGHT * sizeof(uint16_t);
+        uint32_t mask_size = MASK_ROW_WORDS(WIDTH) * HEIGHT * sizeof(uint32_t);
+        benchmark("Background grayscale",
+                [&]() {
+                    backgroundUpdate(bg, gray_src);
+                    memcpy(dst_buf, bg.model, model_size);
+                    memcpy(dst_buf + model_size, bg.mask, mask_size);
+                },
+                [&]() {
+                    backgroundUpdateReference(bg_ref, gray_src);
+                    memcpy(ref_buf, bg_ref.model, model_size);
+                    memcpy(ref_buf + model_size, bg_ref.mask, mask_size);
+                });
+    }
+    backgroundEnd(bg);
+    backgroundEnd(bg_ref);
+
+    // Gradients, Gx in the first half of the output buffers and Gy in the second half.
+    uint32_t plane = WIDTH * HEIGHT * sizeof(int16_t);
+    ImageView<PixelInt16> gx(dst_buf, WIDTH, HEIGHT), gx_ref(ref_buf, WIDTH, HEIGHT);
+    ImageView<PixelInt16> gy(dst_buf + plane, WIDTH, HEIGHT), gy_ref(ref_buf + plane, WIDTH, HEIGHT);
+    benchmark("Sobel Gx/Gy",
+            [&]() { gradientImage(gray_src, gx, gy, GRADIENT_SOBEL); },
+            [&]() { gradientImageReference(gray_src, gx_ref, gy_ref, GRADIENT_SOBEL); });
+    benchmark("Sobel magnitude",
+            [&]() { gradientMagnitude(gray_src, gray, GRADIENT_SOBEL); },
+            [&]() { gradientMagnitudeReference(gray_src, gray_ref, GRADIENT_SOBEL); });
+    benchmark("Scharr magnitude",
+            [&]() { gradientMagnitude(gray_src, gray, GRADIENT_SCHARR); },
+            [&]() { gradientMagnitudeReference(gray_src, gray_ref, GRADIENT_SCHARR); });
+
+    // Integral images, the last rows of the tables, that depend on every pixel, are compared.
+    static IntegralImage ii, ii_ref;
+    if (integralBegin(ii, WIDTH, HEIGHT, true) == 0 && integralBegin(ii_ref, WIDTH, HEIGHT, true) == 0) {
+        uint32_t last = HEIGHT * (WIDTH + 1);
+        uint32_t row_size = (WIDTH + 1) * sizeof(uint32_t);
+        benchmark("Integral image and squares",
+                [&]() {
+                    integralImage(ii, gray_src);
+                    memcpy(dst_buf, ii.sum + last, row_size);
+                    memcpy(dst_buf + row_size, ii.sum_sq + last, row_size);
+                },
+                [&]() {
+                    integralImageReference(ii_ref, gray_src);
+                    memcpy(ref_buf, ii_ref.sum + last, row_size);
+                    memcpy(ref_buf + row_size, ii_ref.sum_sq + last, row_size);
+                });
+    }
+    integralEnd(ii);
+    integralEnd(ii_ref);
+
+    // Blobs of a grid of discs, from a bit-packed mask and from the same 8-bit mask.
+    static uint32_t mask_bits[MASK_ROW_WORDS(WIDTH) * HEIGHT];
+    static uint8_t mask_bytes[WIDTH * HEIGHT];
+    memset(mask_bits, 0, sizeof(mask_bits));
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            int32_t dx = (int32_t) (x % 20) - 10;
+            int32_t dy = (int32_t) (y % 20) - 10;
+            mask_bytes[y * WIDTH + x] = (dx * dx + dy * dy < 49) ? 255 : 0;
+            if (mask_bytes[y * WIDTH + x]) {
+                maskSet(mask_bits, WIDTH, x, y);
+            }
+        }
+    }
+    static BlobLabeler labeler;
+    if (blobBegin(labeler, WIDTH) == 0) {
+        ImageView<PixelGrayscale> mask(mask_bytes, WIDTH, HEIGHT);
+        static Blob blobs[64], blobs_ref[64];
+        benchmark("Blobs bit-packed vs 8-bit mask",
+                [&]() {
+                    findBlobs(labeler, mask_bits, HEIGHT, blobs, 64);
+                    memcpy(dst_buf, blobs, sizeof(blobs));
+                },
+                [&]() {
+                    findBlobs(labeler, mask, blobs_ref, 64);
+                    memcpy(ref_buf, blobs_ref, sizeof(blobs_ref));
+                });
+    }
+    blobEnd(labeler);
+
+    // Optical flow between the grayscale frame and a copy moved by (3, -2) pixels.
+    static uint8_t moved_buf[WIDTH * HEIGHT];
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            uint32_t sx = (x >= 3) ? x - 3 : x;
+            uint32_t sy = (y + 2 < HEIGHT) ? y + 2 : y;
+            moved_buf[y * WIDTH + x] = gray_src.at(sx, sy);
+        }
+    }
+    ImageView<PixelGrayscale> moved(moved_buf, WIDTH, HEIGHT);
+    static FlowVector vectors[(WIDTH / FLOW_BLOCK_DEFAULT) * (HEIGHT / FLOW_BLOCK_DEFAULT)];
+    static FlowVector vectors_ref[(WIDTH / FLOW_BLOCK_DEFAULT) * (HEIGHT / FLOW_BLOCK_DEFAULT)];
+    benchmark("Block flow 16x16, +/-4",
+            [&]() { blockFlow(gray_src, moved, vectors); memcpy(dst_buf, vectors, sizeof(vectors)); },
+            [&]() { blockFlowReference(gray_src, moved, vectors_ref); memcpy(ref_buf, vectors_ref, sizeof(vectors_ref)); });
+    int32_t flow_dx, flow_dy;
+    check("Block flow global motion",
+            flowGlobalMotion(vectors, sizeof(vectors) / sizeof(vectors[0]), &flow_dx, &flow_dy) == 0
+            && flow_dx == 3 && flow_dy == -2);
+
+    // FAST corners, the keypoints are copied to the output buffers.
+    static CornerDetector det, det_ref;
+    if (cornerBegin(det, WIDTH, HEIGHT) == 0 && cornerBegin(det_ref, WIDTH, HEIGHT) == 0) {
+        benchmark("FAST-9 corners",
+                [&]() {
+                    int n = fastCorners(det, gray_src);
+                    memcpy(dst_buf, det.keypoints, n * sizeof(Keypoint));
+                },
+                [&]() {
+                    int n = fastCornersReference(det_ref, gray_src);
+                    memcpy(ref_buf, det_ref.keypoints, n * sizeof(Keypoint));
+                });
+    }
+    cornerEnd(det);
+    cornerEnd(det_ref);
+
+    // Quality metrics, copied to the output buffers so that the results are compared.
+    static FrameQuality quality, quality_ref;
+    benchmark("Quality grayscale",
+            [&]() { imageQuality(gray_src, quality); memcpy(dst_buf, &quality, sizeof(quality)); },
+            [&]() { imageQualityReference(gray_src, quality_ref); memcpy(ref_buf, &quality_ref, sizeof(quality_ref)); });
+    benchmark("Quality RGB565",
+            [&]() { imageQuality(rgb565_src, quality); });
+
+    // Histogram equalization, from the histogram of a statistics pass, and CLAHE with 4x4 tiles.
+    statsBegin(stats, WIDTH, HEIGHT);
+    statsUpdate(stats, gray_src, 0);
+    benchmark("Equalize grayscale",
+            [&]() { equalizeImage(gray_src, gray, stats.histogram); },
+            [&]() { equalizeImageReference(gray_src, gray_ref, stats.histogram); });
+    static Clahe clahe;
+    if (claheBegin(clahe, WIDTH, HEIGHT, 4, 4) == 0) {
+        benchmark("CLAHE histograms 4x4",
+                [&]() { claheUpdate(clahe, gray_src, 0); });
+        benchmark("CLAHE mapping 4x4",
+                [&]() { claheApply(clahe, gray_src, gray); },
+                [&]() { claheApplyReference(clahe, gray_src, gray_ref); });
+    }
+    claheEnd(clahe);
+
+    // Thresholds to bit-packed masks, Otsu's threshold from the histogram of the statistics pass.
+    static uint32_t mask_out[MASK_ROW_WORDS(WIDTH) * HEIGHT], mask_ref[MASK_ROW_WORDS(WIDTH) * HEIGHT];
+    int threshold = otsuThreshold(stats.histogram);
+    benchmark("Otsu threshold to mask",
+            [&]() { thresholdImage(gray_src, mask_out, threshold); memcpy(dst_buf, mask_out, sizeof(mask_out)); },
+            [&]() { thresholdImageReference(gray_src, mask_ref, threshold); memcpy(ref_buf, mask_ref, sizeof(mask_ref)); });
+    if (integralBegin(ii, WIDTH, HEIGHT) == 0 && integralImage(ii, gray_src) == 0) {
+        benchmark("Adaptive threshold to mask, 15x15",
+                [&]() { adaptiveThreshold(gray_src, ii, mask_out); memcpy(dst_buf, mask_out, sizeof(mask_out)); },
+                [&]() { adaptiveThresholdReference(gray_src, ii, mask_ref); memcpy(ref_buf, mask_ref, sizeof(mask_ref)); });
+    }
+    integralEnd(ii);
+    benchmark("Mask XOR and count",
+            [&]() { maskXor(mask_bits, mask_bits, mask_out, WIDTH, HEIGHT); maskCount(mask_bits, WIDTH, HEIGHT); });
+}
+
+void loop()
+{
+}
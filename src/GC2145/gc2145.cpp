@@ -33,6 +33,15 @@
 #define REG_OUTPUT_FMT_BAYER            (0x17)
 #define REG_OUTPUT_SET_FMT(r, x)        ((r&0xE0)|(x))
 
+#define REG_EXPOSURE_H                  (0x03)
+#define REG_EXPOSURE_L                  (0x04)
+#define REG_EXPOSURE_MAX                (0x1FFF)
+
+#define REG_GLOBAL_GAIN                 (0xB0)
+#define REG_GLOBAL_GAIN_1X              (0x40)
+
+#define REG_AEC_EN                      (0xB6)
+
 #define REG_SYNC_MODE                   (0x86)
 #define REG_SYNC_MODE_DEF               (0x23)
 #define REG_SYNC_MODE_COL_SWITCH        (0x10)
@@ -787,9 +796,53 @@ int GC2145::setHorizontalMirror(bool mirror_enable)
     return ((0 == retVal) ? 0 : -1);
 }
 
+int GC2145::setAutoExposure(bool enable)
+{
+    int ret = 0;
+    uint8_t aec;
+
+    // P0 regs
+    ret |= regWrite(GC2145_I2C_ADDR, 0xFE, 0x00);
+    ret |= regRead(GC2145_I2C_ADDR, REG_AEC_EN, &aec);
+    if (ret != 0) {
+        return -1;
+    }
+    ret |= regWrite(GC2145_I2C_ADDR, REG_AEC_EN, (aec & 0xFE) | enable);
+    return ((0 == ret) ? 0 : -1);
+}
+
+int GC2145::setExposure(uint32_t exposure)
+{
+    int ret = 0;
+
+    exposure = (exposure > REG_EXPOSURE_MAX) ? REG_EXPOSURE_MAX : exposure;
+    // P0 regs
+    ret |= regWrite(GC2145_I2C_ADDR, 0xFE, 0x00);
+    ret |= regWrite(GC2145_I2C_ADDR, REG_EXPOSURE_H, exposure >> 8);
+    ret |= regWrite(GC2145_I2C_ADDR, REG_EXPOSURE_L, exposure & 0xff);
+    return ((0 == ret) ? 0 : -1);
+}
+
+int GC2145::setGain(uint32_t gain)
+{
+    int ret = 0;
+
+    // The global gain is in 1/64 steps, the maximum gain is about 4x.
+    gain = gain * REG_GLOBAL_GAIN_1X / 16;
+    // P0 regs
+    ret |= regWrite(GC2145_I2C_ADDR, 0xFE, 0x00);
+    ret |= regWrite(GC2145_I2C_ADDR, REG_GLOBAL_GAIN, (gain > 0xFF) ? 0xFF : gain);
+    return ((0 == ret) ? 0 : -1);
+}
+
+uint32_t GC2145::getMaxGain()
+{
+    return 0xFF * 16 / REG_GLOBAL_GAIN_1X;
+}
+
 int GC2145::setResolution(int32_t resolution)
 {
-    setResolutionWithZoom(resolution, resolution, 0, 0);
+    return setResolutionWithZoom(resolution, resolution, 0, 0);
 }
 
 int GC2145::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, uint32_t zoom_x, uint32_t zoom_y)
@@ -799,8 +852,12 @@ int GC2145::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, u
     uint16_t win_w;
     uint16_t win_h;
 
-    uint16_t w = restab[resolution][0];
-    uint16_t h = restab[resolution][1];
+    if (!resolutionIsValid(resolution)) {
+        return -1;
+    }
+
+    uint16_t w = resolutionWidth(resolution);
+    uint16_t h = resolutionHeight(resolution);
 
     switch (resolution) {
         case CAMERA_R160x120:
@@ -823,7 +880,15 @@ int GC2145::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, u
             win_h = 1200;
             break;
         default:
-            return -1;
+            if (!resolutionIsCustom(resolution) || w > GC_MAX_WIN_W || h > GC_MAX_WIN_H) {
+                return -1;
+            }
+            // Use the highest sub-sampling ratio (up to 4) that still fits in the sensor.
+            for (win_w = w * 4, win_h = h * 4; win_w > GC_MAX_WIN_W || win_h > GC_MAX_WIN_H;) {
+                win_w -= w;
+                win_h -= h;
+            }
+            break;
     }
 
     uint16_t c_ratio = win_w / w;
@@ -832,8 +897,9 @@ int GC2145::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, u
     uint16_t x = (((win_w / c_ratio) - w) / 2);
     uint16_t y = (((win_h / r_ratio) - h) / 2);
 
-    uint16_t win_x = ((GC_MAX_WIN_W - win_w) / 2);
-    uint16_t win_y = ((GC_MAX_WIN_H - win_h) / 2);
+    // Keep the window on an even pixel, so that it starts on the same Bayer phase.
+    uint16_t win_x = ((GC_MAX_WIN_W - win_w) / 2) & ~1;
+    uint16_t win_y = ((GC_MAX_WIN_H - win_h) / 2) & ~1;
 
     // Set readout window first.
     ret |= setWindow(0x09, win_x, win_y, win_w + 16, win_h + 8);
@@ -841,21 +907,21 @@ int GC2145::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, u
     // Zoom mode active
     if (resolution != zoom_resolution)
     {
-        // Can't zoom into a larger window than the original
-        if (zoom_resolution > resolution)
+        // The zoom resolution constant is outside of the allowed range
+        if (!resolutionIsValid(zoom_resolution) || resolutionIsCustom(zoom_resolution))
         {
             return -1;
         }
-        
-        // The zoom resolution constant is outside of the allowed range
-        if ((zoom_resolution < 0) || (zoom_resolution >= CAMERA_RMAX))
+
+        uint32_t zoom_w = resolutionWidth(zoom_resolution);
+        uint32_t zoom_h = resolutionHeight(zoom_resolution);
+
+        // Can't zoom into a larger window than the original
+        if (zoom_w > w || zoom_h > h)
         {
             return -1;
         }
 
-        uint32_t zoom_w = restab[zoom_resolution][0];
-        uint32_t zoom_h = restab[zoom_resolution][1];
-
         // Check if the zoom window goes outside the frame on the x axis
         // Notice that this form prevents uint32_t wraparound, so don't change it
         if (zoom_x >= (w - zoom_w))
@@ -902,22 +968,34 @@ int GC2145::setPixelFormat(int32_t pixformat)
 
     switch (pixformat) {
         case CAMERA_RGB565:
+            ret |= regWrite(GC2145_I2C_ADDR,
+                    REG_SYNC_MODE, REG_SYNC_MODE_DEF);
             ret |= regWrite(GC2145_I2C_ADDR,
                     REG_OUTPUT_FMT, REG_OUTPUT_SET_FMT(reg, REG_OUTPUT_FMT_RGB565));
             break;
+        case CAMERA_YUV422:
+            ret |= regWrite(GC2145_I2C_ADDR,
+                    REG_SYNC_MODE, REG_SYNC_MODE_DEF);
+            ret |= regWrite(GC2145_I2C_ADDR,
+                    REG_OUTPUT_FMT, REG_OUTPUT_SET_FMT(reg, REG_OUTPUT_FMT_YCBYCR));
+            break;
         case CAMERA_GRAYSCALE:
-            // TODO: There's no support for extracting GS from YUV so we use Bayer for 1BPP for now.
-            //ret |= regWrite(GC2145_I2C_ADDR,
-            //        REG_OUTPUT_FMT, REG_OUTPUT_SET_FMT(reg, REG_OUTPUT_FMT_YCBYCR));
-            //break;
+            // Grayscale frames are sent as raw Bayer, 1 byte per pixel on the bus, and converted
+            // to luma by Camera::grabFrame(). See getBusFormat().
         case CAMERA_BAYER:
-            // There's no BAYER support so it will just look off.
-            // Make sure odd/even row are switched to work with our bayer conversion.
+            // Switch odd/even rows, so that the native GRBG frame starts with a BGGR block.
             ret |= regWrite(GC2145_I2C_ADDR,
                     REG_SYNC_MODE, REG_SYNC_MODE_DEF | REG_SYNC_MODE_ROW_SWITCH);
             ret |= regWrite(GC2145_I2C_ADDR,
                     REG_OUTPUT_FMT, REG_OUTPUT_SET_FMT(reg, REG_OUTPUT_FMT_BAYER));
             break;
+        case CAMERA_BAYER_GRBG:
+            // Native row order of the sensor, the same rows as CAMERA_BAYER without the switch.
+            ret |= regWrite(GC2145_I2C_ADDR,
+                    REG_SYNC_MODE, REG_SYNC_MODE_DEF);
+            ret |= regWrite(GC2145_I2C_ADDR,
+                    REG_OUTPUT_FMT, REG_OUTPUT_SET_FMT(reg, REG_OUTPUT_FMT_BAYER));
+            break;
         default:
             return -1;
     }
@@ -925,6 +1003,12 @@ int GC2145::setPixelFormat(int32_t pixformat)
     return ret;
 }
 
+int32_t GC2145::getBusFormat(int32_t pixformat)
+{
+    // Grayscale frames are sent as raw Bayer, see setPixelFormat().
+    return (pixformat == CAMERA_GRAYSCALE) ? CAMERA_BAYER : pixformat;
+}
+
 int GC2145::regWrite(uint8_t dev_addr, uint16_t reg_addr, uint8_t reg_data, bool wide_addr)
 {
     _i2c->beginTransmission(dev_addr);
@@ -939,6 +1023,12 @@ int GC2145::regWrite(uint8_t dev_addr, uint16_t reg_addr, uint8_t reg_data, bool
 uint8_t GC2145::regRead(uint8_t dev_addr, uint16_t reg_addr, bool wide_addr)
 {
     uint8_t reg_data = 0;
+    regRead(dev_addr, reg_addr, &reg_data, wide_addr);
+    return reg_data;
+}
+
+int GC2145::regRead(uint8_t dev_addr, uint16_t reg_addr, uint8_t *reg_data, bool wide_addr)
+{
     uint8_t buf[2] = {(uint8_t) (reg_addr >> 8), (uint8_t) (reg_addr & 0xFF)};
     _i2c->beginTransmission(dev_addr);
     if (wide_addr) {
@@ -946,15 +1036,18 @@ uint8_t GC2145::regRead(uint8_t dev_addr, uint16_t reg_addr, bool wide_addr)
     } else {
         _i2c->write(&buf[1], 1);
     }
-    _i2c->endTransmission(false);
+    // The error codes are the positive ones passed on from Wire, or -1 if no data was received
+    int ret = _i2c->endTransmission(false);
     _i2c->requestFrom(dev_addr, 1);
     if (_i2c->available()) {
-        reg_data = _i2c->read();
+        *reg_data = _i2c->read();
+    } else if (ret == 0) {
+        ret = -1;
     }
     while (_i2c->available()) {
         _i2c->read();
     }
-    return reg_data;
+    return ret;
 }
 
 void GC2145::debug(Stream &stream)
@@ -343,12 +343,12 @@ int HM01B0::reset()
 
 int HM01B0::setVerticalFlip(bool flip_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
 }
 
 int HM01B0::setHorizontalMirror(bool mirror_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
 }
 
 uint8_t HM01B0::getPixelReadingCycle() 
@@ -358,7 +358,7 @@ uint8_t HM01B0::getPixelReadingCycle()
 
 int HM01B0::setResolution(int32_t resolution)
 {
-    setResolutionWithZoom(resolution, resolution, 0, 0);
+    return setResolutionWithZoom(resolution, resolution, 0, 0);
 }
 
 int HM01B0::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, uint32_t zoom_x, uint32_t zoom_y)
@@ -588,17 +588,17 @@ int HM0360::reset()
 
 int HM0360::setVerticalFlip(bool flip_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
 }
 
 int HM0360::setHorizontalMirror(bool mirror_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
 }
 
 int HM0360::setResolution(int32_t resolution)
 {
-    setResolutionWithZoom(resolution, resolution, 0, 0);
+    return setResolutionWithZoom(resolution, resolution, 0, 0);
 }
 
 int HM0360::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, uint32_t zoom_x, uint32_t zoom_y)
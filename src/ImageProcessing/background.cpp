@@ -0,0 +1,243 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Background subtraction.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "bin.h"
+#include "background.h"
+
+// Number of luma values of a row extracted at once, a multiple of 32 so that chunks start on a mask word
+#define BG_CHUNK                (64)
+
+int backgroundBegin(BackgroundModel &bg, uint32_t width, uint32_t height, uint32_t block,
+        uint32_t threshold, uint32_t shift)
+{
+    if ((block != 1 && block != 2) || width < block || height < block
+            || threshold > 255 || shift == 0 || shift > BG_SHIFT_MAX) {
+        return -1;
+    }
+
+    memset(&bg, 0, sizeof(bg));
+    bg.width = width / block;
+    bg.height = height / block;
+    bg.block = block;
+    bg.threshold = threshold;
+    bg.shift = shift;
+    bg.model = (uint16_t *) malloc(bg.width * bg.height * sizeof(uint16_t));
+    bg.mask = (uint32_t *) malloc(MASK_ROW_WORDS(bg.width) * bg.height * sizeof(uint32_t));
+    if (bg.model == NULL || bg.mask == NULL) {
+        backgroundEnd(bg);
+        return -1;
+    }
+    return 0;
+}
+
+void backgroundEnd(BackgroundModel &bg)
+{
+    free(bg.model);
+    free(bg.mask);
+    bg.model = NULL;
+    bg.mask = NULL;
+    bg.initialized = false;
+}
+
+void backgroundReset(BackgroundModel &bg)
+{
+    bg.initialized = false;
+    bg.changed = 0;
+}
+
+// Arithmetic shift of both signed halfwords of a word.
+static inline uint32_t bg_shift16(uint32_t v, uint32_t shift)
+{
+    return (((uint32_t) ((int32_t) v >> shift)) & 0xFFFF0000)
+         | (((uint32_t) ((int32_t) (v << 16) >> (16 + shift))) & 0xFFFF);
+}
+
+// Compare n luma values of a row to the background, set the foreground bits of the
+// mask row from x, and update the background.
+static void bg_update_row(const BackgroundModel &bg, uint16_t *model, const uint8_t *luma,
+        uint32_t *mask, uint32_t x, uint32_t n, bool fast)
+{
+    int32_t threshold = bg.threshold << BG_FRAC_BITS;
+    uint32_t i = 0;
+
+    if (!bg.initialized) {
+        for (; i < n; i++) {
+            model[i] = luma[i] << BG_FRAC_BITS;
+        }
+        return;
+    }
+
+    #if IMG_USE_DSP
+    if (fast) {
+        uint32_t thr0 = threshold * 0x00010001;
+        uint32_t thr1 = (threshold + 1) * 0x00010001;
+        for (; i + 4 <= n; i += 4) {
+            uint32_t w = img_read32(luma + i);
+            uint32_t even = __UXTB16(w);
+            uint32_t odd = __UXTB16(__ROR(w, 8));
+            // Pixels 0 and 1, 2 and 3, in the order of the background
+            uint32_t v01 = __PKHBT(even, odd, 16) << BG_FRAC_BITS;
+            uint32_t v23 = __PKHTB(odd, even, 16) << BG_FRAC_BITS;
+            uint32_t m01 = img_read32(model + i);
+            uint32_t m23 = img_read32(model + i + 2);
+            uint32_t d01 = __SSUB16(v01, m01);
+            uint32_t d23 = __SSUB16(v23, m23);
+            // The sign bits are set if d > threshold or d < -threshold
+            uint32_t f01 = (~__QSUB16(d01, thr1) | __QADD16(d01, thr0)) & 0x80008000;
+            uint32_t f23 = (~__QSUB16(d23, thr1) | __QADD16(d23, thr0)) & 0x80008000;
+            uint32_t bits = ((f01 >> 15) & 1) | ((f01 >> 30) & 2) | ((f23 >> 13) & 4) | ((f23 >> 28) & 8);
+            mask[(x + i) / 32] |= bits << ((x + i) % 32);
+            img_write32(model + i, __SADD16(m01, bg_shift16(d01, bg.shift)));
+            img_write32(model + i + 2, __SADD16(m23, bg_shift16(d23, bg.shift)));
+        }
+    }
+    #endif
+
+    for (; i < n; i++) {
+        int32_t diff = (luma[i] << BG_FRAC_BITS) - model[i];
+        if (diff > threshold || diff < -threshold) {
+            mask[(x + i) / 32] |= 1u << ((x + i) % 32);
+        }
+        model[i] += diff >> bg.shift;
+    }
+}
+
+// Extract the luma of a pixel of the formats other than grayscale.
+template <typename PixelFormat>
+static inline uint32_t bg_luma(const typename PixelFormat::pixel_t *row, uint32_t x)
+{
+    if (PixelFormat::format == CAMERA_GRAYSCALE) {
+        return ((const uint8_t *) row)[x];
+    }
+    if (PixelFormat::format == CAMERA_YUV422) {
+        return ((const uint8_t *) row)[2 * x];
+    }
+    int32_t r, g, b;
+    rgb565_unpack(rgb565_load<PixelFormat>(row, x), &r, &g, &b);
+    return rgb_to_luma(r, g, b);
+}
+
+// Extract n luma values of the row y of the model from x, the 2x2 blocks are averaged
+// the same way as binImage().
+template <typename PixelFormat>
+static void bg_load(const BackgroundModel &bg, const ImageView<PixelFormat> &frame,
+        uint32_t x, uint32_t y, uint32_t n, uint8_t *luma, bool fast)
+{
+    if (bg.block == 1) {
+        const typename PixelFormat::pixel_t *row = frame.row(y);
+        for (uint32_t i = 0; i < n; i++) {
+            luma[i] = bg_luma<PixelFormat>(row, x + i);
+        }
+        return;
+    }
+
+    if (PixelFormat::format == CAMERA_GRAYSCALE) {
+        ImageView<PixelGrayscale> src((uint8_t *) frame.row(2 * y) + 2 * x, 2 * n, 2, frame.getStride());
+        ImageView<PixelGrayscale> dst(luma, n, 1);
+        if (fast) {
+            binImage(src, dst, 2);
+        } else {
+            binImageReference(src, dst, 2);
+        }
+        return;
+    }
+
+    const typename PixelFormat::pixel_t *row0 = frame.row(2 * y);
+    const typename PixelFormat::pixel_t *row1 = frame.row(2 * y + 1);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t sx = 2 * (x + i);
+        uint32_t c0 = (bg_luma<PixelFormat>(row0, sx) + bg_luma<PixelFormat>(row1, sx)) >> 1;
+        uint32_t c1 = (bg_luma<PixelFormat>(row0, sx + 1) + bg_luma<PixelFormat>(row1, sx + 1)) >> 1;
+        luma[i] = (c0 + c1) >> 1;
+    }
+}
+
+template <typename PixelFormat>
+static int bg_update(BackgroundModel &bg, const ImageView<PixelFormat> &frame, bool fast)
+{
+    if (!frame.isValid() || bg.model == NULL
+            || frame.getWidth() / bg.block != bg.width || frame.getHeight() / bg.block != bg.height) {
+        return -1;
+    }
+
+    uint32_t words = MASK_ROW_WORDS(bg.width);
+    memset(bg.mask, 0, words * bg.height * sizeof(uint32_t));
+
+    for (uint32_t y = 0; y < bg.height; y++) {
+        uint16_t *model = bg.model + y * bg.width;
+        uint32_t *mask = bg.mask + y * words;
+        for (uint32_t x = 0; x < bg.width; x += BG_CHUNK) {
+            uint32_t n = (bg.width - x < BG_CHUNK) ? bg.width - x : BG_CHUNK;
+            uint8_t buf[BG_CHUNK];
+            const uint8_t *luma = buf;
+            if (PixelFormat::format == CAMERA_GRAYSCALE && bg.block == 1) {
+                luma = (const uint8_t *) frame.row(y) + x;
+            } else {
+                bg_load(bg, frame, x, y, n, buf, fast);
+            }
+            bg_update_row(bg, model + x, luma, mask, x, n, fast);
+        }
+    }
+
+    bg.changed = maskCount(bg.mask, bg.width, bg.height);
+    bg.initialized = true;
+    return 0;
+}
+
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelGrayscale> &frame)
+{
+    return bg_update(bg, frame, true);
+}
+
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelYUV422> &frame)
+{
+    return bg_update(bg, frame, true);
+}
+
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelRGB565> &frame)
+{
+    return bg_update(bg, frame, true);
+}
+
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelRGB565LE> &frame)
+{
+    return bg_update(bg, frame, true);
+}
+
+int backgroundUpdateReference(BackgroundModel &bg, const ImageView<PixelGrayscale> &frame)
+{
+    return bg_update(bg, frame, false);
+}
+
+int frameBackground(FrameBuffer &fb, BackgroundModel &bg)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return bg_update(bg, ImageView<PixelGrayscale>(fb), true);
+        case CAMERA_YUV422:
+            return bg_update(bg, ImageView<PixelYUV422>(fb), true);
+        case CAMERA_RGB565:
+            return bg_update(bg, ImageView<PixelRGB565>(fb), true);
+        case CAMERA_RGB565_LE:
+            return bg_update(bg, ImageView<PixelRGB565LE>(fb), true);
+        default:
+            return -1;
+    }
+}
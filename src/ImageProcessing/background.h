@@ -0,0 +1,153 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Background subtraction.
+ */
+
+/**
+ * @file background.h
+ * @brief Running average background model and foreground mask.
+ *
+ * The background is the exponential running average of the luma of every pixel, or of every
+ * 2x2 block of pixels, in fixed point. Every frame, the pixels that differ from the background
+ * by more than the threshold are set in a bit-packed foreground mask (see mask.h) and counted,
+ * then the background moves towards the frame by 1 / 2^shift of the difference:
+ * @code {.cpp}
+ * BackgroundModel bg;
+ * backgroundBegin(bg, 320, 240, 2);
+ * while (cam.grabFrame(fb, 3000) == 0) {
+ *     if (frameBackground(fb, bg) == 0 && bg.changed > 100) {
+ *         // Worth sending or running the inference on
+ *     }
+ * }
+ * @endcode
+ * The model takes 2 bytes per pixel or block, allocated by backgroundBegin().
+ *
+ * Pairs of pixels are compared and updated at once with the 16-bit SIMD instructions.
+ */
+
+#ifndef __BACKGROUND_H
+#define __BACKGROUND_H
+
+#include "imageview.h"
+#include "mask.h"
+
+/// Number of fractional bits of the background values
+#define BG_FRAC_BITS            (7)
+/// Default threshold, in luma levels
+#define BG_THRESHOLD_DEFAULT    (24)
+/// Default update shift, the background follows the frames with a weight of 1/16
+#define BG_SHIFT_DEFAULT        (4)
+/// Maximum update shift
+#define BG_SHIFT_MAX            (8)
+
+/**
+ * @struct BackgroundModel
+ * @brief State of the background subtraction.
+ */
+struct BackgroundModel {
+    uint16_t *model;            /// Background of every pixel or block, row by row, with BG_FRAC_BITS fractional bits
+    uint32_t *mask;             /// Foreground mask of the last frame, MASK_ROW_WORDS(width) words per row
+    uint32_t width;             /// Width of the model, the width of the frames divided by the block size
+    uint32_t height;            /// Height of the model, the height of the frames divided by the block size
+    uint32_t block;             /// Block size, 1 or 2
+    uint32_t threshold;         /// Difference to the background of the foreground pixels, in luma levels
+    uint32_t shift;             /// The background moves by 1 / 2^shift of the difference every frame
+    uint32_t changed;           /// Number of foreground pixels or blocks of the last frame
+    bool initialized;           /// The background was set from a frame
+};
+
+/**
+ * @brief Allocate the background model and the foreground mask.
+ *
+ * @param bg The background model
+ * @param width The width of the frames
+ * @param height The height of the frames
+ * @param block The block size: 1 for a background per pixel, 2 per 2x2 block (default: 1)
+ * @param threshold The threshold in luma levels (default: BG_THRESHOLD_DEFAULT)
+ * @param shift The update shift, from 1 to BG_SHIFT_MAX (default: BG_SHIFT_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int backgroundBegin(BackgroundModel &bg, uint32_t width, uint32_t height, uint32_t block=1,
+        uint32_t threshold=BG_THRESHOLD_DEFAULT, uint32_t shift=BG_SHIFT_DEFAULT);
+
+/**
+ * @brief Free the background model and the foreground mask.
+ *
+ * @param bg The background model
+ */
+void backgroundEnd(BackgroundModel &bg);
+
+/**
+ * @brief Reset the background, the next frame becomes the new background.
+ *
+ * @param bg The background model
+ */
+void backgroundReset(BackgroundModel &bg);
+
+/**
+ * @brief Extract the foreground of a grayscale frame and update the background.
+ * The first frame after backgroundBegin() or backgroundReset() only sets the background.
+ *
+ * @param bg The background model
+ * @param frame The frame, of the size given to backgroundBegin()
+ * @return int 0 on success, -1 on failure
+ */
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelGrayscale> &frame);
+
+/**
+ * @brief Extract the foreground of the luma of a YUV422 frame and update the background.
+ *
+ * @param bg The background model
+ * @param frame The frame, of the size given to backgroundBegin()
+ * @return int 0 on success, -1 on failure
+ */
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelYUV422> &frame);
+
+/**
+ * @brief Extract the foreground of the luma of a big-endian RGB565 frame and update the background.
+ *
+ * @param bg The background model
+ * @param frame The frame, of the size given to backgroundBegin()
+ * @return int 0 on success, -1 on failure
+ */
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelRGB565> &frame);
+
+/**
+ * @brief Extract the foreground of the luma of a little-endian RGB565 frame and update the background.
+ *
+ * @param bg The background model
+ * @param frame The frame, of the size given to backgroundBegin()
+ * @return int 0 on success, -1 on failure
+ */
+int backgroundUpdate(BackgroundModel &bg, const ImageView<PixelRGB565LE> &frame);
+
+/**
+ * @brief Extract the foreground of the grayscale, YUV422 or RGB565 frame stored in a frame buffer.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param bg The background model
+ * @return int 0 on success, -1 on failure
+ */
+int frameBackground(FrameBuffer &fb, BackgroundModel &bg);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int backgroundUpdateReference(BackgroundModel &bg, const ImageView<PixelGrayscale> &frame);
+
+#endif /* __BACKGROUND_H */
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Bayer demosaic kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "bayer.h"
+
+// Position of the red sample in the 2x2 Bayer cell, indexed by the Bayer phase.
+// The blue sample is on the opposite corner, the green samples on the other two.
+static const uint8_t bayer_red_x[] = { 0, 1, 0, 1, 0 };
+static const uint8_t bayer_red_y[] = { 0, 1, 1, 0, 0 };
+
+// Bayer sample sites
+enum {
+    SITE_RED            = 0,
+    SITE_GREEN_RED_ROW  = 1,
+    SITE_GREEN_BLUE_ROW = 2,
+    SITE_BLUE           = 3,
+};
+
+// Interpolate the missing colors of the pixel at x, with its left and right neighbours at xl and xr.
+template <typename Dst>
+static inline void bayer_pixel_bilinear(const uint8_t *n, const uint8_t *c, const uint8_t *s,
+        uint32_t xl, uint32_t x, uint32_t xr, uint32_t site, typename Dst::pixel_t *d)
+{
+    switch (site) {
+        case SITE_RED:
+            PixelWriter<Dst>::write(d, x, c[x],
+                    (c[xl] + c[xr] + n[x] + s[x] + 2) >> 2,
+                    (n[xl] + n[xr] + s[xl] + s[xr] + 2) >> 2);
+            break;
+        case SITE_GREEN_RED_ROW:
+            PixelWriter<Dst>::write(d, x, (c[xl] + c[xr] + 1) >> 1, c[x], (n[x] + s[x] + 1) >> 1);
+            break;
+        case SITE_GREEN_BLUE_ROW:
+            PixelWriter<Dst>::write(d, x, (n[x] + s[x] + 1) >> 1, c[x], (c[xl] + c[xr] + 1) >> 1);
+            break;
+        default:
+            PixelWriter<Dst>::write(d, x,
+                    (n[xl] + n[xr] + s[xl] + s[xr] + 2) >> 2,
+                    (c[xl] + c[xr] + n[x] + s[x] + 2) >> 2, c[x]);
+            break;
+    }
+}
+
+// Demosaic a row with bilinear interpolation, two pixels at a time.
+// n, c and s are the rows above, at and below the current row, mirrored at the borders.
+template <typename Dst>
+static void bayer_row_bilinear(const uint8_t *n, const uint8_t *c, const uint8_t *s,
+        uint32_t width, bool red_row, uint32_t red_x, typename Dst::pixel_t *d)
+{
+    uint32_t red_site = red_row ? SITE_RED : SITE_GREEN_BLUE_ROW;
+    uint32_t other_site = red_row ? SITE_GREEN_RED_ROW : SITE_BLUE;
+    uint32_t site0 = red_x ? other_site : red_site;
+    uint32_t site1 = red_x ? red_site : other_site;
+
+    for (uint32_t x = 0; x < width; x += 2) {
+        uint32_t xl = (x == 0) ? 1 : x - 1;
+        uint32_t xr = (x + 2 == width) ? width - 2 : x + 2;
+        bayer_pixel_bilinear<Dst>(n, c, s, xl, x + 0, x + 1, site0, d);
+        bayer_pixel_bilinear<Dst>(n, c, s, x, x + 1, xr, site1, d);
+    }
+}
+
+// Demosaic a row with the colors of the 2x2 Bayer cells.
+// r0 and r1 are the rows of the cells, c is the row the pixels are taken from.
+template <typename Dst>
+static void bayer_row_nearest(const uint8_t *r0, const uint8_t *r1, const uint8_t *c,
+        uint32_t width, uint32_t red_x, uint32_t red_y, typename Dst::pixel_t *d)
+{
+    const uint8_t *red = red_y ? r1 : r0;
+    const uint8_t *blue = red_y ? r0 : r1;
+
+    for (uint32_t x = 0; x < width; x += 2) {
+        int32_t r = red[x + red_x];
+        int32_t b = blue[x + (red_x ^ 1)];
+        // Every row of a cell has a single green sample, shared by both pixels
+        int32_t g = c[x + ((c == red) ? (red_x ^ 1) : red_x)];
+        PixelWriter<Dst>::write(d, x + 0, r, g, b);
+        PixelWriter<Dst>::write(d, x + 1, r, g, b);
+    }
+}
+
+// Demosaic a row of 2x2 Bayer cells to a row of pixels of half the width.
+template <typename Dst>
+static void bayer_row_half(const uint8_t *r0, const uint8_t *r1,
+        uint32_t width, uint32_t red_x, uint32_t red_y, typename Dst::pixel_t *d)
+{
+    const uint8_t *red = red_y ? r1 : r0;
+    const uint8_t *blue = red_y ? r0 : r1;
+
+    for (uint32_t x = 0; x < width; x += 2) {
+        int32_t r = red[x + red_x];
+        int32_t b = blue[x + (red_x ^ 1)];
+        int32_t g = (red[x + (red_x ^ 1)] + blue[x + red_x] + 1) >> 1;
+        PixelWriter<Dst>::write(d, x / 2, r, g, b);
+    }
+}
+
+// Convert a row to luma, every pixel is the weighted sum of the 2x2 window starting at that pixel.
+// w holds the weights of the windows starting on even columns, in the order top-left, top-right,
+// bottom-left, bottom-right. The windows starting on odd columns have the left and right weights
+// swapped. The last column is mirrored, its window holds the same samples as the one before it.
+// Every sample is read before the pixel at its position is written, so d can be the same as t.
+static void bayer_row_luma(const uint8_t *t, const uint8_t *b, uint32_t width, const int32_t *w, uint8_t *d)
+{
+    int32_t t0 = t[0];
+    int32_t b0 = b[0];
+    uint32_t x = 0;
+
+    for (; x + 2 < width; x += 2) {
+        int32_t t1 = t[x + 1], t2 = t[x + 2];
+        int32_t b1 = b[x + 1], b2 = b[x + 2];
+        d[x + 0] = (w[0] * t0 + w[1] * t1 + w[2] * b0 + w[3] * b1 + 128) >> 8;
+        d[x + 1] = (w[1] * t1 + w[0] * t2 + w[3] * b1 + w[2] * b2 + 128) >> 8;
+        t0 = t2;
+        b0 = b2;
+    }
+
+    int32_t t1 = t[x + 1];
+    int32_t b1 = b[x + 1];
+    d[x + 0] = (w[0] * t0 + w[1] * t1 + w[2] * b0 + w[3] * b1 + 128) >> 8;
+    d[x + 1] = d[x + 0];
+}
+
+template <typename Dst>
+static int bayer_demosaic(const ImageView<PixelBayer> &src, const ImageView<Dst> &dst,
+        int32_t pixformat, int32_t method, uint32_t y, uint32_t h)
+{
+    uint32_t width = src.getWidth();
+    uint32_t height = src.getHeight();
+    uint32_t scale = (method == DEMOSAIC_HALF) ? 2 : 1;
+
+    if (!src.isValid() || !dst.isValid() || (width % 2) || (height % 2)
+            || method < 0 || method >= DEMOSAIC_MAX
+            || pixformat < 0 || pixformat >= CAMERA_PMAX
+            || pixtab[pixformat].bayer_phase == CAMERA_PHASE_NONE
+            || dst.getWidth() != width / scale || dst.getHeight() != height / scale) {
+        return -1;
+    }
+
+    if (y >= dst.getHeight()) {
+        return -1;
+    }
+    if (h == 0) {
+        h = dst.getHeight() - y;
+    }
+    if (h > dst.getHeight() - y) {
+        return -1;
+    }
+
+    uint32_t red_x = bayer_red_x[pixtab[pixformat].bayer_phase];
+    uint32_t red_y = bayer_red_y[pixtab[pixformat].bayer_phase];
+
+    for (uint32_t row = y; row < y + h; row++) {
+        typename Dst::pixel_t *d = dst.row(row);
+        if (method == DEMOSAIC_HALF) {
+            bayer_row_half<Dst>(src.row(row * 2), src.row(row * 2 + 1), width, red_x, red_y, d);
+        } else if (method == DEMOSAIC_NEAREST) {
+            uint32_t cell = row & ~1;
+            bayer_row_nearest<Dst>(src.row(cell), src.row(cell + 1), src.row(row), width, red_x, red_y, d);
+        } else {
+            const uint8_t *n = src.row((row == 0) ? 1 : row - 1);
+            const uint8_t *s = src.row((row == height - 1) ? height - 2 : row + 1);
+            bayer_row_bilinear<Dst>(n, src.row(row), s, width, (row & 1) == red_y, red_x, d);
+        }
+    }
+    return 0;
+}
+
+int bayerToGrayscale(const ImageView<PixelBayer> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t pixformat, int32_t method, uint32_t y, uint32_t h)
+{
+    return bayer_demosaic(src, dst, pixformat, method, y, h);
+}
+
+int bayerToRGB565(const ImageView<PixelBayer> &src, const ImageView<PixelRGB565> &dst,
+        int32_t pixformat, int32_t method, uint32_t y, uint32_t h)
+{
+    return bayer_demosaic(src, dst, pixformat, method, y, h);
+}
+
+int bayerToRGB565(const ImageView<PixelBayer> &src, const ImageView<PixelRGB565LE> &dst,
+        int32_t pixformat, int32_t method, uint32_t y, uint32_t h)
+{
+    return bayer_demosaic(src, dst, pixformat, method, y, h);
+}
+
+int bayerToRGB888(const ImageView<PixelBayer> &src, const ImageView<PixelRGB888> &dst,
+        int32_t pixformat, int32_t method, uint32_t y, uint32_t h)
+{
+    return bayer_demosaic(src, dst, pixformat, method, y, h);
+}
+
+int bayerToLuma(const ImageView<PixelBayer> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t pixformat, uint32_t y, uint32_t h)
+{
+    uint32_t width = src.getWidth();
+    uint32_t height = src.getHeight();
+
+    if (!src.isValid() || !dst.isValid() || (width % 2) || (height % 2)
+            || pixformat < 0 || pixformat >= CAMERA_PMAX
+            || pixtab[pixformat].bayer_phase == CAMERA_PHASE_NONE
+            || dst.getWidth() != width || dst.getHeight() != height) {
+        return -1;
+    }
+
+    if (y >= height) {
+        return -1;
+    }
+    if (h == 0) {
+        h = height - y;
+    }
+    if (h > height - y) {
+        return -1;
+    }
+
+    // Weights of the windows starting on even columns, for even and odd rows.
+    // The two green samples share the green weight.
+    uint32_t red_x = bayer_red_x[pixtab[pixformat].bayer_phase];
+    uint32_t red_y = bayer_red_y[pixtab[pixformat].bayer_phase];
+    int32_t w[2][4];
+    for (uint32_t py = 0; py < 2; py++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            uint32_t sx = i & 1;
+            uint32_t sy = py ^ (i >> 1);
+            if (sx == red_x && sy == red_y) {
+                w[py][i] = LUMA_R;
+            } else if (sx != red_x && sy != red_y) {
+                w[py][i] = LUMA_B;
+            } else {
+                w[py][i] = LUMA_G / 2;
+            }
+        }
+    }
+
+    // The last row is mirrored, its windows hold the same samples as the row before it.
+    uint32_t last = (y + h == height) ? height - 1 : y + h;
+    for (uint32_t row = y; row < last; row++) {
+        bayer_row_luma(src.row(row), src.row(row + 1), width, w[row & 1], dst.row(row));
+    }
+    if (last == height - 1) {
+        memcpy(dst.row(last), dst.row(last - 1), width);
+    }
+    return 0;
+}
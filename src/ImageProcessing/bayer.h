@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Bayer demosaic kernels.
+ */
+
+/**
+ * @file bayer.h
+ * @brief Bayer demosaic kernels.
+ *
+ * Raw Bayer frames are half the size of RGB565 frames on the bus, and only the frames
+ * (or parts of frames) that are needed in color have to be demosaiced. The kernels can
+ * process a whole frame at once, or a band of rows at a time, e.g. while the next band
+ * is still being captured:
+ * @code {.cpp}
+ * ImageView<PixelBayer> raw(fb);
+ * ImageView<PixelRGB565> rgb(buffer, raw.getWidth(), raw.getHeight());
+ * for (uint32_t y = 0; y < rgb.getHeight(); y += 16) {
+ *     bayerToRGB565(raw, rgb, fb.getPixelFormat(), DEMOSAIC_BILINEAR, y, 16);
+ * }
+ * @endcode
+ * A band reads the source rows of the 2x2 Bayer cells it covers, plus one row above and
+ * one row below for DEMOSAIC_BILINEAR. The borders of the image are mirrored.
+ *
+ * When only the brightness is needed, bayerToLuma() is the cheapest way to get a full
+ * resolution grayscale image, and it can convert a frame in place.
+ *
+ * All kernels return 0 on success and -1 if the sizes, the Bayer format or the band are invalid.
+ */
+
+#ifndef __BAYER_H
+#define __BAYER_H
+
+#include "imageview.h"
+
+/// Demosaic method enumeration
+enum {
+    DEMOSAIC_NEAREST    = 0,    /* Every pixel takes the colors of its 2x2 Bayer cell                      */
+    DEMOSAIC_BILINEAR   = 1,    /* Every missing color is interpolated from its 3x3 neighbourhood          */
+    DEMOSAIC_HALF       = 2,    /* Every 2x2 Bayer cell gives one pixel, the output is half the size       */
+    DEMOSAIC_MAX                /* Sentinel value */
+};
+
+/**
+ * @brief Demosaic a Bayer image to grayscale.
+ *
+ * @param src The Bayer source image, its width and height must be even
+ * @param dst The grayscale destination image, of the same size, or half the size for DEMOSAIC_HALF
+ * @param pixformat The Bayer format of the source, e.g. CAMERA_BAYER or FrameBuffer::getPixelFormat()
+ * @param method The demosaic method, as defined in the demosaic method enum (default: DEMOSAIC_BILINEAR)
+ * @param y The first destination row of the band (default: 0)
+ * @param h The number of destination rows of the band (default: 0, up to the last row)
+ * @return int 0 on success, -1 on failure
+ */
+int bayerToGrayscale(const ImageView<PixelBayer> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t pixformat=CAMERA_BAYER, int32_t method=DEMOSAIC_BILINEAR, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Demosaic a Bayer image to big-endian RGB565.
+ *
+ * @param src The Bayer source image, its width and height must be even
+ * @param dst The RGB565 destination image, of the same size, or half the size for DEMOSAIC_HALF
+ * @param pixformat The Bayer format of the source, e.g. CAMERA_BAYER or FrameBuffer::getPixelFormat()
+ * @param method The demosaic method, as defined in the demosaic method enum (default: DEMOSAIC_BILINEAR)
+ * @param y The first destination row of the band (default: 0)
+ * @param h The number of destination rows of the band (default: 0, up to the last row)
+ * @return int 0 on success, -1 on failure
+ */
+int bayerToRGB565(const ImageView<PixelBayer> &src, const ImageView<PixelRGB565> &dst,
+        int32_t pixformat=CAMERA_BAYER, int32_t method=DEMOSAIC_BILINEAR, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Demosaic a Bayer image to little-endian RGB565.
+ *
+ * @param src The Bayer source image, its width and height must be even
+ * @param dst The RGB565 destination image, of the same size, or half the size for DEMOSAIC_HALF
+ * @param pixformat The Bayer format of the source, e.g. CAMERA_BAYER or FrameBuffer::getPixelFormat()
+ * @param method The demosaic method, as defined in the demosaic method enum (default: DEMOSAIC_BILINEAR)
+ * @param y The first destination row of the band (default: 0)
+ * @param h The number of destination rows of the band (default: 0, up to the last row)
+ * @return int 0 on success, -1 on failure
+ */
+int bayerToRGB565(const ImageView<PixelBayer> &src, const ImageView<PixelRGB565LE> &dst,
+        int32_t pixformat=CAMERA_BAYER, int32_t method=DEMOSAIC_BILINEAR, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Demosaic a Bayer image to RGB888.
+ *
+ * @param src The Bayer source image, its width and height must be even
+ * @param dst The RGB888 destination image, of the same size, or half the size for DEMOSAIC_HALF
+ * @param pixformat The Bayer format of the source, e.g. CAMERA_BAYER or FrameBuffer::getPixelFormat()
+ * @param method The demosaic method, as defined in the demosaic method enum (default: DEMOSAIC_BILINEAR)
+ * @param y The first destination row of the band (default: 0)
+ * @param h The number of destination rows of the band (default: 0, up to the last row)
+ * @return int 0 on success, -1 on failure
+ */
+int bayerToRGB888(const ImageView<PixelBayer> &src, const ImageView<PixelRGB888> &dst,
+        int32_t pixformat=CAMERA_BAYER, int32_t method=DEMOSAIC_BILINEAR, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Convert a Bayer image to full resolution grayscale, without demosaicing it.
+ * Every pixel is the BT.601 luma of the 2x2 Bayer cell starting at that pixel, which always
+ * holds one red, two green and one blue sample. This is much cheaper than a demosaic followed
+ * by an RGB to grayscale conversion. The destination can be the same view as the source,
+ * the image is then converted in place. Bands must be converted from top to bottom in that case.
+ *
+ * @param src The Bayer source image, its width and height must be even
+ * @param dst The grayscale destination image, of the same size
+ * @param pixformat The Bayer format of the source, e.g. CAMERA_BAYER or FrameBuffer::getPixelFormat()
+ * @param y The first row of the band (default: 0)
+ * @param h The number of rows of the band (default: 0, up to the last row)
+ * @return int 0 on success, -1 on failure
+ */
+int bayerToLuma(const ImageView<PixelBayer> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t pixformat=CAMERA_BAYER, uint32_t y=0, uint32_t h=0);
+
+#endif /* __BAYER_H */
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image binning kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "bin.h"
+
+// Halving addition of two RGB565 pixels, per channel. The least significant bit of every
+// channel is masked out of the difference, so that it doesn't shift into the channel below.
+// It also averages the two pixels packed in a word at once.
+#define RGB565_AVG_MASK         (0xF7DEF7DE)
+
+static inline uint32_t rgb565_avg(uint32_t a, uint32_t b)
+{
+    return (a & b) + (((a ^ b) & RGB565_AVG_MASK) >> 1);
+}
+
+/*
+ * Loads, stores and averages pixels as native values, RGB565 pixels in the CPU byte order.
+ */
+template <typename PixelFormat>
+static inline uint32_t bin_load(const typename PixelFormat::pixel_t *row, uint32_t x)
+{
+    if (PixelFormat::format == CAMERA_GRAYSCALE) {
+        return row[x];
+    }
+    return rgb565_load<PixelFormat>(row, x);
+}
+
+template <typename PixelFormat>
+static inline void bin_store(typename PixelFormat::pixel_t *row, uint32_t x, uint32_t v)
+{
+    if (PixelFormat::format == CAMERA_GRAYSCALE) {
+        row[x] = v;
+        return;
+    }
+    uint8_t *p = (uint8_t *) (row + x);
+    if (PixelFormat::format == CAMERA_RGB565_LE) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    } else {
+        p[0] = v >> 8;
+        p[1] = v & 0xFF;
+    }
+}
+
+template <typename PixelFormat>
+static inline uint32_t bin_avg(uint32_t a, uint32_t b)
+{
+    return (PixelFormat::format == CAMERA_GRAYSCALE) ? (a + b) >> 1 : rgb565_avg(a, b);
+}
+
+// Average of the rows of a column of a block.
+template <typename PixelFormat>
+static inline uint32_t bin_column(typename PixelFormat::pixel_t *const *rows, uint32_t x, uint32_t factor)
+{
+    uint32_t v = bin_avg<PixelFormat>(bin_load<PixelFormat>(rows[0], x), bin_load<PixelFormat>(rows[1], x));
+    if (factor == 4) {
+        v = bin_avg<PixelFormat>(v,
+                bin_avg<PixelFormat>(bin_load<PixelFormat>(rows[2], x), bin_load<PixelFormat>(rows[3], x)));
+    }
+    return v;
+}
+
+// Average of a block, the destination pixel x.
+template <typename PixelFormat>
+static inline uint32_t bin_pixel(typename PixelFormat::pixel_t *const *rows, uint32_t x, uint32_t factor)
+{
+    uint32_t sx = x * factor;
+    uint32_t v = bin_avg<PixelFormat>(bin_column<PixelFormat>(rows, sx + 0, factor),
+            bin_column<PixelFormat>(rows, sx + 1, factor));
+    if (factor == 4) {
+        v = bin_avg<PixelFormat>(v, bin_avg<PixelFormat>(bin_column<PixelFormat>(rows, sx + 2, factor),
+                    bin_column<PixelFormat>(rows, sx + 3, factor)));
+    }
+    return v;
+}
+
+#if IMG_USE_DSP
+// Bin the start of a grayscale row, 4 destination pixels per iteration.
+// Returns the number of destination pixels written.
+static uint32_t bin_row_dsp(uint8_t *const *rows, uint8_t *d, uint32_t width, uint32_t factor)
+{
+    uint32_t x = 0;
+    if (factor == 2) {
+        for (; x + 4 <= width; x += 4) {
+            const uint8_t *s0 = rows[0] + 2 * x;
+            const uint8_t *s1 = rows[1] + 2 * x;
+            uint32_t v0 = __UHADD8(img_read32(s0 + 0), img_read32(s1 + 0));
+            uint32_t v1 = __UHADD8(img_read32(s0 + 4), img_read32(s1 + 4));
+            // Bytes 0 and 2 are the averages of the column pairs
+            v0 = __UXTB16(__UHADD8(v0, v0 >> 8));
+            v1 = __UXTB16(__UHADD8(v1, v1 >> 8));
+            img_write32(d + x, __PKHBT(v0 | (v0 >> 8), v1 | (v1 >> 8), 16));
+        }
+    } else {
+        for (; x + 4 <= width; x += 4) {
+            uint32_t out = 0;
+            for (uint32_t i = 0; i < 4; i++) {
+                uint32_t o = 4 * (x + i);
+                uint32_t v = __UHADD8(__UHADD8(img_read32(rows[0] + o), img_read32(rows[1] + o)),
+                        __UHADD8(img_read32(rows[2] + o), img_read32(rows[3] + o)));
+                v = __UHADD8(v, v >> 8);
+                v = __UHADD8(v, v >> 16);
+                out |= (v & 0xFF) << (8 * i);
+            }
+            img_write32(d + x, out);
+        }
+    }
+    return x;
+}
+
+// Average of the rows of a block, for the 2 RGB565 pixels of the word at column x.
+static inline uint32_t rgb565_column_dsp(uint16_t *const *rows, uint32_t x, uint32_t factor, bool swap)
+{
+    uint32_t v = 0;
+    for (uint32_t r = 0; r < factor; r += 2) {
+        uint32_t a = img_read32(rows[r] + x);
+        uint32_t b = img_read32(rows[r + 1] + x);
+        if (swap) {
+            a = __REV16(a);
+            b = __REV16(b);
+        }
+        v = r ? rgb565_avg(v, rgb565_avg(a, b)) : rgb565_avg(a, b);
+    }
+    return v;
+}
+
+// Bin the start of an RGB565 row, 2 destination pixels per iteration. The pixels are
+// converted to the CPU byte order if needed. Returns the number of destination pixels written.
+static uint32_t bin_row_dsp(uint16_t *const *rows, uint16_t *d, uint32_t width, uint32_t factor, bool swap)
+{
+    uint32_t x = 0;
+    for (; x + 2 <= width; x += 2) {
+        uint32_t o = x * factor;
+        uint32_t out;
+        if (factor == 2) {
+            uint32_t va = rgb565_column_dsp(rows, o + 0, factor, swap);
+            uint32_t vb = rgb565_column_dsp(rows, o + 2, factor, swap);
+            // Average the first and second columns of both blocks at once
+            out = rgb565_avg(__PKHBT(va, vb, 16), __PKHTB(vb, va, 16));
+        } else {
+            uint32_t p[2];
+            for (uint32_t i = 0; i < 2; i++, o += 4) {
+                uint32_t va = rgb565_column_dsp(rows, o + 0, factor, swap);
+                uint32_t vb = rgb565_column_dsp(rows, o + 2, factor, swap);
+                uint32_t v = rgb565_avg(__PKHBT(va, vb, 16), __PKHTB(vb, va, 16));
+                p[i] = rgb565_avg(v & 0xFFFF, v >> 16);
+            }
+            out = p[0] | (p[1] << 16);
+        }
+        img_write32(d + x, swap ? __REV16(out) : out);
+    }
+    return x;
+}
+#endif
+
+template <typename PixelFormat>
+static int bin_image(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst,
+        uint32_t factor, uint32_t y, uint32_t h, bool fast)
+{
+    typedef typename PixelFormat::pixel_t pixel_t;
+
+    if ((factor != 2 && factor != 4) || !src.isValid() || !dst.isValid()
+            || dst.getWidth() != src.getWidth() / factor || dst.getHeight() != src.getHeight() / factor
+            || y > src.getHeight()) {
+        return -1;
+    }
+    // In place only from the same first pixel, the destination rows must not get ahead of the source rows.
+    if (src.getData() == dst.getData() && dst.getStride() > src.getStride()) {
+        return -1;
+    }
+    if (h == 0) {
+        h = (src.getHeight() - y) / factor * factor;
+    }
+    if ((y % factor) || (h % factor) || h > src.getHeight() - y) {
+        return -1;
+    }
+
+    uint32_t width = dst.getWidth();
+    for (uint32_t sy = y; sy < y + h; sy += factor) {
+        pixel_t *rows[4];
+        for (uint32_t i = 0; i < factor; i++) {
+            rows[i] = src.row(sy + i);
+        }
+        pixel_t *d = dst.row(sy / factor);
+        uint32_t x = 0;
+
+        #if IMG_USE_DSP
+        if (fast) {
+            if (PixelFormat::format == CAMERA_GRAYSCALE) {
+                x = bin_row_dsp((uint8_t *const *) rows, (uint8_t *) d, width, factor);
+            } else {
+                x = bin_row_dsp((uint16_t *const *) rows, (uint16_t *) d, width, factor,
+                        PixelFormat::format == CAMERA_RGB565);
+            }
+        }
+        #endif
+
+        for (; x < width; x++) {
+            bin_store<PixelFormat>(d, x, bin_pixel<PixelFormat>(rows, x, factor));
+        }
+    }
+    return 0;
+}
+
+int binImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, true);
+}
+
+int binImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, true);
+}
+
+int binImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, true);
+}
+
+int binImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, false);
+}
+
+int binImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, false);
+}
+
+int binImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        uint32_t factor, uint32_t y, uint32_t h)
+{
+    return bin_image(src, dst, factor, y, h, false);
+}
+
+template <typename PixelFormat>
+static int bin_frame(FrameBuffer &fb, uint32_t factor)
+{
+    ImageView<PixelFormat> frame(fb);
+    if (factor != 2 && factor != 4) {
+        return -1;
+    }
+    uint32_t width = frame.getWidth() / factor;
+    uint32_t height = frame.getHeight() / factor;
+    ImageView<PixelFormat> binned(fb.getBuffer(), width, height, fb.getStride());
+    if (bin_image(frame, binned, factor, 0, 0, true) != 0) {
+        return -1;
+    }
+    fb.setFrameFormat(width, height, PixelFormat::format);
+    return 0;
+}
+
+int binFrame(FrameBuffer &fb, uint32_t factor)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return bin_frame<PixelGrayscale>(fb, factor);
+        case CAMERA_RGB565:
+            return bin_frame<PixelRGB565>(fb, factor);
+        case CAMERA_RGB565_LE:
+            return bin_frame<PixelRGB565LE>(fb, factor);
+        default:
+            return -1;
+    }
+}
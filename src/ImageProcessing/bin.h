@@ -0,0 +1,107 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image binning kernels.
+ */
+
+/**
+ * @file bin.h
+ * @brief 2x2 and 4x4 box binning kernels.
+ *
+ * Binning averages blocks of pixels, it gives a low resolution and low noise copy of a frame,
+ * e.g. for motion analysis, without reconfiguring the sensor:
+ * @code {.cpp}
+ * ImageView<PixelGrayscale> frame(fb);
+ * ImageView<PixelGrayscale> small(buffer, frame.getWidth() / 4, frame.getHeight() / 4);
+ * binImage(frame, small, 4);
+ * @endcode
+ * The averages are computed by halving additions, first between rows and then between columns,
+ * every halving rounds down like the __UHADD8 instruction: a 2x2 block a b / c d gives
+ * (((a + c) >> 1) + ((b + d) >> 1)) >> 1, and a 4x4 block is the average of two 2x4 halves
+ * computed the same way. RGB565 pixels are averaged per channel.
+ *
+ * The destination is written top-down and left to right behind the pixels that are read,
+ * so it can share the memory of the source, with the same first pixel and a stride lower or
+ * equal to the source one. Frames can be binned by bands of rows as they are received, the
+ * bands start and end on multiples of the binning factor.
+ */
+
+#ifndef __BIN_H
+#define __BIN_H
+
+#include "imageview.h"
+
+/**
+ * @brief Bin a grayscale image.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the source size divided by the factor, rounded down
+ * @param factor The binning factor, 2 or 4
+ * @param y The first source row of the band to bin, a multiple of the factor (default: 0)
+ * @param h The number of source rows of the band, a multiple of the factor (default: 0, up to the last full block)
+ * @return int 0 on success, -1 on failure
+ */
+int binImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Bin a big-endian RGB565 image.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the source size divided by the factor, rounded down
+ * @param factor The binning factor, 2 or 4
+ * @param y The first source row of the band to bin, a multiple of the factor (default: 0)
+ * @param h The number of source rows of the band, a multiple of the factor (default: 0, up to the last full block)
+ * @return int 0 on success, -1 on failure
+ */
+int binImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Bin a little-endian RGB565 image.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the source size divided by the factor, rounded down
+ * @param factor The binning factor, 2 or 4
+ * @param y The first source row of the band to bin, a multiple of the factor (default: 0)
+ * @param h The number of source rows of the band, a multiple of the factor (default: 0, up to the last full block)
+ * @return int 0 on success, -1 on failure
+ */
+int binImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Bin the grayscale or RGB565 frame stored in a frame buffer in place.
+ * The size of the frame is updated, the stride of the buffer is kept.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param factor The binning factor, 2 or 4
+ * @return int 0 on success, -1 on failure
+ */
+int binFrame(FrameBuffer &fb, uint32_t factor);
+
+/*
+ * Portable scalar reference implementations.
+ * They are always available, so the results of the accelerated kernels can be checked against them.
+ */
+int binImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+int binImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+int binImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        uint32_t factor, uint32_t y=0, uint32_t h=0);
+
+#endif /* __BIN_H */
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Connected component labeling.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "blob.h"
+
+/// A run of set pixels of a row, from x0 to x1 included
+struct BlobRun {
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t label;
+};
+
+/// A label, with the statistics of its runs once it is a root
+struct BlobLabel {
+    uint16_t parent;
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+    uint32_t area;
+    uint32_t sum_x;
+    uint32_t sum_y;
+};
+
+// Maximum number of runs of a row, separated by at least one clear pixel
+#define BLOB_ROW_RUNS(width)    ((width) / 2 + 1)
+
+int blobBegin(BlobLabeler &labeler, uint32_t width, uint32_t max_labels, bool connect8)
+{
+    if (width == 0 || width > BLOB_WIDTH_MAX || max_labels == 0 || max_labels > BLOB_LABELS_MAX) {
+        return -1;
+    }
+
+    memset(&labeler, 0, sizeof(labeler));
+    labeler.width = width;
+    labeler.max_labels = max_labels;
+    labeler.connect8 = connect8;
+    labeler.runs = (BlobRun *) malloc(2 * BLOB_ROW_RUNS(width) * sizeof(BlobRun));
+    labeler.labels = (BlobLabel *) malloc(max_labels * sizeof(BlobLabel));
+    if (labeler.runs == NULL || labeler.labels == NULL) {
+        blobEnd(labeler);
+        return -1;
+    }
+    return 0;
+}
+
+void blobEnd(BlobLabeler &labeler)
+{
+    free(labeler.runs);
+    free(labeler.labels);
+    labeler.runs = NULL;
+    labeler.labels = NULL;
+}
+
+// Find the runs of a row of a bit-packed mask. The runs start and end at the
+// transitions between clear and set bits, found 32 pixels at a time.
+static uint32_t blob_runs(const uint32_t *row, uint32_t width, BlobRun *runs)
+{
+    uint32_t n = 0;
+    uint32_t carry = 0;
+    for (uint32_t i = 0; i < MASK_ROW_WORDS(width); i++) {
+        uint32_t w = row[i];
+        uint32_t transitions = w ^ ((w << 1) | carry);
+        carry = w >> 31;
+        while (transitions) {
+            uint32_t x = i * 32 + __builtin_ctz(transitions);
+            transitions &= transitions - 1;
+            if ((w >> (x % 32)) & 1) {
+                runs[n].x0 = x;
+            } else {
+                runs[n++].x1 = x - 1;
+            }
+        }
+    }
+    // A run up to the last pixel of a row that fills its last word
+    if (carry) {
+        runs[n++].x1 = width - 1;
+    }
+    return n;
+}
+
+// Find the runs of a row of an 8-bit mask, the clear pixels are skipped 4 at a time.
+static uint32_t blob_runs(const uint8_t *row, uint32_t width, BlobRun *runs)
+{
+    uint32_t n = 0;
+    uint32_t x = 0;
+    while (x < width) {
+        while (x + 4 <= width && img_read32(row + x) == 0) {
+            x += 4;
+        }
+        while (x < width && row[x] == 0) {
+            x++;
+        }
+        if (x == width) {
+            break;
+        }
+        runs[n].x0 = x;
+        while (x < width && row[x]) {
+            x++;
+        }
+        runs[n++].x1 = x - 1;
+    }
+    return n;
+}
+
+static inline uint32_t blob_find(BlobLabel *labels, uint32_t label)
+{
+    uint32_t root = label;
+    while (labels[root].parent != root) {
+        root = labels[root].parent;
+    }
+    // Path compression
+    while (labels[label].parent != root) {
+        uint32_t next = labels[label].parent;
+        labels[label].parent = root;
+        label = next;
+    }
+    return root;
+}
+
+// Merge two roots into the lowest one, returns the new root.
+static uint32_t blob_union(BlobLabel *labels, uint32_t a, uint32_t b)
+{
+    if (a == b) {
+        return a;
+    }
+    if (b < a) {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    BlobLabel &ra = labels[a];
+    BlobLabel &rb = labels[b];
+    rb.parent = a;
+    ra.x0 = (rb.x0 < ra.x0) ? rb.x0 : ra.x0;
+    ra.y0 = (rb.y0 < ra.y0) ? rb.y0 : ra.y0;
+    ra.x1 = (rb.x1 > ra.x1) ? rb.x1 : ra.x1;
+    ra.y1 = (rb.y1 > ra.y1) ? rb.y1 : ra.y1;
+    ra.area += rb.area;
+    ra.sum_x += rb.sum_x;
+    ra.sum_y += rb.sum_y;
+    return a;
+}
+
+// Label the runs of a row from the runs of the row above. Returns the new number of labels, -1 on overflow.
+static int blob_label_row(BlobLabeler &labeler, BlobRun *runs, uint32_t n, const BlobRun *above, uint32_t n_above,
+        uint32_t y, uint32_t n_labels)
+{
+    BlobLabel *labels = labeler.labels;
+    uint32_t d = labeler.connect8 ? 1 : 0;
+    uint32_t j = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        BlobRun &run = runs[i];
+        // Skip the runs above that end before this run, they can't touch the next runs either
+        while (j < n_above && above[j].x1 + d < run.x0) {
+            j++;
+        }
+        uint32_t label = BLOB_LABELS_MAX;
+        for (uint32_t k = j; k < n_above && above[k].x0 <= run.x1 + d; k++) {
+            uint32_t root = blob_find(labels, above[k].label);
+            label = (label == BLOB_LABELS_MAX) ? root : blob_union(labels, label, root);
+        }
+
+        if (label == BLOB_LABELS_MAX) {
+            if (n_labels == labeler.max_labels) {
+                return -1;
+            }
+            label = n_labels++;
+            BlobLabel &l = labels[label];
+            l.parent = label;
+            l.x0 = run.x0;
+            l.x1 = run.x1;
+            l.y0 = y;
+            l.y1 = y;
+            l.area = 0;
+            l.sum_x = 0;
+            l.sum_y = 0;
+        }
+
+        BlobLabel &l = labels[label];
+        uint32_t length = run.x1 - run.x0 + 1;
+        l.x0 = (run.x0 < l.x0) ? run.x0 : l.x0;
+        l.x1 = (run.x1 > l.x1) ? run.x1 : l.x1;
+        l.y1 = y;
+        l.area += length;
+        l.sum_x += (run.x0 + run.x1) * length / 2;
+        l.sum_y += y * length;
+        run.label = label;
+    }
+    return n_labels;
+}
+
+// Keep the max_blobs largest root labels, sorted by decreasing area.
+static int blob_list(const BlobLabeler &labeler, uint32_t n_labels, Blob *blobs, uint32_t max_blobs, uint32_t min_area)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < n_labels; i++) {
+        const BlobLabel &l = labeler.labels[i];
+        if (l.parent != i || l.area < min_area) {
+            continue;
+        }
+        if (n == max_blobs && (n == 0 || l.area <= blobs[n - 1].area)) {
+            continue;
+        }
+        // Insert the blob in order, the smallest one falls off a full list
+        uint32_t k = (n < max_blobs) ? n++ : n - 1;
+        while (k > 0 && blobs[k - 1].area < l.area) {
+            blobs[k] = blobs[k - 1];
+            k--;
+        }
+        Blob &b = blobs[k];
+        b.x = l.x0;
+        b.y = l.y0;
+        b.w = l.x1 - l.x0 + 1;
+        b.h = l.y1 - l.y0 + 1;
+        b.area = l.area;
+        b.cx = (float) l.sum_x / l.area;
+        b.cy = (float) l.sum_y / l.area;
+    }
+    return n;
+}
+
+template <typename Row>
+static int find_blobs(BlobLabeler &labeler, Row row, uint32_t height, Blob *blobs, uint32_t max_blobs, uint32_t min_area)
+{
+    if (labeler.runs == NULL || blobs == NULL) {
+        return -1;
+    }
+
+    BlobRun *above = labeler.runs;
+    BlobRun *runs = labeler.runs + BLOB_ROW_RUNS(labeler.width);
+    uint32_t n_above = 0;
+    int n_labels = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        uint32_t n = blob_runs(row(y), labeler.width, runs);
+        n_labels = blob_label_row(labeler, runs, n, above, n_above, y, n_labels);
+        if (n_labels < 0) {
+            return -1;
+        }
+        BlobRun *t = above;
+        above = runs;
+        runs = t;
+        n_above = n;
+    }
+    return blob_list(labeler, n_labels, blobs, max_blobs, min_area);
+}
+
+int findBlobs(BlobLabeler &labeler, const uint32_t *mask, uint32_t height,
+        Blob *blobs, uint32_t max_blobs, uint32_t min_area)
+{
+    if (mask == NULL) {
+        return -1;
+    }
+    uint32_t words = MASK_ROW_WORDS(labeler.width);
+    return find_blobs(labeler, [&](uint32_t y) { return mask + y * words; }, height, blobs, max_blobs, min_area);
+}
+
+int findBlobs(BlobLabeler &labeler, const ImageView<PixelGrayscale> &mask,
+        Blob *blobs, uint32_t max_blobs, uint32_t min_area)
+{
+    if (!mask.isValid() || mask.getWidth() != labeler.width) {
+        return -1;
+    }
+    return find_blobs(labeler, [&](uint32_t y) { return (const uint8_t *) mask.row(y); },
+            mask.getHeight(), blobs, max_blobs, min_area);
+}
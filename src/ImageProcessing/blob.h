@@ -0,0 +1,131 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Connected component labeling.
+ */
+
+/**
+ * @file blob.h
+ * @brief Connected component labeling of binary masks into a list of blobs.
+ *
+ * The set pixels of a mask are grouped in connected blobs, and every blob is reduced to its
+ * bounding box, area and centroid:
+ * @code {.cpp}
+ * BlobLabeler labeler;
+ * Blob blobs[8];
+ * blobBegin(labeler, bg.width);
+ * int n = findBlobs(labeler, bg.mask, bg.height, blobs, 8, 20);
+ * for (int i = 0; i < n; i++) {
+ *     Serial.println(blobs[i].area);
+ * }
+ * @endcode
+ * The masks are scanned in a single pass, as runs of set pixels. The runs of a row are merged
+ * with the runs of the row above with a union-find, so only two rows of runs and the labels
+ * are kept in memory, allocated by blobBegin(). The runs of the bit-packed masks are found
+ * 32 pixels at a time from the transitions between set and clear bits.
+ */
+
+#ifndef __BLOB_H
+#define __BLOB_H
+
+#include "imageview.h"
+#include "mask.h"
+
+/// Default maximum number of labels of a mask
+#define BLOB_LABELS_DEFAULT     (512)
+/// Maximum number of labels of a mask
+#define BLOB_LABELS_MAX         (65535)
+/// Maximum width of the masks
+#define BLOB_WIDTH_MAX          (65535)
+
+/**
+ * @struct Blob
+ * @brief A connected blob of set pixels.
+ */
+struct Blob {
+    uint16_t x;                 /// X coordinate of the bounding box
+    uint16_t y;                 /// Y coordinate of the bounding box
+    uint16_t w;                 /// Width of the bounding box
+    uint16_t h;                 /// Height of the bounding box
+    uint32_t area;              /// Number of pixels
+    float cx;                   /// X coordinate of the centroid
+    float cy;                   /// Y coordinate of the centroid
+};
+
+struct BlobRun;
+struct BlobLabel;
+
+/**
+ * @struct BlobLabeler
+ * @brief Memory of the connected component labeling.
+ */
+struct BlobLabeler {
+    uint32_t width;             /// Width of the masks
+    uint32_t max_labels;        /// Maximum number of labels, every run that isn't connected to the row above takes one
+    bool connect8;              /// The diagonal neighbors are connected
+    BlobRun *runs;              /// Runs of the current row and of the row above
+    BlobLabel *labels;          /// Labels and their statistics
+};
+
+/**
+ * @brief Allocate the memory of the connected component labeling.
+ *
+ * @param labeler The labeler
+ * @param width The width of the masks, up to BLOB_WIDTH_MAX
+ * @param max_labels The maximum number of labels, up to BLOB_LABELS_MAX (default: BLOB_LABELS_DEFAULT)
+ * @param connect8 true if the diagonal neighbors are connected, false for only the horizontal
+ * and vertical neighbors (default: true)
+ * @return int 0 on success, -1 on failure
+ */
+int blobBegin(BlobLabeler &labeler, uint32_t width, uint32_t max_labels=BLOB_LABELS_DEFAULT, bool connect8=true);
+
+/**
+ * @brief Free the memory of the connected component labeling.
+ *
+ * @param labeler The labeler
+ */
+void blobEnd(BlobLabeler &labeler);
+
+/**
+ * @brief Find the blobs of a bit-packed mask (see mask.h).
+ * The largest blobs are returned first.
+ *
+ * @param labeler The labeler, for masks of the width of the mask
+ * @param mask The mask
+ * @param height The height of the mask
+ * @param blobs The list of blobs
+ * @param max_blobs The maximum number of blobs of the list, only the largest blobs are kept
+ * @param min_area The minimum area of the blobs (default: 1)
+ * @return int The number of blobs of the list, -1 on failure, e.g. if there are more than max_labels labels
+ */
+int findBlobs(BlobLabeler &labeler, const uint32_t *mask, uint32_t height,
+        Blob *blobs, uint32_t max_blobs, uint32_t min_area=1);
+
+/**
+ * @brief Find the blobs of an 8-bit mask, the pixels that are not 0 are set.
+ * The largest blobs are returned first.
+ *
+ * @param labeler The labeler, for masks of the width of the mask
+ * @param mask The mask
+ * @param blobs The list of blobs
+ * @param max_blobs The maximum number of blobs of the list, only the largest blobs are kept
+ * @param min_area The minimum area of the blobs (default: 1)
+ * @return int The number of blobs of the list, -1 on failure, e.g. if there are more than max_labels labels
+ */
+int findBlobs(BlobLabeler &labeler, const ImageView<PixelGrayscale> &mask,
+        Blob *blobs, uint32_t max_blobs, uint32_t min_area=1);
+
+#endif /* __BLOB_H */
@@ -0,0 +1,531 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Pixel format conversion kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "convert.h"
+
+// BT.601 full range YUV to RGB coefficients, in 8-bit fixed point
+#define YUV_R_V             (359)   /* 1.402    */
+#define YUV_G_U             (88)    /* 0.344136 */
+#define YUV_G_V             (183)   /* 0.714136 */
+#define YUV_B_U             (454)   /* 1.772    */
+
+template <typename Src, typename Dst>
+static bool size_check(const ImageView<Src> &src, const ImageView<Dst> &dst)
+{
+    return src.isValid() && dst.isValid()
+        && src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight();
+}
+
+template <typename Src, typename Dst>
+static bool yuv422_check(const ImageView<Src> &src, const ImageView<Dst> &dst)
+{
+    return src.isValid() && dst.isValid() && (src.getWidth() % 2) == 0
+        && src.getWidth() == dst.getWidth() && src.getHeight() == dst.getHeight();
+}
+
+// Convert the YUYV pair p[0..3] to two RGB pixels.
+static inline void yuv422_pair_rgb(const uint8_t *p, int32_t *r, int32_t *g, int32_t *b)
+{
+    int32_t u  = p[1] - 128;
+    int32_t v  = p[3] - 128;
+    int32_t dr = (YUV_R_V * v) >> 8;
+    int32_t dg = (YUV_G_U * u + YUV_G_V * v) >> 8;
+    int32_t db = (YUV_B_U * u) >> 8;
+
+    r[0] = img_clamp8(p[0] + dr);
+    g[0] = img_clamp8(p[0] - dg);
+    b[0] = img_clamp8(p[0] + db);
+    r[1] = img_clamp8(p[2] + dr);
+    g[1] = img_clamp8(p[2] - dg);
+    b[1] = img_clamp8(p[2] + db);
+}
+
+#if IMG_USE_DSP
+// Convert the YUYV pair in a word to two RGB pixels, every channel is
+// returned as two halfwords, with the first pixel in the lower halfword.
+static inline void yuv422_pair_rgb_dsp(uint32_t yuyv, uint32_t *r, uint32_t *g, uint32_t *b)
+{
+    uint32_t yy = __UXTB16(yuyv);                               // Y1 : Y0
+    uint32_t uv = __SSUB16(__UXTB16(__ROR(yuyv, 8)), 0x00800080); // V  : U, signed
+    int32_t dr  = __SMUAD(uv, (YUV_R_V << 16)) >> 8;
+    int32_t dg  = __SMUAD(uv, (YUV_G_V << 16) | YUV_G_U) >> 8;
+    int32_t db  = __SMUAD(uv, YUV_B_U) >> 8;
+
+    *r = __USAT16(__SADD16(yy, __PKHBT(dr, dr, 16)), 8);
+    *g = __USAT16(__SSUB16(yy, __PKHBT(dg, dg, 16)), 8);
+    *b = __USAT16(__SADD16(yy, __PKHBT(db, db, 16)), 8);
+}
+
+// Pack two pixels, given as halfword channels, to two little-endian RGB565 halfwords.
+static inline uint32_t rgb565_pack_dsp(uint32_t r, uint32_t g, uint32_t b)
+{
+    return ((r & 0x00F800F8) << 8) | ((g & 0x00FC00FC) << 3) | ((b >> 3) & 0x001F001F);
+}
+
+// Expand two little-endian RGB565 halfwords to halfword channels, as rgb565_unpack() does.
+static inline void rgb565_unpack_dsp(uint32_t pixels, uint32_t *r, uint32_t *g, uint32_t *b)
+{
+    uint32_t r5 = (pixels >> 11) & 0x001F001F;
+    uint32_t g6 = (pixels >> 5) & 0x003F003F;
+    uint32_t b5 = pixels & 0x001F001F;
+    *r = ((r5 << 3) | (r5 >> 2)) & 0x00FF00FF;
+    *g = ((g6 << 2) | (g6 >> 4)) & 0x00FF00FF;
+    *b = ((b5 << 3) | (b5 >> 2)) & 0x00FF00FF;
+}
+
+// Store 4 pixels, given as halfword channels of two pixels each, as 12 bytes of RGB888.
+static inline void rgb888_store4_dsp(uint8_t *d, uint32_t r0, uint32_t g0, uint32_t b0,
+        uint32_t r1, uint32_t g1, uint32_t b1)
+{
+    img_write32(d + 0, (r0 & 0xFF) | ((g0 & 0xFF) << 8) | ((b0 & 0xFF) << 16) | (r0 >> 16 << 24));
+    img_write32(d + 4, (g0 >> 16) | ((b0 >> 16) << 8) | ((r1 & 0xFF) << 16) | ((g1 & 0xFF) << 24));
+    img_write32(d + 8, (b1 & 0xFF) | ((r1 >> 16) << 8) | ((g1 >> 16) << 16) | (b1 >> 16 << 24));
+}
+#endif
+
+int yuv422ToGrayscaleReference(const ImageView<PixelYUV422> &src, const ImageView<PixelGrayscale> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = dst.row(y);
+        for (uint32_t x = 0; x < src.getWidth(); x++) {
+            d[x] = s[x * 2];
+        }
+    }
+    return 0;
+}
+
+template <bool LittleEndian, typename Dst>
+static int yuv422_to_rgb565_reference(const ImageView<PixelYUV422> &src, const ImageView<Dst> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        for (uint32_t x = 0; x < src.getWidth(); x += 2, s += 4, d += 4) {
+            int32_t r[2], g[2], b[2];
+            yuv422_pair_rgb(s, r, g, b);
+            for (int i = 0; i < 2; i++) {
+                uint16_t pixel = rgb565_pack(r[i], g[i], b[i]);
+                d[i * 2 + 0] = LittleEndian ? (pixel & 0xFF) : (pixel >> 8);
+                d[i * 2 + 1] = LittleEndian ? (pixel >> 8) : (pixel & 0xFF);
+            }
+        }
+    }
+    return 0;
+}
+
+int yuv422ToRGB565Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565> &dst)
+{
+    return yuv422_to_rgb565_reference<false>(src, dst);
+}
+
+int yuv422ToRGB565Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return yuv422_to_rgb565_reference<true>(src, dst);
+}
+
+int yuv422ToRGB888Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB888> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        for (uint32_t x = 0; x < src.getWidth(); x += 2, s += 4, d += 6) {
+            int32_t r[2], g[2], b[2];
+            yuv422_pair_rgb(s, r, g, b);
+            d[0] = r[0]; d[1] = g[0]; d[2] = b[0];
+            d[3] = r[1]; d[4] = g[1]; d[5] = b[1];
+        }
+    }
+    return 0;
+}
+
+template <typename Src, typename Dst>
+static int rgb565_swap_reference(const ImageView<Src> &src, const ImageView<Dst> &dst)
+{
+    if (!size_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        for (uint32_t x = 0; x < src.getWidth(); x++, s += 2, d += 2) {
+            uint8_t b0 = s[0];
+            uint8_t b1 = s[1];
+            d[0] = b1;
+            d[1] = b0;
+        }
+    }
+    return 0;
+}
+
+int rgb565SwapBytesReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return rgb565_swap_reference(src, dst);
+}
+
+int rgb565SwapBytesReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565> &dst)
+{
+    return rgb565_swap_reference(src, dst);
+}
+
+template <typename Src, typename Dst>
+static int rgb565_expand_reference(const ImageView<Src> &src, const ImageView<Dst> &dst)
+{
+    if (!size_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const typename Src::pixel_t *s = src.row(y);
+        typename Dst::pixel_t *d = dst.row(y);
+        for (uint32_t x = 0; x < src.getWidth(); x++) {
+            int32_t r, g, b;
+            rgb565_unpack(rgb565_load<Src>(s, x), &r, &g, &b);
+            PixelWriter<Dst>::write(d, x, r, g, b);
+        }
+    }
+    return 0;
+}
+
+int rgb565ToRGB888Reference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565_expand_reference(src, dst);
+}
+
+int rgb565ToRGB888Reference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565_expand_reference(src, dst);
+}
+
+int rgb565ToARGB8888Reference(const ImageView<PixelRGB565> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565_expand_reference(src, dst);
+}
+
+int rgb565ToARGB8888Reference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565_expand_reference(src, dst);
+}
+
+template <typename Src, typename Dst>
+static int rgb565_swap_frame(FrameBuffer &fb)
+{
+    ImageView<Src> src(fb);
+    ImageView<Dst> dst(src.getData(), src.getWidth(), src.getHeight(), src.getStride());
+
+    if (rgb565SwapBytes(src, dst) != 0) {
+        return -1;
+    }
+    fb.setFrameFormat(fb.getWidth(), fb.getHeight(), Dst::format);
+    return 0;
+}
+
+int rgb565SwapBytes(FrameBuffer &fb)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_RGB565:
+            return rgb565_swap_frame<PixelRGB565, PixelRGB565LE>(fb);
+        case CAMERA_RGB565_LE:
+            return rgb565_swap_frame<PixelRGB565LE, PixelRGB565>(fb);
+        default:
+            return -1;
+    }
+}
+
+#if IMG_USE_DSP
+int yuv422ToGrayscale(const ImageView<PixelYUV422> &src, const ImageView<PixelGrayscale> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = dst.row(y);
+        uint32_t x = 0;
+        // 4 pixels per iteration: Y0 U Y1 V Y2 U Y3 V -> Y0 Y1 Y2 Y3
+        for (; x + 4 <= src.getWidth(); x += 4, s += 8, d += 4) {
+            uint32_t lo = __UXTB16(img_read32(s + 0));  // Y1 : Y0
+            uint32_t hi = __UXTB16(img_read32(s + 4));  // Y3 : Y2
+            uint32_t even = __PKHBT(lo, hi, 16);        // Y2 : Y0
+            uint32_t odd  = __PKHTB(hi, lo, 16);        // Y3 : Y1
+            img_write32(d, even | (odd << 8));
+        }
+        for (; x < src.getWidth(); x++, s += 2) {
+            *d++ = s[0];
+        }
+    }
+    return 0;
+}
+
+template <bool LittleEndian, typename Dst>
+static int yuv422_to_rgb565(const ImageView<PixelYUV422> &src, const ImageView<Dst> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        uint32_t x = 0;
+        // 4 pixels per iteration, 2 YUYV pairs
+        for (; x + 4 <= src.getWidth(); x += 4, s += 8, d += 8) {
+            uint32_t r, g, b, p0, p1;
+            yuv422_pair_rgb_dsp(img_read32(s + 0), &r, &g, &b);
+            p0 = rgb565_pack_dsp(r, g, b);
+            yuv422_pair_rgb_dsp(img_read32(s + 4), &r, &g, &b);
+            p1 = rgb565_pack_dsp(r, g, b);
+            img_write32(d + 0, LittleEndian ? p0 : __REV16(p0));
+            img_write32(d + 4, LittleEndian ? p1 : __REV16(p1));
+        }
+        if (x < src.getWidth()) {
+            uint32_t r, g, b, p;
+            yuv422_pair_rgb_dsp(img_read32(s), &r, &g, &b);
+            p = rgb565_pack_dsp(r, g, b);
+            img_write32(d, LittleEndian ? p : __REV16(p));
+        }
+    }
+    return 0;
+}
+
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565> &dst)
+{
+    return yuv422_to_rgb565<false>(src, dst);
+}
+
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return yuv422_to_rgb565<true>(src, dst);
+}
+
+int yuv422ToRGB888(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB888> &dst)
+{
+    if (!yuv422_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        uint32_t x = 0;
+        // 4 pixels per iteration, 2 YUYV pairs to 12 bytes
+        for (; x + 4 <= src.getWidth(); x += 4, s += 8, d += 12) {
+            uint32_t r0, g0, b0, r1, g1, b1;
+            yuv422_pair_rgb_dsp(img_read32(s + 0), &r0, &g0, &b0);
+            yuv422_pair_rgb_dsp(img_read32(s + 4), &r1, &g1, &b1);
+            rgb888_store4_dsp(d, r0, g0, b0, r1, g1, b1);
+        }
+        if (x < src.getWidth()) {
+            uint32_t r, g, b;
+            yuv422_pair_rgb_dsp(img_read32(s), &r, &g, &b);
+            d[0] = r; d[1] = g; d[2] = b;
+            d[3] = r >> 16; d[4] = g >> 16; d[5] = b >> 16;
+        }
+    }
+    return 0;
+}
+template <typename Src, typename Dst>
+static int rgb565_swap(const ImageView<Src> &src, const ImageView<Dst> &dst)
+{
+    if (!size_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        uint32_t x = 0;
+        // 8 pixels per iteration, 2 pixels per word
+        for (; x + 8 <= src.getWidth(); x += 8, s += 16, d += 16) {
+            uint32_t p0 = img_read32(s + 0);
+            uint32_t p1 = img_read32(s + 4);
+            uint32_t p2 = img_read32(s + 8);
+            uint32_t p3 = img_read32(s + 12);
+            img_write32(d + 0, __REV16(p0));
+            img_write32(d + 4, __REV16(p1));
+            img_write32(d + 8, __REV16(p2));
+            img_write32(d + 12, __REV16(p3));
+        }
+        for (; x < src.getWidth(); x++, s += 2, d += 2) {
+            uint8_t b0 = s[0];
+            uint8_t b1 = s[1];
+            d[0] = b1;
+            d[1] = b0;
+        }
+    }
+    return 0;
+}
+
+int rgb565SwapBytes(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return rgb565_swap(src, dst);
+}
+
+int rgb565SwapBytes(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565> &dst)
+{
+    return rgb565_swap(src, dst);
+}
+
+// Load two RGB565 pixels as little-endian halfwords.
+template <typename Src>
+static inline uint32_t rgb565_read2_dsp(const uint8_t *s)
+{
+    uint32_t pixels = img_read32(s);
+    return (Src::format == CAMERA_RGB565_LE) ? pixels : __REV16(pixels);
+}
+
+template <typename Src>
+static int rgb565_to_rgb888(const ImageView<Src> &src, const ImageView<PixelRGB888> &dst)
+{
+    if (!size_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        rgb888_t *d = dst.row(y);
+        uint32_t x = 0;
+        // 4 pixels per iteration, to 12 bytes
+        for (; x + 4 <= src.getWidth(); x += 4, s += 8) {
+            uint32_t r0, g0, b0, r1, g1, b1;
+            rgb565_unpack_dsp(rgb565_read2_dsp<Src>(s + 0), &r0, &g0, &b0);
+            rgb565_unpack_dsp(rgb565_read2_dsp<Src>(s + 4), &r1, &g1, &b1);
+            rgb888_store4_dsp((uint8_t *) (d + x), r0, g0, b0, r1, g1, b1);
+        }
+        for (; x < src.getWidth(); x++) {
+            int32_t r, g, b;
+            rgb565_unpack(rgb565_load<Src>(src.row(y), x), &r, &g, &b);
+            PixelWriter<PixelRGB888>::write(d, x, r, g, b);
+        }
+    }
+    return 0;
+}
+
+int rgb565ToRGB888(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565_to_rgb888(src, dst);
+}
+
+int rgb565ToRGB888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565_to_rgb888(src, dst);
+}
+
+template <typename Src>
+static int rgb565_to_argb8888(const ImageView<Src> &src, const ImageView<PixelARGB8888> &dst)
+{
+    if (!size_check(src, dst)) {
+        return -1;
+    }
+
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = (const uint8_t *) src.row(y);
+        uint8_t *d = (uint8_t *) dst.row(y);
+        uint32_t x = 0;
+        // 2 pixels per iteration, one word in, two words out
+        for (; x + 2 <= src.getWidth(); x += 2, s += 4, d += 8) {
+            uint32_t r, g, b;
+            rgb565_unpack_dsp(rgb565_read2_dsp<Src>(s), &r, &g, &b);
+            img_write32(d + 0, 0xFF000000 | __PKHBT(b, r, 16) | ((g & 0xFF) << 8));
+            img_write32(d + 4, 0xFF000000 | __PKHTB(r, b, 16) | ((g >> 16) << 8));
+        }
+        if (x < src.getWidth()) {
+            int32_t r, g, b;
+            rgb565_unpack(rgb565_load<Src>(src.row(y), x), &r, &g, &b);
+            PixelWriter<PixelARGB8888>::write(dst.row(y), x, r, g, b);
+        }
+    }
+    return 0;
+}
+
+int rgb565ToARGB8888(const ImageView<PixelRGB565> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565_to_argb8888(src, dst);
+}
+
+int rgb565ToARGB8888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565_to_argb8888(src, dst);
+}
+#else
+int yuv422ToGrayscale(const ImageView<PixelYUV422> &src, const ImageView<PixelGrayscale> &dst)
+{
+    return yuv422ToGrayscaleReference(src, dst);
+}
+
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565> &dst)
+{
+    return yuv422ToRGB565Reference(src, dst);
+}
+
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return yuv422ToRGB565Reference(src, dst);
+}
+
+int yuv422ToRGB888(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB888> &dst)
+{
+    return yuv422ToRGB888Reference(src, dst);
+}
+
+int rgb565SwapBytes(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565LE> &dst)
+{
+    return rgb565SwapBytesReference(src, dst);
+}
+
+int rgb565SwapBytes(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565> &dst)
+{
+    return rgb565SwapBytesReference(src, dst);
+}
+
+int rgb565ToRGB888(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565ToRGB888Reference(src, dst);
+}
+
+int rgb565ToRGB888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB888> &dst)
+{
+    return rgb565ToRGB888Reference(src, dst);
+}
+
+int rgb565ToARGB8888(const ImageView<PixelRGB565> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565ToARGB8888Reference(src, dst);
+}
+
+int rgb565ToARGB8888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelARGB8888> &dst)
+{
+    return rgb565ToARGB8888Reference(src, dst);
+}
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Pixel format conversion kernels.
+ */
+
+/**
+ * @file convert.h
+ * @brief Pixel format conversion kernels.
+ *
+ * The YUV422 conversions use the BT.601 full range coefficients in 8-bit fixed point.
+ * The RGB565 expansions replicate the most significant bits of every channel into the
+ * new least significant bits, so that white stays white.
+ * On cores with the DSP extension the kernels process 2 to 8 pixels per iteration with the
+ * packed SIMD instructions, the scalar reference implementations compute the exact same
+ * result and are used on the other cores.
+ *
+ * All kernels return 0 on success and -1 if the source and destination sizes don't match.
+ * The source and destination can have different strides, so they can be sub-views.
+ */
+
+#ifndef __CONVERT_H
+#define __CONVERT_H
+
+#include "imageview.h"
+
+/**
+ * @brief Extract the Y channel of a YUV422 image.
+ *
+ * @param src The YUV422 source image, its width must be even
+ * @param dst The grayscale destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int yuv422ToGrayscale(const ImageView<PixelYUV422> &src, const ImageView<PixelGrayscale> &dst);
+
+/**
+ * @brief Convert a YUV422 image to big-endian RGB565, the byte order of the sensors.
+ *
+ * @param src The YUV422 source image, its width must be even
+ * @param dst The RGB565 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565> &dst);
+
+/**
+ * @brief Convert a YUV422 image to little-endian RGB565, the native byte order of the CPU.
+ *
+ * @param src The YUV422 source image, its width must be even
+ * @param dst The RGB565 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int yuv422ToRGB565(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565LE> &dst);
+
+/**
+ * @brief Convert a YUV422 image to RGB888.
+ *
+ * @param src The YUV422 source image, its width must be even
+ * @param dst The RGB888 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int yuv422ToRGB888(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB888> &dst);
+
+/**
+ * @brief Swap the bytes of every pixel of a big-endian RGB565 image, to get a little-endian image.
+ * The destination can be the same memory as the source, the image is then converted in place.
+ *
+ * @param src The big-endian RGB565 source image
+ * @param dst The little-endian RGB565 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565SwapBytes(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565LE> &dst);
+
+/**
+ * @brief Swap the bytes of every pixel of a little-endian RGB565 image, to get a big-endian image.
+ * The destination can be the same memory as the source, the image is then converted in place.
+ *
+ * @param src The little-endian RGB565 source image
+ * @param dst The big-endian RGB565 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565SwapBytes(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565> &dst);
+
+/**
+ * @brief Swap the bytes of every pixel of the RGB565 frame stored in a frame buffer, in place.
+ * The pixel format of the frame is updated, from CAMERA_RGB565 to CAMERA_RGB565_LE or back.
+ * Sensors that can send little-endian RGB565 don't need this, see Camera::setPixelFormat().
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @return int 0 on success, -1 if the frame is not RGB565
+ */
+int rgb565SwapBytes(FrameBuffer &fb);
+
+/**
+ * @brief Expand a big-endian RGB565 image to RGB888.
+ *
+ * @param src The big-endian RGB565 source image
+ * @param dst The RGB888 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565ToRGB888(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB888> &dst);
+
+/**
+ * @brief Expand a little-endian RGB565 image to RGB888.
+ *
+ * @param src The little-endian RGB565 source image
+ * @param dst The RGB888 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565ToRGB888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB888> &dst);
+
+/**
+ * @brief Expand a big-endian RGB565 image to opaque ARGB8888, e.g. for the LTDC or the DMA2D.
+ *
+ * @param src The big-endian RGB565 source image
+ * @param dst The ARGB8888 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565ToARGB8888(const ImageView<PixelRGB565> &src, const ImageView<PixelARGB8888> &dst);
+
+/**
+ * @brief Expand a little-endian RGB565 image to opaque ARGB8888, e.g. for the LTDC or the DMA2D.
+ *
+ * @param src The little-endian RGB565 source image
+ * @param dst The ARGB8888 destination image, of the same size
+ * @return int 0 on success, -1 on failure
+ */
+int rgb565ToARGB8888(const ImageView<PixelRGB565LE> &src, const ImageView<PixelARGB8888> &dst);
+
+/*
+ * Portable scalar reference implementations.
+ * They are always available, so the results of the accelerated kernels can be checked against them.
+ */
+int yuv422ToGrayscaleReference(const ImageView<PixelYUV422> &src, const ImageView<PixelGrayscale> &dst);
+int yuv422ToRGB565Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565> &dst);
+int yuv422ToRGB565Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB565LE> &dst);
+int yuv422ToRGB888Reference(const ImageView<PixelYUV422> &src, const ImageView<PixelRGB888> &dst);
+int rgb565SwapBytesReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565LE> &dst);
+int rgb565SwapBytesReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565> &dst);
+int rgb565ToRGB888Reference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB888> &dst);
+int rgb565ToRGB888Reference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB888> &dst);
+int rgb565ToARGB8888Reference(const ImageView<PixelRGB565> &src, const ImageView<PixelARGB8888> &dst);
+int rgb565ToARGB8888Reference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelARGB8888> &dst);
+
+#endif /* __CONVERT_H */
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * FAST corner detection.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "corner.h"
+
+// Circle of radius 3 around the pixel, clockwise from the top
+static const int8_t circle_x[16] = { 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2, -1 };
+static const int8_t circle_y[16] = { -3, -3, -2, -1, 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3 };
+
+int cornerBegin(CornerDetector &det, uint32_t width, uint32_t height, uint32_t threshold, uint32_t max_keypoints)
+{
+    if (width < 2 * CORNER_BORDER + 1 || height < 2 * CORNER_BORDER + 1 || width > 65535 || height > 65535
+            || threshold == 0 || threshold > 254 || max_keypoints == 0) {
+        return -1;
+    }
+
+    memset(&det, 0, sizeof(det));
+    det.width = width;
+    det.height = height;
+    det.threshold = threshold;
+    det.max_keypoints = max_keypoints;
+    det.scores = (uint8_t *) malloc(3 * width);
+    det.keypoints = (Keypoint *) malloc(max_keypoints * sizeof(Keypoint));
+    if (det.scores == NULL || det.keypoints == NULL) {
+        cornerEnd(det);
+        return -1;
+    }
+    return 0;
+}
+
+void cornerEnd(CornerDetector &det)
+{
+    free(det.scores);
+    free(det.keypoints);
+    det.scores = NULL;
+    det.keypoints = NULL;
+}
+
+// Highest of the minimums of the 9 contiguous differences of the circle.
+static int32_t corner_arc_score(const int32_t *d)
+{
+    int32_t m2[16], m4[16];
+    for (uint32_t i = 0; i < 16; i++) {
+        m2[i] = (d[i] < d[(i + 1) % 16]) ? d[i] : d[(i + 1) % 16];
+    }
+    for (uint32_t i = 0; i < 16; i++) {
+        m4[i] = (m2[i] < m2[(i + 2) % 16]) ? m2[i] : m2[(i + 2) % 16];
+    }
+    int32_t score = INT32_MIN;
+    for (uint32_t i = 0; i < 16; i++) {
+        int32_t m = (m4[i] < m4[(i + 4) % 16]) ? m4[i] : m4[(i + 4) % 16];
+        m = (m < d[(i + 8) % 16]) ? m : d[(i + 8) % 16];
+        score = (m > score) ? m : score;
+    }
+    return score;
+}
+
+// Returns true if the 16-bit circular mask has 9 contiguous bits set.
+static inline bool corner_arc(uint32_t mask)
+{
+    mask |= mask << 16;
+    uint32_t m = mask & (mask >> 1);
+    m &= m >> 2;
+    m &= m >> 4;
+    return (m & (mask >> 8) & 0xFFFF) != 0;
+}
+
+// Score of a pixel, 0 if it isn't a corner.
+static uint8_t corner_score(const uint8_t *p, int32_t stride, int32_t t)
+{
+    int32_t c = p[0];
+    int32_t hi = c + t;
+    int32_t lo = c - t;
+
+    // 9 contiguous pixels include one of the top and bottom pixels, and one of the left and right pixels.
+    int32_t top = p[-3 * stride], bottom = p[3 * stride];
+    int32_t left = p[-3], right = p[3];
+    bool bright = (top > hi || bottom > hi) && (left > hi || right > hi);
+    bool dark = (top < lo || bottom < lo) && (left < lo || right < lo);
+    if (!bright && !dark) {
+        return 0;
+    }
+
+    int32_t d[16];
+    uint32_t bright_mask = 0, dark_mask = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        int32_t v = p[circle_y[i] * stride + circle_x[i]];
+        bright_mask |= (v > hi) << i;
+        dark_mask |= (v < lo) << i;
+        d[i] = v - c;
+    }
+
+    if (bright && corner_arc(bright_mask)) {
+        return corner_arc_score(d);
+    }
+    if (dark && corner_arc(dark_mask)) {
+        for (uint32_t i = 0; i < 16; i++) {
+            d[i] = -d[i];
+        }
+        return corner_arc_score(d);
+    }
+    return 0;
+}
+
+// Score the pixels of a row, the first and last pixels of the row are never corners.
+static void corner_row(const CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y,
+        uint8_t *scores, bool fast)
+{
+    const uint8_t *p = frame.row(y);
+    int32_t stride = frame.getStride();
+    uint32_t t = det.threshold;
+    uint32_t x = CORNER_BORDER;
+    uint32_t end = det.width - CORNER_BORDER;
+
+    #if IMG_USE_DSP
+    if (fast) {
+        // Reject 4 pixels at once if none has its top or bottom pixel outside of [c - t, c + t].
+        const uint8_t *above = p - 3 * stride;
+        const uint8_t *below = p + 3 * stride;
+        uint32_t t4 = t * 0x01010101;
+        for (; x + 4 <= end; x += 4) {
+            uint32_t c = img_read32(p + x);
+            uint32_t top = img_read32(above + x);
+            uint32_t bottom = img_read32(below + x);
+            uint32_t hi = __UQADD8(c, t4);
+            uint32_t lo = __UQSUB8(c, t4);
+            uint32_t candidates = __UQSUB8(top, hi) | __UQSUB8(bottom, hi) | __UQSUB8(lo, top) | __UQSUB8(lo, bottom);
+            if (candidates == 0) {
+                img_write32(scores + x, 0);
+                continue;
+            }
+            for (uint32_t i = 0; i < 4; i++) {
+                scores[x + i] = ((candidates >> (8 * i)) & 0xFF) ? corner_score(p + x + i, stride, t) : 0;
+            }
+        }
+    }
+    #endif
+
+    for (; x < end; x++) {
+        scores[x] = corner_score(p + x, stride, t);
+    }
+}
+
+static void corner_add(CornerDetector &det, uint32_t x, uint32_t y, uint32_t score)
+{
+    uint32_t i;
+    if (det.count < det.max_keypoints) {
+        i = det.count++;
+    } else if (score > det.keypoints[det.weakest].score) {
+        i = det.weakest;
+    } else {
+        return;
+    }
+    det.keypoints[i].x = x;
+    det.keypoints[i].y = y;
+    det.keypoints[i].score = score;
+
+    if (det.count == det.max_keypoints) {
+        for (uint32_t k = 0; k < det.count; k++) {
+            if (det.keypoints[k].score < det.keypoints[det.weakest].score) {
+                det.weakest = k;
+            }
+        }
+    }
+}
+
+// Keep the corners of a row that are stronger than their neighbors. On a tie the first one
+// in the scan order wins, so a plateau keeps one corner.
+static void corner_nms(CornerDetector &det, uint32_t y)
+{
+    uint32_t width = det.width;
+    const uint8_t *above = det.scores + ((y - 1) % 3) * width;
+    const uint8_t *row = det.scores + (y % 3) * width;
+    const uint8_t *below = det.scores + ((y + 1) % 3) * width;
+
+    for (uint32_t x = CORNER_BORDER; x < width - CORNER_BORDER; x++) {
+        uint32_t s = row[x];
+        if (s == 0) {
+            continue;
+        }
+        if (s > above[x - 1] && s > above[x] && s > above[x + 1] && s > row[x - 1]
+                && s >= row[x + 1] && s >= below[x - 1] && s >= below[x] && s >= below[x + 1]) {
+            corner_add(det, x, y, s);
+        }
+    }
+}
+
+static int fast_corners(CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y, uint32_t h, bool fast)
+{
+    if (!frame.isValid() || det.scores == NULL || frame.getWidth() != det.width || frame.getHeight() != det.height
+            || det.threshold == 0 || det.threshold > 254 || y >= det.height) {
+        return -1;
+    }
+    if (h == 0) {
+        h = det.height - y;
+    }
+    if (h > det.height - y) {
+        return -1;
+    }
+
+    if (y == 0) {
+        det.count = 0;
+        det.rows = 0;
+        det.next_row = CORNER_BORDER;
+        det.weakest = 0;
+        memset(det.scores, 0, 3 * det.width);
+    } else if (y != det.rows) {
+        return -1;
+    }
+    det.rows = y + h;
+
+    // Score the rows that have their 3 rows below, and suppress the non-maximums of the row above
+    // them. The 3 last rows have no corners, their scores are 0.
+    while (det.next_row + CORNER_BORDER <= det.height) {
+        uint32_t r = det.next_row;
+        uint8_t *scores = det.scores + (r % 3) * det.width;
+        if (r + CORNER_BORDER < det.height) {
+            if (r + CORNER_BORDER >= det.rows) {
+                break;
+            }
+            corner_row(det, frame, r, scores, fast);
+        } else {
+            memset(scores, 0, det.width);
+        }
+        if (r > CORNER_BORDER) {
+            corner_nms(det, r - 1);
+        }
+        det.next_row++;
+    }
+    return det.count;
+}
+
+int fastCorners(CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y, uint32_t h)
+{
+    return fast_corners(det, frame, y, h, true);
+}
+
+int fastCornersReference(CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y, uint32_t h)
+{
+    return fast_corners(det, frame, y, h, false);
+}
+
+int frameCorners(FrameBuffer &fb, CornerDetector &det)
+{
+    ImageView<PixelGrayscale> frame(fb);
+    return fast_corners(det, frame, 0, 0, true);
+}
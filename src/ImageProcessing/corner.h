@@ -0,0 +1,134 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * FAST corner detection.
+ */
+
+/**
+ * @file corner.h
+ * @brief FAST-9 corner detection with non-maximum suppression in grayscale frames.
+ *
+ * A pixel is a corner if 9 contiguous pixels of the circle of radius 3 around it are all
+ * brighter than the pixel plus the threshold, or all darker than the pixel minus the threshold.
+ * The score of a corner is the highest threshold for which it would still be a corner, and
+ * only the corners with a higher score than their 8 neighbors are kept:
+ * @code {.cpp}
+ * CornerDetector det;
+ * cornerBegin(det, 320, 240, 20, 100);
+ * if (cam.grabFrame(fb, 3000) == 0) {
+ *     int n = frameCorners(fb, det);
+ *     for (int i = 0; i < n; i++) {
+ *         Keypoint &k = det.keypoints[i];
+ *     }
+ * }
+ * @endcode
+ * The frame can also be processed in bands of rows as they are captured, fastCorners() only
+ * keeps 3 rows of scores and reads the rows of the frame up to 3 rows below the current one.
+ *
+ * The pixels above and below, then to the left and right, are tested first, as 9 contiguous
+ * pixels always include one pixel of each opposite pair. With the DSP extension, the first test
+ * rejects 4 pixels at once.
+ */
+
+#ifndef __CORNER_H
+#define __CORNER_H
+
+#include "imageview.h"
+
+/// Default threshold
+#define CORNER_THRESHOLD_DEFAULT    (20)
+/// Default maximum number of keypoints
+#define CORNER_KEYPOINTS_DEFAULT    (256)
+/// Radius of the circle of the test, no corner is detected closer to the border of the frame
+#define CORNER_BORDER               (3)
+
+/**
+ * @struct Keypoint
+ * @brief A corner.
+ */
+struct Keypoint {
+    uint16_t x;                 /// X coordinate
+    uint16_t y;                 /// Y coordinate
+    uint16_t score;             /// Score, higher than the threshold
+};
+
+/**
+ * @struct CornerDetector
+ * @brief State of the corner detection of a frame.
+ */
+struct CornerDetector {
+    uint32_t width;             /// Width of the frames
+    uint32_t height;            /// Height of the frames
+    uint32_t threshold;         /// Minimum difference with the center of the pixels of the arc, 1 to 254
+    uint32_t max_keypoints;     /// Maximum number of keypoints, the strongest ones are kept
+    uint32_t count;             /// Number of keypoints found so far
+    uint32_t rows;              /// Number of rows of the frame received so far
+    uint32_t next_row;          /// Next row to score
+    uint32_t weakest;           /// Index of the weakest keypoint, once there are max_keypoints
+    uint8_t *scores;            /// Scores of the last 3 rows, 0 if not a corner
+    Keypoint *keypoints;        /// Keypoints
+};
+
+/**
+ * @brief Allocate the memory of the corner detection.
+ *
+ * @param det The detector
+ * @param width The width of the frames, at least 7
+ * @param height The height of the frames, at least 7
+ * @param threshold The threshold, 1 to 254 (default: CORNER_THRESHOLD_DEFAULT)
+ * @param max_keypoints The maximum number of keypoints (default: CORNER_KEYPOINTS_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int cornerBegin(CornerDetector &det, uint32_t width, uint32_t height,
+        uint32_t threshold=CORNER_THRESHOLD_DEFAULT, uint32_t max_keypoints=CORNER_KEYPOINTS_DEFAULT);
+
+/**
+ * @brief Free the memory of the corner detection.
+ *
+ * @param det The detector
+ */
+void cornerEnd(CornerDetector &det);
+
+/**
+ * @brief Detect the corners of a band of rows of a grayscale frame, as soon as the band is captured.
+ * The bands must be passed in order, the first band (y = 0) starts a new frame. The corners are
+ * detected up to 4 rows above the end of the band, the remaining rows are processed with the next
+ * band. If there are more than max_keypoints corners, the strongest ones are kept, in no particular order.
+ *
+ * @param det The detector
+ * @param frame The whole frame, only the rows up to the end of the band are read
+ * @param y The first row of the band
+ * @param h The height of the band, 0 for the rest of the frame (default: 0)
+ * @return int The number of keypoints found so far, -1 on failure
+ */
+int fastCorners(CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Detect the corners of the grayscale frame stored in a frame buffer.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param det The detector
+ * @return int The number of keypoints, -1 on failure
+ */
+int frameCorners(FrameBuffer &fb, CornerDetector &det);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int fastCornersReference(CornerDetector &det, const ImageView<PixelGrayscale> &frame, uint32_t y=0, uint32_t h=0);
+
+#endif /* __CORNER_H */
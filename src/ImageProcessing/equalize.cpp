@@ -0,0 +1,349 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Histogram equalization.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "stats.h"
+#include "equalize.h"
+
+int equalizeLut(const uint32_t *histogram, uint8_t *lut)
+{
+    if (histogram == NULL || lut == NULL) {
+        return -1;
+    }
+
+    uint32_t total = 0;
+    uint32_t cdf_min = 0;
+    for (uint32_t v = 0; v < 256; v++) {
+        total += histogram[v];
+        if (cdf_min == 0) {
+            cdf_min = total;
+        }
+    }
+    if (total == 0) {
+        return -1;
+    }
+
+    // The lowest value maps to 0 and the highest to 255, a flat image is left unchanged.
+    uint32_t den = total - cdf_min;
+    uint32_t cdf = 0;
+    for (uint32_t v = 0; v < 256; v++) {
+        cdf += histogram[v];
+        if (den == 0) {
+            lut[v] = v;
+        } else {
+            lut[v] = (cdf < cdf_min) ? 0 : ((uint64_t) (cdf - cdf_min) * 255 + den / 2) / den;
+        }
+    }
+    return 0;
+}
+
+static int equalize_image(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        const uint32_t *histogram, bool fast)
+{
+    uint8_t lut[256];
+    if (!src.isValid() || !dst.isValid() || src.getWidth() != dst.getWidth() || src.getHeight() != dst.getHeight()
+            || equalizeLut(histogram, lut) != 0) {
+        return -1;
+    }
+
+    uint32_t width = src.getWidth();
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *s = src.row(y);
+        uint8_t *d = dst.row(y);
+        uint32_t x = 0;
+
+        if (fast) {
+            // One load and one store for 4 pixels
+            for (; x + 4 <= width; x += 4) {
+                uint32_t w = img_read32(s + x);
+                img_write32(d + x, lut[w & 0xFF] | (lut[(w >> 8) & 0xFF] << 8)
+                        | (lut[(w >> 16) & 0xFF] << 16) | ((uint32_t) lut[w >> 24] << 24));
+            }
+        }
+
+        for (; x < width; x++) {
+            d[x] = lut[s[x]];
+        }
+    }
+    return 0;
+}
+
+int equalizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, const uint32_t *histogram)
+{
+    return equalize_image(src, dst, histogram, true);
+}
+
+int equalizeImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, const uint32_t *histogram)
+{
+    return equalize_image(src, dst, histogram, false);
+}
+
+int frameEqualize(FrameBuffer &fb)
+{
+    ImageStats stats;
+    ImageView<PixelGrayscale> frame(fb);
+    if (!frame.isValid() || frameStats(fb, stats) != 0) {
+        return -1;
+    }
+    return equalize_image(frame, frame, stats.histogram, true);
+}
+
+// Center of a tile, between two edges.
+static inline uint32_t clahe_center(const uint16_t *edges, uint32_t i)
+{
+    return (edges[i] + edges[i + 1]) / 2;
+}
+
+// Weight out of 256 of the tile after the tile i at the position p, 0 before the center of the
+// first tile and after the center of the last tile.
+static inline uint32_t clahe_weight(const uint16_t *edges, uint32_t n, uint32_t i, uint32_t p)
+{
+    uint32_t c0 = clahe_center(edges, i);
+    if (i + 1 >= n || p < c0) {
+        return 0;
+    }
+    uint32_t span = clahe_center(edges, i + 1) - c0;
+    uint32_t w = ((p - c0) * 256 + span / 2) / span;
+    return (w > 255) ? 255 : w;
+}
+
+// Tile whose center is at or before a position, the first tile before its center.
+static inline uint32_t clahe_tile(const uint16_t *edges, uint32_t n, uint32_t p)
+{
+    uint32_t i = 0;
+    while (i + 1 < n && p >= clahe_center(edges, i + 1)) {
+        i++;
+    }
+    return i;
+}
+
+int claheBegin(Clahe &clahe, uint32_t width, uint32_t height, uint32_t grid_cols, uint32_t grid_rows, float clip)
+{
+    if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF
+            || grid_cols == 0 || grid_cols > CLAHE_GRID_MAX || grid_cols > width
+            || grid_rows == 0 || grid_rows > CLAHE_GRID_MAX || grid_rows > height || clip < 0.0f) {
+        return -1;
+    }
+
+    memset(&clahe, 0, sizeof(clahe));
+    clahe.width = width;
+    clahe.height = height;
+    clahe.grid_cols = grid_cols;
+    clahe.grid_rows = grid_rows;
+    clahe.clip = clip;
+    for (uint32_t i = 0; i <= grid_cols; i++) {
+        clahe.col_edges[i] = i * width / grid_cols;
+    }
+    for (uint32_t i = 0; i <= grid_rows; i++) {
+        clahe.row_edges[i] = i * height / grid_rows;
+    }
+
+    clahe.histograms = (uint32_t *) malloc(grid_cols * 256 * sizeof(uint32_t));
+    clahe.luts = (uint8_t *) malloc(grid_rows * grid_cols * 256);
+    clahe.col_weights = (uint8_t *) malloc(width);
+    if (clahe.histograms == NULL || clahe.luts == NULL || clahe.col_weights == NULL) {
+        claheEnd(clahe);
+        return -1;
+    }
+
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t c = clahe_tile(clahe.col_edges, grid_cols, x);
+        clahe.col_weights[x] = clahe_weight(clahe.col_edges, grid_cols, c, x);
+    }
+    return 0;
+}
+
+void claheEnd(Clahe &clahe)
+{
+    free(clahe.histograms);
+    free(clahe.luts);
+    free(clahe.col_weights);
+    clahe.histograms = NULL;
+    clahe.luts = NULL;
+    clahe.col_weights = NULL;
+}
+
+// Build the table of a tile from its histogram, clipped at clip times the mean count of the
+// bins. The clipped counts are spread over all the bins.
+static void clahe_lut(uint32_t *hist, uint32_t n, float clip, uint8_t *lut)
+{
+    if (clip > 0.0f) {
+        uint32_t limit = (uint32_t) (clip * n / 256);
+        limit = (limit < 1) ? 1 : limit;
+        uint32_t excess = 0;
+        for (uint32_t v = 0; v < 256; v++) {
+            if (hist[v] > limit) {
+                excess += hist[v] - limit;
+                hist[v] = limit;
+            }
+        }
+        uint32_t add = excess / 256;
+        uint32_t rest = excess % 256;
+        for (uint32_t v = 0; v < 256; v++) {
+            hist[v] += add;
+        }
+        if (rest) {
+            uint32_t step = 256 / rest;
+            for (uint32_t v = 0; v < 256 && rest > 0; v += step, rest--) {
+                hist[v]++;
+            }
+        }
+    }
+
+    uint32_t cdf = 0;
+    for (uint32_t v = 0; v < 256; v++) {
+        cdf += hist[v];
+        lut[v] = ((uint64_t) cdf * 255 + n / 2) / n;
+    }
+}
+
+int claheUpdate(Clahe &clahe, const ImageView<PixelGrayscale> &band, uint32_t y)
+{
+    if (!band.isValid() || clahe.histograms == NULL || band.getWidth() != clahe.width
+            || y > clahe.height || band.getHeight() > clahe.height - y) {
+        return -1;
+    }
+    if (y == 0) {
+        clahe.rows = 0;
+        memset(clahe.histograms, 0, clahe.grid_cols * 256 * sizeof(uint32_t));
+    } else if (y != clahe.rows) {
+        return -1;
+    }
+
+    uint32_t tile_row = 0;
+    while (tile_row + 1 < clahe.grid_rows && y >= clahe.row_edges[tile_row + 1]) {
+        tile_row++;
+    }
+
+    for (uint32_t by = 0; by < band.getHeight(); by++, y++) {
+        const uint8_t *row = band.row(by);
+        for (uint32_t c = 0; c < clahe.grid_cols; c++) {
+            uint32_t *hist = clahe.histograms + c * 256;
+            uint32_t x = clahe.col_edges[c];
+            uint32_t x1 = clahe.col_edges[c + 1];
+            for (; x + 4 <= x1; x += 4) {
+                uint32_t w = img_read32(row + x);
+                hist[w & 0xFF]++;
+                hist[(w >> 8) & 0xFF]++;
+                hist[(w >> 16) & 0xFF]++;
+                hist[w >> 24]++;
+            }
+            for (; x < x1; x++) {
+                hist[row[x]]++;
+            }
+        }
+
+        // Last row of a row of tiles: build the tables and start the next row of tiles.
+        if (y + 1 == clahe.row_edges[tile_row + 1]) {
+            uint32_t tile_height = clahe.row_edges[tile_row + 1] - clahe.row_edges[tile_row];
+            for (uint32_t c = 0; c < clahe.grid_cols; c++) {
+                uint32_t n = (clahe.col_edges[c + 1] - clahe.col_edges[c]) * tile_height;
+                clahe_lut(clahe.histograms + c * 256, n, clahe.clip,
+                        clahe.luts + (tile_row * clahe.grid_cols + c) * 256);
+            }
+            memset(clahe.histograms, 0, clahe.grid_cols * 256 * sizeof(uint32_t));
+            tile_row++;
+        }
+    }
+    clahe.rows = y;
+    return 0;
+}
+
+// Blend the tables of the 4 tiles around a pixel: a and b above, c and d below, wx and wy
+// the weights of the tiles on the right and below.
+static inline uint8_t clahe_blend(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t wx, uint32_t wy)
+{
+    uint32_t top = a * (256 - wx) + b * wx;
+    uint32_t bottom = c * (256 - wx) + d * wx;
+    return (top * (256 - wy) + bottom * wy + 32768) >> 16;
+}
+
+static int clahe_apply(const Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        uint32_t y, bool fast)
+{
+    if (!src.isValid() || !dst.isValid() || clahe.luts == NULL || clahe.rows != clahe.height
+            || src.getWidth() != clahe.width || dst.getWidth() != src.getWidth() || dst.getHeight() != src.getHeight()
+            || y > clahe.height || src.getHeight() > clahe.height - y) {
+        return -1;
+    }
+
+    uint32_t cols = clahe.grid_cols;
+    uint32_t width = clahe.width;
+    for (uint32_t sy = 0; sy < src.getHeight(); sy++, y++) {
+        uint32_t r = clahe_tile(clahe.row_edges, clahe.grid_rows, y);
+        uint32_t wy = clahe_weight(clahe.row_edges, clahe.grid_rows, r, y);
+        uint32_t r1 = (r + 1 < clahe.grid_rows) ? r + 1 : r;
+        const uint8_t *above = clahe.luts + r * cols * 256;
+        const uint8_t *below = clahe.luts + r1 * cols * 256;
+        const uint8_t *s = src.row(sy);
+        uint8_t *d = dst.row(sy);
+
+        if (fast) {
+            // The columns between the centers of two tiles blend the same 4 tables, with the
+            // weights of the columns from the table.
+            for (uint32_t c = 0; c < cols; c++) {
+                uint32_t c1 = (c + 1 < cols) ? c + 1 : c;
+                const uint8_t *a = above + c * 256;
+                const uint8_t *b = above + c1 * 256;
+                const uint8_t *l = below + c * 256;
+                const uint8_t *m = below + c1 * 256;
+                uint32_t x = (c == 0) ? 0 : clahe_center(clahe.col_edges, c);
+                uint32_t x1 = (c + 1 == cols) ? width : clahe_center(clahe.col_edges, c + 1);
+                for (; x < x1; x++) {
+                    uint32_t v = s[x];
+                    d[x] = clahe_blend(a[v], b[v], l[v], m[v], clahe.col_weights[x], wy);
+                }
+            }
+            continue;
+        }
+
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t c = clahe_tile(clahe.col_edges, cols, x);
+            uint32_t c1 = (c + 1 < cols) ? c + 1 : c;
+            uint32_t wx = clahe_weight(clahe.col_edges, cols, c, x);
+            uint32_t v = s[x];
+            d[x] = clahe_blend(above[c * 256 + v], above[c1 * 256 + v], below[c * 256 + v], below[c1 * 256 + v], wx, wy);
+        }
+    }
+    return 0;
+}
+
+int claheApply(const Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, uint32_t y)
+{
+    return clahe_apply(clahe, src, dst, y, true);
+}
+
+int claheApplyReference(const Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, uint32_t y)
+{
+    return clahe_apply(clahe, src, dst, y, false);
+}
+
+int claheImage(Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst)
+{
+    if (claheUpdate(clahe, src, 0) != 0) {
+        return -1;
+    }
+    return clahe_apply(clahe, src, dst, 0, true);
+}
+
+int frameClahe(FrameBuffer &fb, Clahe &clahe)
+{
+    ImageView<PixelGrayscale> frame(fb);
+    return claheImage(clahe, frame, frame);
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Histogram equalization.
+ */
+
+/**
+ * @file equalize.h
+ * @brief Global histogram equalization and contrast limited adaptive histogram equalization (CLAHE)
+ * of grayscale images, to bring out the details of low contrast frames, e.g. in dim scenes.
+ *
+ * The global equalization maps the pixels through a single 256 entry table built from the
+ * histogram of the frame, so the histogram of a statistics pass can be reused:
+ * @code {.cpp}
+ * ImageStats stats;
+ * if (cam.grabFrame(fb, 3000) == 0 && frameStats(fb, stats) == 0) {
+ *     ImageView<PixelGrayscale> frame(fb);
+ *     equalizeImage(frame, frame, stats.histogram);
+ * }
+ * @endcode
+ * CLAHE builds a table per tile of a grid, from the histogram of the tile clipped to limit the
+ * amplification of the noise, and blends the tables of the 4 nearest tiles for every pixel:
+ * @code {.cpp}
+ * Clahe clahe;
+ * claheBegin(clahe, 320, 240, 8, 8, 3.0f);
+ * if (cam.grabFrame(fb, 3000) == 0) {
+ *     frameClahe(fb, clahe);
+ * }
+ * @endcode
+ * The histograms of the tiles can also be accumulated band by band with claheUpdate(), as the
+ * rows of a frame are received, and the tables of a row of tiles are built as soon as it is
+ * complete. Only the histograms of one row of tiles are kept in memory. The mapping then
+ * takes a single pass, with the weights of the columns looked up in a table.
+ */
+
+#ifndef __EQUALIZE_H
+#define __EQUALIZE_H
+
+#include "imageview.h"
+
+/// Maximum number of columns and rows of the grid of tiles
+#define CLAHE_GRID_MAX          (16)
+/// Default number of columns and rows of the grid of tiles
+#define CLAHE_GRID_DEFAULT      (8)
+/// Default clip limit
+#define CLAHE_CLIP_DEFAULT      (3.0f)
+
+/**
+ * @struct Clahe
+ * @brief State of the contrast limited adaptive histogram equalization.
+ * The frame is divided in a grid of grid_cols x grid_rows tiles of nearly equal sizes.
+ */
+struct Clahe {
+    uint32_t width;             /// Width of the frames
+    uint32_t height;            /// Height of the frames
+    uint32_t grid_cols;         /// Number of columns of the grid of tiles
+    uint32_t grid_rows;         /// Number of rows of the grid of tiles
+    float clip;                 /// Clip limit, as a multiple of the mean count of the histogram bins, 0 for no limit
+    uint32_t rows;              /// Number of rows of the frame accumulated so far
+    uint16_t col_edges[CLAHE_GRID_MAX + 1];     /// First column of every tile column, then the width
+    uint16_t row_edges[CLAHE_GRID_MAX + 1];     /// First row of every tile row, then the height
+    uint32_t *histograms;       /// Histograms of the current row of tiles
+    uint8_t *luts;              /// Tables of the tiles, row by row
+    uint8_t *col_weights;       /// Weight of the table of the tile at the right of every column, out of 256
+};
+
+/**
+ * @brief Build the table of the global histogram equalization of a histogram.
+ *
+ * @param histogram The histogram, e.g. ImageStats::histogram
+ * @param lut The table, 256 entries
+ * @return int 0 on success, -1 on failure
+ */
+int equalizeLut(const uint32_t *histogram, uint8_t *lut);
+
+/**
+ * @brief Equalize the histogram of a grayscale image.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the size of the source, it can be the source
+ * @param histogram The histogram of the source, or of the frame of the source, e.g. ImageStats::histogram
+ * @return int 0 on success, -1 on failure
+ */
+int equalizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, const uint32_t *histogram);
+
+/**
+ * @brief Equalize the histogram of the grayscale frame stored in a frame buffer, in place.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @return int 0 on success, -1 on failure
+ */
+int frameEqualize(FrameBuffer &fb);
+
+/**
+ * @brief Allocate the memory of the CLAHE of frames of a given size.
+ *
+ * @param clahe The state
+ * @param width The width of the frames
+ * @param height The height of the frames
+ * @param grid_cols The number of columns of tiles, up to CLAHE_GRID_MAX (default: CLAHE_GRID_DEFAULT)
+ * @param grid_rows The number of rows of tiles, up to CLAHE_GRID_MAX (default: CLAHE_GRID_DEFAULT)
+ * @param clip The clip limit, as a multiple of the mean count of the histogram bins, 0 for no limit
+ * (default: CLAHE_CLIP_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int claheBegin(Clahe &clahe, uint32_t width, uint32_t height, uint32_t grid_cols=CLAHE_GRID_DEFAULT,
+        uint32_t grid_rows=CLAHE_GRID_DEFAULT, float clip=CLAHE_CLIP_DEFAULT);
+
+/**
+ * @brief Free the memory of the CLAHE.
+ *
+ * @param clahe The state
+ */
+void claheEnd(Clahe &clahe);
+
+/**
+ * @brief Accumulate the histograms of the tiles of a band of rows of a grayscale frame.
+ * The bands must be passed in order, the first band (y = 0) starts a new frame.
+ *
+ * @param clahe The state
+ * @param band The band, as wide as the frame
+ * @param y The index in the frame of the first row of the band
+ * @return int 0 on success, -1 on failure
+ */
+int claheUpdate(Clahe &clahe, const ImageView<PixelGrayscale> &band, uint32_t y);
+
+/**
+ * @brief Map a band of rows of a grayscale frame once all the rows of the frame were accumulated.
+ *
+ * @param clahe The state
+ * @param src The source band, as wide as the frame
+ * @param dst The destination band, of the size of the source, it can be the source
+ * @param y The index in the frame of the first row of the band (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int claheApply(const Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, uint32_t y=0);
+
+/**
+ * @brief Apply the CLAHE to a grayscale frame: accumulate the histograms, then map the frame.
+ *
+ * @param clahe The state
+ * @param src The source frame
+ * @param dst The destination frame, of the size of the source, it can be the source
+ * @return int 0 on success, -1 on failure
+ */
+int claheImage(Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst);
+
+/**
+ * @brief Apply the CLAHE to the grayscale frame stored in a frame buffer, in place.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param clahe The state, for frames of the size of the frame
+ * @return int 0 on success, -1 on failure
+ */
+int frameClahe(FrameBuffer &fb, Clahe &clahe);
+
+/*
+ * Portable scalar reference implementations.
+ * They are always available, so the results of the accelerated kernels can be checked against them.
+ */
+int equalizeImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, const uint32_t *histogram);
+int claheApplyReference(const Clahe &clahe, const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, uint32_t y=0);
+
+#endif /* __EQUALIZE_H */
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Block matching optical flow.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "flow.h"
+
+// SAD of a block, abandoned as soon as it gets higher than limit.
+static uint32_t flow_sad(const ImageView<PixelGrayscale> &a, uint32_t ax, uint32_t ay,
+        const ImageView<PixelGrayscale> &b, uint32_t bx, uint32_t by, uint32_t block, uint32_t limit, bool fast)
+{
+    uint32_t sad = 0;
+    for (uint32_t y = 0; y < block && sad <= limit; y++) {
+        const uint8_t *pa = a.row(ay + y) + ax;
+        const uint8_t *pb = b.row(by + y) + bx;
+        uint32_t x = 0;
+
+        #if IMG_USE_DSP
+        if (fast) {
+            for (; x < block; x += 4) {
+                sad = __USADA8(img_read32(pa + x), img_read32(pb + x), sad);
+            }
+        }
+        #endif
+
+        for (; x < block; x++) {
+            sad += (pa[x] > pb[x]) ? pa[x] - pb[x] : pb[x] - pa[x];
+        }
+    }
+    return sad;
+}
+
+static int block_flow(const ImageView<PixelGrayscale> &prev, const ImageView<PixelGrayscale> &cur,
+        FlowVector *vectors, uint32_t block, uint32_t search, bool fast)
+{
+    if (!prev.isValid() || !cur.isValid() || vectors == NULL
+            || prev.getWidth() != cur.getWidth() || prev.getHeight() != cur.getHeight()
+            || block == 0 || block % 4 || block > FLOW_BLOCK_MAX || search > FLOW_SEARCH_MAX
+            || cur.getWidth() < block || cur.getHeight() < block) {
+        return -1;
+    }
+
+    int32_t width = cur.getWidth();
+    int32_t height = cur.getHeight();
+    uint32_t cols = width / block;
+    uint32_t rows = height / block;
+    int32_t s = search;
+
+    for (uint32_t r = 0; r < rows; r++) {
+        for (uint32_t c = 0; c < cols; c++) {
+            int32_t bx = c * block;
+            int32_t by = r * block;
+            // No motion first, it wins the ties with the other displacements of the same length
+            uint32_t best = flow_sad(cur, bx, by, prev, bx, by, block, UINT32_MAX, fast);
+            int32_t best_dx = 0;
+            int32_t best_dy = 0;
+            int32_t best_dist = 0;
+
+            for (int32_t dy = -s; dy <= s; dy++) {
+                // The block moved by (dx, dy), it was at (bx - dx, by - dy) in the previous frame.
+                int32_t py = by - dy;
+                if (py < 0 || py + (int32_t) block > height) {
+                    continue;
+                }
+                for (int32_t dx = -s; dx <= s; dx++) {
+                    int32_t px = bx - dx;
+                    if ((dx == 0 && dy == 0) || px < 0 || px + (int32_t) block > width) {
+                        continue;
+                    }
+                    int32_t dist = dx * dx + dy * dy;
+                    uint32_t sad = flow_sad(cur, bx, by, prev, px, py, block, best, fast);
+                    if (sad < best || (sad == best && dist < best_dist)) {
+                        best = sad;
+                        best_dx = dx;
+                        best_dy = dy;
+                        best_dist = dist;
+                    }
+                }
+            }
+
+            FlowVector &v = vectors[r * cols + c];
+            v.dx = best_dx;
+            v.dy = best_dy;
+            v.sad = best;
+        }
+    }
+    return rows * cols;
+}
+
+int blockFlow(const ImageView<PixelGrayscale> &prev, const ImageView<PixelGrayscale> &cur,
+        FlowVector *vectors, uint32_t block, uint32_t search)
+{
+    return block_flow(prev, cur, vectors, block, search, true);
+}
+
+int blockFlowReference(const ImageView<PixelGrayscale> &prev, const ImageView<PixelGrayscale> &cur,
+        FlowVector *vectors, uint32_t block, uint32_t search)
+{
+    return block_flow(prev, cur, vectors, block, search, false);
+}
+
+// Median of the components of the vectors, from their histogram.
+static int32_t flow_median(const FlowVector *vectors, uint32_t count, bool vertical)
+{
+    uint32_t hist[2 * FLOW_SEARCH_MAX + 1] = { 0 };
+    for (uint32_t i = 0; i < count; i++) {
+        hist[(vertical ? vectors[i].dy : vectors[i].dx) + FLOW_SEARCH_MAX]++;
+    }
+    uint32_t n = 0;
+    for (int32_t i = 0; i < 2 * FLOW_SEARCH_MAX + 1; i++) {
+        n += hist[i];
+        if (2 * n >= count) {
+            return i - FLOW_SEARCH_MAX;
+        }
+    }
+    return 0;
+}
+
+int flowGlobalMotion(const FlowVector *vectors, uint32_t count, int32_t *dx, int32_t *dy)
+{
+    if (vectors == NULL || count == 0 || dx == NULL || dy == NULL) {
+        return -1;
+    }
+    *dx = flow_median(vectors, count, false);
+    *dy = flow_median(vectors, count, true);
+    return 0;
+}
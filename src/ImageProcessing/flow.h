@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Block matching optical flow.
+ */
+
+/**
+ * @file flow.h
+ * @brief Coarse optical flow between two grayscale frames, one motion vector per block.
+ *
+ * The current frame is divided in blocks, and every block is searched for in the previous frame
+ * within a window of +/- search pixels. The vector of a block is the displacement with the
+ * lowest sum of absolute differences (SAD), the motion of the block from the previous frame:
+ * @code {.cpp}
+ * FlowVector vectors[(320 / 16) * (240 / 16)];
+ * if (cam.grabFrame(fb[cur], 3000) == 0) {
+ *     ImageView<PixelGrayscale> prev(fb[!cur]), frame(fb[cur]);
+ *     int n = blockFlow(prev, frame, vectors, 16, 4);
+ *     int32_t dx, dy;
+ *     flowGlobalMotion(vectors, n, &dx, &dy);
+ *     cur = !cur;
+ * }
+ * @endcode
+ * To follow faster motion at a lower cost, the frames can be binned first with binImage(),
+ * the vectors are then in binned pixels.
+ *
+ * The SAD of 4 pixels is computed at once with __USADA8, and a candidate is dropped as soon
+ * as its partial SAD is higher than the best one. A candidate with the same SAD as the best
+ * one wins if its displacement is shorter.
+ */
+
+#ifndef __FLOW_H
+#define __FLOW_H
+
+#include "imageview.h"
+
+/// Default block size
+#define FLOW_BLOCK_DEFAULT      (16)
+/// Default search range
+#define FLOW_SEARCH_DEFAULT     (4)
+/// Maximum block size
+#define FLOW_BLOCK_MAX          (64)
+/// Maximum search range
+#define FLOW_SEARCH_MAX         (16)
+
+/**
+ * @struct FlowVector
+ * @brief The motion of a block.
+ */
+struct FlowVector {
+    int8_t dx;                  /// Horizontal motion, positive to the right
+    int8_t dy;                  /// Vertical motion, positive to the bottom
+    uint32_t sad;               /// Sum of absolute differences of the best match, lower is more reliable
+};
+
+/**
+ * @brief Estimate the motion of the blocks of a grayscale frame from the previous frame.
+ * The vectors are stored row by row, (width / block) x (height / block) vectors, the pixels
+ * to the right and the bottom of the last blocks are ignored.
+ * If several displacements match equally well, the shortest one is chosen.
+ *
+ * @param prev The previous frame
+ * @param cur The current frame, of the size of the previous frame
+ * @param vectors The motion vectors
+ * @param block The block size, a multiple of 4 up to FLOW_BLOCK_MAX (default: FLOW_BLOCK_DEFAULT)
+ * @param search The search range, up to FLOW_SEARCH_MAX (default: FLOW_SEARCH_DEFAULT)
+ * @return int The number of vectors, -1 on failure
+ */
+int blockFlow(const ImageView<PixelGrayscale> &prev, const ImageView<PixelGrayscale> &cur,
+        FlowVector *vectors, uint32_t block=FLOW_BLOCK_DEFAULT, uint32_t search=FLOW_SEARCH_DEFAULT);
+
+/**
+ * @brief Estimate the global motion, e.g. the camera shake, as the median of the motion vectors.
+ *
+ * @param vectors The motion vectors
+ * @param count The number of vectors
+ * @param dx The horizontal motion
+ * @param dy The vertical motion
+ * @return int 0 on success, -1 on failure
+ */
+int flowGlobalMotion(const FlowVector *vectors, uint32_t count, int32_t *dx, int32_t *dy);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int blockFlowReference(const ImageView<PixelGrayscale> &prev, const ImageView<PixelGrayscale> &cur,
+        FlowVector *vectors, uint32_t block=FLOW_BLOCK_DEFAULT, uint32_t search=FLOW_SEARCH_DEFAULT);
+
+#endif /* __FLOW_H */
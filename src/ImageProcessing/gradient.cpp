@@ -0,0 +1,220 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image gradient kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "gradient.h"
+
+// Outer and center weights of the smoothing of the kernels
+static const int32_t gradient_weights[GRADIENT_MAX][2] = {
+    { 1, 2 },       // GRADIENT_SOBEL
+    { 3, 10 },      // GRADIENT_SCHARR
+};
+
+// Output rows of a gradient, the pointers that are not needed are NULL.
+struct GradientRow {
+    int16_t *gx;
+    int16_t *gy;
+    uint8_t *mag;
+};
+
+static inline uint8_t gradient_mag(int32_t gx, int32_t gy, int32_t kernel)
+{
+    int32_t m = ((gx < 0) ? -gx : gx) + ((gy < 0) ? -gy : gy);
+    if (kernel == GRADIENT_SCHARR) {
+        m >>= 2;
+    }
+    return (m > 255) ? 255 : m;
+}
+
+// Gradient of the pixel x, the columns outside of the row are replicated from the edges.
+static void gradient_pixel(const uint8_t *const *rows, uint32_t width, uint32_t x, int32_t kernel,
+        const GradientRow &out)
+{
+    int32_t a = gradient_weights[kernel][0];
+    int32_t b = gradient_weights[kernel][1];
+    int32_t v[3], d[3];
+    for (int32_t i = 0; i < 3; i++) {
+        int32_t cx = (int32_t) x + i - 1;
+        cx = (cx < 0) ? 0 : ((cx >= (int32_t) width) ? width - 1 : cx);
+        v[i] = a * (rows[0][cx] + rows[2][cx]) + b * rows[1][cx];
+        d[i] = rows[2][cx] - rows[0][cx];
+    }
+    int32_t gx = v[2] - v[0];
+    int32_t gy = a * (d[0] + d[2]) + b * d[1];
+    if (out.gx) {
+        out.gx[x] = gx;
+        out.gy[x] = gy;
+    }
+    if (out.mag) {
+        out.mag[x] = gradient_mag(gx, gy, kernel);
+    }
+}
+
+#if IMG_USE_DSP
+// Vertical smoothing and difference of the 4 columns from x, the even columns in
+// the halfwords of v[0] and d[0], the odd columns in v[1] and d[1].
+static inline void gradient_columns(const uint8_t *const *rows, uint32_t x, bool scharr, uint32_t *v, uint32_t *d)
+{
+    uint32_t w0 = img_read32(rows[0] + x);
+    uint32_t w1 = img_read32(rows[1] + x);
+    uint32_t w2 = img_read32(rows[2] + x);
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t p0 = __UXTB16(__ROR(w0, 8 * i));
+        uint32_t p1 = __UXTB16(__ROR(w1, 8 * i));
+        uint32_t p2 = __UXTB16(__ROR(w2, 8 * i));
+        // The smoothing is positive and fits the halfwords, it can be multiplied as a word
+        v[i] = scharr ? (p0 + p2) * 3 + p1 * 10 : (p0 + p2) + (p1 << 1);
+        d[i] = __SSUB16(p2, p0);
+    }
+}
+
+// Absolute value of both signed halfwords of a word.
+static inline uint32_t gradient_abs16(uint32_t v)
+{
+    uint32_t sign = ((v >> 15) & 0x00010001) * 0xFFFF;
+    return __SSUB16(v ^ sign, sign);
+}
+
+// Compute the gradients of the inner pixels of a row, 4 pixels per iteration.
+// Returns the first pixel that is not computed.
+static uint32_t gradient_row_dsp(const uint8_t *const *rows, uint32_t width, int32_t kernel, const GradientRow &out)
+{
+    bool scharr = (kernel == GRADIENT_SCHARR);
+    uint32_t x = 1;
+    for (; x + 5 <= width; x += 4) {
+        // Columns x - 1 to x + 2 and x + 1 to x + 4
+        uint32_t vm[2], dm[2], vp[2], dp[2];
+        gradient_columns(rows, x - 1, scharr, vm, dm);
+        gradient_columns(rows, x + 1, scharr, vp, dp);
+
+        // Pixels x and x + 2, then x + 1 and x + 3
+        uint32_t gx[2], gy[2];
+        gx[0] = __SSUB16(vp[0], vm[0]);
+        gx[1] = __SSUB16(vp[1], vm[1]);
+        uint32_t outer[2] = { __SADD16(dm[0], dp[0]), __SADD16(dm[1], dp[1]) };
+        uint32_t center[2] = { dm[1], dp[0] };
+        for (uint32_t i = 0; i < 2; i++) {
+            uint32_t c2 = __SADD16(center[i], center[i]);
+            if (scharr) {
+                uint32_t c8 = __SADD16(c2, c2);
+                c8 = __SADD16(c8, c8);
+                gy[i] = __SADD16(__SADD16(__SADD16(outer[i], outer[i]), outer[i]), __SADD16(c8, c2));
+            } else {
+                gy[i] = __SADD16(outer[i], c2);
+            }
+        }
+
+        if (out.gx) {
+            img_write32(out.gx + x, __PKHBT(gx[0], gx[1], 16));
+            img_write32(out.gx + x + 2, __PKHTB(gx[1], gx[0], 16));
+            img_write32(out.gy + x, __PKHBT(gy[0], gy[1], 16));
+            img_write32(out.gy + x + 2, __PKHTB(gy[1], gy[0], 16));
+        }
+        if (out.mag) {
+            uint32_t m[2];
+            for (uint32_t i = 0; i < 2; i++) {
+                m[i] = __UADD16(gradient_abs16(gx[i]), gradient_abs16(gy[i]));
+                if (scharr) {
+                    m[i] = (m[i] >> 2) & 0x3FFF3FFF;
+                }
+                m[i] = __USAT16(m[i], 8);
+            }
+            img_write32(out.mag + x, m[0] | (m[1] << 8));
+        }
+    }
+    return x;
+}
+#endif
+
+template <typename DstFormat>
+static int gradient_image(const ImageView<PixelGrayscale> &src, const ImageView<DstFormat> *gx,
+        const ImageView<DstFormat> *gy, int32_t kernel, uint32_t y, uint32_t h, bool fast)
+{
+    if (!src.isValid() || kernel < 0 || kernel >= GRADIENT_MAX || y > src.getHeight()) {
+        return -1;
+    }
+    const ImageView<DstFormat> *dsts[2] = { gx, gy };
+    for (uint32_t i = 0; i < 2; i++) {
+        if (dsts[i] && (!dsts[i]->isValid() || dsts[i]->getWidth() != src.getWidth()
+                    || dsts[i]->getHeight() != src.getHeight()
+                    || (const void *) dsts[i]->getData() == (const void *) src.getData())) {
+            return -1;
+        }
+    }
+    if (h == 0) {
+        h = src.getHeight() - y;
+    }
+    if (h > src.getHeight() - y) {
+        return -1;
+    }
+
+    uint32_t width = src.getWidth();
+    uint32_t last = src.getHeight() - 1;
+    for (uint32_t dy = y; dy < y + h; dy++) {
+        // Sliding window of the rows above, at and below the output row
+        const uint8_t *rows[3] = {
+            src.row(dy ? dy - 1 : 0),
+            src.row(dy),
+            src.row((dy < last) ? dy + 1 : last),
+        };
+        GradientRow out = { NULL, NULL, NULL };
+        if (DstFormat::format == CAMERA_INT16) {
+            out.gx = (int16_t *) gx->row(dy);
+            out.gy = (int16_t *) gy->row(dy);
+        } else {
+            out.mag = (uint8_t *) gx->row(dy);
+        }
+
+        uint32_t x = 0;
+        #if IMG_USE_DSP
+        if (fast && width >= 6) {
+            gradient_pixel(rows, width, 0, kernel, out);
+            x = gradient_row_dsp(rows, width, kernel, out);
+        }
+        #endif
+        for (; x < width; x++) {
+            gradient_pixel(rows, width, x, kernel, out);
+        }
+    }
+    return 0;
+}
+
+int gradientImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelInt16> &gx,
+        const ImageView<PixelInt16> &gy, int32_t kernel, uint32_t y, uint32_t h)
+{
+    return gradient_image(src, &gx, &gy, kernel, y, h, true);
+}
+
+int gradientMagnitude(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t kernel, uint32_t y, uint32_t h)
+{
+    return gradient_image<PixelGrayscale>(src, &dst, NULL, kernel, y, h, true);
+}
+
+int gradientImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelInt16> &gx,
+        const ImageView<PixelInt16> &gy, int32_t kernel, uint32_t y, uint32_t h)
+{
+    return gradient_image(src, &gx, &gy, kernel, y, h, false);
+}
+
+int gradientMagnitudeReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t kernel, uint32_t y, uint32_t h)
+{
+    return gradient_image<PixelGrayscale>(src, &dst, NULL, kernel, y, h, false);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image gradient kernels.
+ */
+
+/**
+ * @file gradient.h
+ * @brief 3x3 Sobel and Scharr gradients and edge magnitude of grayscale images.
+ *
+ * Gx is the horizontal derivative, positive when the image gets brighter to the right,
+ * Gy the vertical derivative, positive when it gets brighter to the bottom. The pixels
+ * outside of the image are replicated from the edges:
+ * @code {.cpp}
+ * ImageView<PixelGrayscale> frame(fb);
+ * ImageView<PixelGrayscale> edges(edge_buf, frame.getWidth(), frame.getHeight());
+ * gradientMagnitude(frame, edges, GRADIENT_SOBEL);
+ * @endcode
+ * Every output row is computed from the 3 source rows around it, so a frame can be processed
+ * by bands of rows (y, h) as they are received, once the row after the band is there too.
+ *
+ * The kernels are separable: the vertical smoothing and difference of 2 pixels are computed at
+ * once in the halfwords of a word, then combined horizontally with the 16-bit SIMD instructions.
+ */
+
+#ifndef __GRADIENT_H
+#define __GRADIENT_H
+
+#include "imageview.h"
+
+/// Gradient kernels
+enum {
+    GRADIENT_SOBEL  = 0,    /* [1 2 1] smoothing */
+    GRADIENT_SCHARR = 1,    /* [3 10 3] smoothing, more accurate orientation */
+    GRADIENT_MAX            /* Sentinel value */
+};
+
+/**
+ * @brief Compute the horizontal and vertical gradients of a grayscale image.
+ * Sobel gradients range from -1020 to 1020, Scharr gradients from -4080 to 4080.
+ *
+ * @param src The source image
+ * @param gx The horizontal gradient, of the size of the source image
+ * @param gy The vertical gradient, of the size of the source image
+ * @param kernel The gradient kernel, GRADIENT_SOBEL or GRADIENT_SCHARR (default: GRADIENT_SOBEL)
+ * @param y The first row to compute, the row above must be in the source image unless it is 0 (default: 0)
+ * @param h The number of rows to compute, 0 for all the rows from y (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int gradientImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelInt16> &gx,
+        const ImageView<PixelInt16> &gy, int32_t kernel=GRADIENT_SOBEL, uint32_t y=0, uint32_t h=0);
+
+/**
+ * @brief Compute the edge magnitude |Gx| + |Gy| of a grayscale image, saturated to 255.
+ * The Scharr magnitude is divided by 4, so that it has the scale of the Sobel magnitude.
+ *
+ * @param src The source image
+ * @param dst The magnitude, of the size of the source image, not in place
+ * @param kernel The gradient kernel, GRADIENT_SOBEL or GRADIENT_SCHARR (default: GRADIENT_SOBEL)
+ * @param y The first row to compute (default: 0)
+ * @param h The number of rows to compute, 0 for all the rows from y (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int gradientMagnitude(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t kernel=GRADIENT_SOBEL, uint32_t y=0, uint32_t h=0);
+
+/*
+ * Portable scalar reference implementations.
+ * They are always available, so the results of the accelerated kernels can be checked against them.
+ */
+int gradientImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelInt16> &gx,
+        const ImageView<PixelInt16> &gy, int32_t kernel=GRADIENT_SOBEL, uint32_t y=0, uint32_t h=0);
+int gradientMagnitudeReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t kernel=GRADIENT_SOBEL, uint32_t y=0, uint32_t h=0);
+
+#endif /* __GRADIENT_H */
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Integral images.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "integral.h"
+
+uint32_t integralBufferSize(uint32_t width, uint32_t height, bool squared)
+{
+    return (width + 1) * (height + 1) * sizeof(uint32_t) * (squared ? 2 : 1);
+}
+
+int integralBegin(IntegralImage &ii, uint32_t width, uint32_t height, bool squared, void *buffer)
+{
+    if (width == 0 || height == 0 || ((uintptr_t) buffer & 3)) {
+        return -1;
+    }
+
+    memset(&ii, 0, sizeof(ii));
+    ii.allocated = (buffer == NULL);
+    if (buffer == NULL) {
+        buffer = malloc(integralBufferSize(width, height, squared));
+        if (buffer == NULL) {
+            return -1;
+        }
+    }
+    ii.width = width;
+    ii.height = height;
+    ii.sum = (uint32_t *) buffer;
+    if (squared) {
+        ii.sum_sq = ii.sum + (width + 1) * (height + 1);
+    }
+
+    // The first row and column are always 0, the other entries are set by the rows of the image.
+    for (uint32_t y = 1; y <= height; y++) {
+        ii.sum[y * (width + 1)] = 0;
+        if (squared) {
+            ii.sum_sq[y * (width + 1)] = 0;
+        }
+    }
+    memset(ii.sum, 0, (width + 1) * sizeof(uint32_t));
+    if (squared) {
+        memset(ii.sum_sq, 0, (width + 1) * sizeof(uint32_t));
+    }
+    return 0;
+}
+
+void integralEnd(IntegralImage &ii)
+{
+    if (ii.allocated) {
+        free(ii.sum);
+    }
+    memset(&ii, 0, sizeof(ii));
+}
+
+// Add a row: every entry is the entry above plus the sum of the row up to the pixel.
+static void integral_row(const uint8_t *p, const uint32_t *above, uint32_t *out, uint32_t width, bool fast)
+{
+    uint32_t sum = 0;
+    uint32_t x = 0;
+
+    if (fast) {
+        // One load for 4 pixels
+        for (; x + 4 <= width; x += 4) {
+            uint32_t w = img_read32(p + x);
+            sum += w & 0xFF;
+            out[x + 0] = above[x + 0] + sum;
+            sum += (w >> 8) & 0xFF;
+            out[x + 1] = above[x + 1] + sum;
+            sum += (w >> 16) & 0xFF;
+            out[x + 2] = above[x + 2] + sum;
+            sum += w >> 24;
+            out[x + 3] = above[x + 3] + sum;
+        }
+    }
+
+    for (; x < width; x++) {
+        sum += p[x];
+        out[x] = above[x] + sum;
+    }
+}
+
+static void integral_row_sq(const uint8_t *p, const uint32_t *above, uint32_t *out, uint32_t width, bool fast)
+{
+    uint32_t sum = 0;
+    uint32_t x = 0;
+
+    if (fast) {
+        for (; x + 4 <= width; x += 4) {
+            uint32_t w = img_read32(p + x);
+            uint32_t p0 = w & 0xFF;
+            uint32_t p1 = (w >> 8) & 0xFF;
+            uint32_t p2 = (w >> 16) & 0xFF;
+            uint32_t p3 = w >> 24;
+            sum += p0 * p0;
+            out[x + 0] = above[x + 0] + sum;
+            sum += p1 * p1;
+            out[x + 1] = above[x + 1] + sum;
+            sum += p2 * p2;
+            out[x + 2] = above[x + 2] + sum;
+            sum += p3 * p3;
+            out[x + 3] = above[x + 3] + sum;
+        }
+    }
+
+    for (; x < width; x++) {
+        sum += p[x] * p[x];
+        out[x] = above[x] + sum;
+    }
+}
+
+static int integral_image(IntegralImage &ii, const ImageView<PixelGrayscale> &src, uint32_t y, bool fast)
+{
+    if (!src.isValid() || ii.sum == NULL || src.getWidth() != ii.width
+            || y > ii.height || src.getHeight() > ii.height - y) {
+        return -1;
+    }
+
+    uint32_t stride = ii.width + 1;
+    for (uint32_t sy = 0; sy < src.getHeight(); sy++) {
+        // Entries of the row below the pixels, from the second column
+        uint32_t offset = (y + sy + 1) * stride + 1;
+        const uint8_t *p = src.row(sy);
+        integral_row(p, ii.sum + offset - stride, ii.sum + offset, ii.width, fast);
+        if (ii.sum_sq) {
+            integral_row_sq(p, ii.sum_sq + offset - stride, ii.sum_sq + offset, ii.width, fast);
+        }
+    }
+    return 0;
+}
+
+int integralImage(IntegralImage &ii, const ImageView<PixelGrayscale> &src, uint32_t y)
+{
+    return integral_image(ii, src, y, true);
+}
+
+int integralImageReference(IntegralImage &ii, const ImageView<PixelGrayscale> &src, uint32_t y)
+{
+    return integral_image(ii, src, y, false);
+}
+
+int frameIntegral(FrameBuffer &fb, IntegralImage &ii, uint32_t x, uint32_t y)
+{
+    ImageView<PixelGrayscale> frame(fb);
+    return integral_image(ii, frame.subView(x, y, ii.width, ii.height), 0, true);
+}
+
+float integralVariance(const IntegralImage &ii, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    if (ii.sum_sq == NULL || w == 0 || h == 0) {
+        return 0.0f;
+    }
+    float n = (float) w * h;
+    float mean = integralSum(ii, x, y, w, h) / n;
+    float variance = integralSumSq(ii, x, y, w, h) / n - mean * mean;
+    return (variance > 0.0f) ? variance : 0.0f;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Integral images.
+ */
+
+/**
+ * @file integral.h
+ * @brief Integral images (summed-area tables) of grayscale images, for constant time box sums.
+ *
+ * The entry (x, y) of the table is the sum of the pixels above and to the left of the pixel
+ * (x, y). The table has a first row and column of zeros, so it is (width + 1) x (height + 1)
+ * entries, and the sum of any box takes 4 lookups:
+ * @code {.cpp}
+ * IntegralImage ii;
+ * integralBegin(ii, 320, 240, true, SDRAM.malloc(integralBufferSize(320, 240, true)));
+ * if (cam.grabFrame(fb, 3000) == 0 && frameIntegral(fb, ii) == 0) {
+ *     uint32_t sum = integralSum(ii, 10, 10, 24, 24);
+ *     float variance = integralVariance(ii, 10, 10, 24, 24);
+ * }
+ * @endcode
+ * The entries are 32-bit and wrap around, the box sums are still exact as long as they fit
+ * 32 bits: the sums of the squares of boxes up to INTEGRAL_BOX_MAX pixels.
+ *
+ * The table is built in a single pass over the rows, every row only needs the row above it,
+ * so the rows can also be added band by band as they are received.
+ */
+
+#ifndef __INTEGRAL_H
+#define __INTEGRAL_H
+
+#include "imageview.h"
+
+/// Maximum number of pixels of a box for which the sum of the squares is exact
+#define INTEGRAL_BOX_MAX        (66051)
+
+/**
+ * @struct IntegralImage
+ * @brief Integral image and integral image of the squares of a grayscale image.
+ */
+struct IntegralImage {
+    uint32_t *sum;              /// Sums of the pixels, (width + 1) x (height + 1) entries row by row
+    uint32_t *sum_sq;           /// Sums of the squares of the pixels, the same layout, NULL if not computed
+    uint32_t width;             /// Width of the image
+    uint32_t height;            /// Height of the image
+    bool allocated;             /// The tables were allocated by integralBegin()
+};
+
+/**
+ * @brief Get the size of the memory needed by the tables.
+ *
+ * @param width The width of the image
+ * @param height The height of the image
+ * @param squared true to compute the sums of the squares too
+ * @return uint32_t The size in bytes
+ */
+uint32_t integralBufferSize(uint32_t width, uint32_t height, bool squared);
+
+/**
+ * @brief Set up the tables of an integral image.
+ *
+ * @param ii The integral image
+ * @param width The width of the image
+ * @param height The height of the image
+ * @param squared true to compute the sums of the squares too (default: false)
+ * @param buffer Memory for the tables, integralBufferSize() bytes aligned on 4 bytes,
+ * e.g. in the SDRAM, or NULL to allocate it (default: NULL)
+ * @return int 0 on success, -1 on failure
+ */
+int integralBegin(IntegralImage &ii, uint32_t width, uint32_t height, bool squared=false, void *buffer=NULL);
+
+/**
+ * @brief Free the tables if they were allocated by integralBegin().
+ *
+ * @param ii The integral image
+ */
+void integralEnd(IntegralImage &ii);
+
+/**
+ * @brief Compute the integral image of a grayscale image, or of a band of its rows.
+ * The bands must be computed in order from the first row.
+ *
+ * @param ii The integral image, of the size of the image
+ * @param src The image, or a band of rows as wide as the image, e.g. a subView() for a region of interest
+ * @param y The index in the image of the first row of the band (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int integralImage(IntegralImage &ii, const ImageView<PixelGrayscale> &src, uint32_t y=0);
+
+/**
+ * @brief Compute the integral image of a region of interest of the grayscale frame stored in a frame buffer.
+ * The region has the size of the integral image.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param ii The integral image
+ * @param x The X coordinate of the region of interest (default: 0)
+ * @param y The Y coordinate of the region of interest (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int frameIntegral(FrameBuffer &fb, IntegralImage &ii, uint32_t x=0, uint32_t y=0);
+
+/**
+ * @brief Get the sum of the pixels of a box.
+ *
+ * @param ii The integral image
+ * @param x The X coordinate of the box
+ * @param y The Y coordinate of the box
+ * @param w The width of the box, x + w up to the width of the image
+ * @param h The height of the box, y + h up to the height of the image
+ * @return uint32_t The sum
+ */
+static inline uint32_t integralSum(const IntegralImage &ii, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    const uint32_t *top = ii.sum + y * (ii.width + 1) + x;
+    const uint32_t *bottom = top + h * (ii.width + 1);
+    return bottom[w] - bottom[0] - top[w] + top[0];
+}
+
+/**
+ * @brief Get the sum of the squares of the pixels of a box, up to INTEGRAL_BOX_MAX pixels.
+ *
+ * @param ii The integral image, with the sums of the squares
+ * @param x The X coordinate of the box
+ * @param y The Y coordinate of the box
+ * @param w The width of the box, x + w up to the width of the image
+ * @param h The height of the box, y + h up to the height of the image
+ * @return uint32_t The sum of the squares
+ */
+static inline uint32_t integralSumSq(const IntegralImage &ii, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    const uint32_t *top = ii.sum_sq + y * (ii.width + 1) + x;
+    const uint32_t *bottom = top + h * (ii.width + 1);
+    return bottom[w] - bottom[0] - top[w] + top[0];
+}
+
+/**
+ * @brief Get the variance of the pixels of a box, up to INTEGRAL_BOX_MAX pixels.
+ *
+ * @param ii The integral image, with the sums of the squares
+ * @param x The X coordinate of the box
+ * @param y The Y coordinate of the box
+ * @param w The width of the box
+ * @param h The height of the box
+ * @return float The variance, 0 if the box is empty or there are no sums of the squares
+ */
+float integralVariance(const IntegralImage &ii, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int integralImageReference(IntegralImage &ii, const ImageView<PixelGrayscale> &src, uint32_t y=0);
+
+#endif /* __INTEGRAL_H */
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Bit-packed binary masks.
+ */
+
+/**
+ * @file mask.h
+ * @brief Layout of the bit-packed binary masks.
+ *
+ * A mask stores one bit per pixel, 1 for the pixels that are set. Every row starts on a 32-bit
+ * word and takes MASK_ROW_WORDS(width) words. The pixel x of a row is the bit x % 32 of the word
+ * x / 32, the least significant bit first. The bits after the last pixel of a row are 0.
+ *
+ * The masks of the same size can be combined 32 pixels at a time:
+ * @code {.cpp}
+ * static uint32_t moving[MASK_ROW_WORDS(320) * 240], bright[MASK_ROW_WORDS(320) * 240];
+ * maskAnd(moving, moving, bright, 320, 240);
+ * uint32_t count = maskCount(moving, 320, 240);
+ * @endcode
+ */
+
+#ifndef __MASK_H
+#define __MASK_H
+
+#include <stdint.h>
+
+/// Number of 32-bit words of a row of a mask
+#define MASK_ROW_WORDS(width)       (((width) + 31) / 32)
+/// Size of a mask in bytes
+#define MASK_BYTES(width, height)   (MASK_ROW_WORDS(width) * (height) * sizeof(uint32_t))
+
+/**
+ * @brief Get a pixel of a mask.
+ *
+ * @param mask The mask
+ * @param width The width of the mask in pixels
+ * @param x The X coordinate of the pixel
+ * @param y The Y coordinate of the pixel
+ * @return true if the pixel is set
+ */
+static inline bool maskGet(const uint32_t *mask, uint32_t width, uint32_t x, uint32_t y)
+{
+    return (mask[y * MASK_ROW_WORDS(width) + x / 32] >> (x % 32)) & 1;
+}
+
+/**
+ * @brief Set a pixel of a mask.
+ *
+ * @param mask The mask
+ * @param width The width of the mask in pixels
+ * @param x The X coordinate of the pixel
+ * @param y The Y coordinate of the pixel
+ */
+static inline void maskSet(uint32_t *mask, uint32_t width, uint32_t x, uint32_t y)
+{
+    mask[y * MASK_ROW_WORDS(width) + x / 32] |= 1u << (x % 32);
+}
+
+/**
+ * @brief Combine two masks with a bitwise AND: the pixels set in both masks are set.
+ *
+ * @param dst The destination mask, it can be one of the source masks
+ * @param a The first mask
+ * @param b The second mask
+ * @param width The width of the masks in pixels
+ * @param height The height of the masks
+ */
+static inline void maskAnd(uint32_t *dst, const uint32_t *a, const uint32_t *b, uint32_t width, uint32_t height)
+{
+    for (uint32_t i = 0; i < MASK_ROW_WORDS(width) * height; i++) {
+        dst[i] = a[i] & b[i];
+    }
+}
+
+/**
+ * @brief Combine two masks with a bitwise OR: the pixels set in either mask are set.
+ *
+ * @param dst The destination mask, it can be one of the source masks
+ * @param a The first mask
+ * @param b The second mask
+ * @param width The width of the masks in pixels
+ * @param height The height of the masks
+ */
+static inline void maskOr(uint32_t *dst, const uint32_t *a, const uint32_t *b, uint32_t width, uint32_t height)
+{
+    for (uint32_t i = 0; i < MASK_ROW_WORDS(width) * height; i++) {
+        dst[i] = a[i] | b[i];
+    }
+}
+
+/**
+ * @brief Combine two masks with a bitwise XOR: the pixels set in only one of the masks are set.
+ *
+ * @param dst The destination mask, it can be one of the source masks
+ * @param a The first mask
+ * @param b The second mask
+ * @param width The width of the masks in pixels
+ * @param height The height of the masks
+ */
+static inline void maskXor(uint32_t *dst, const uint32_t *a, const uint32_t *b, uint32_t width, uint32_t height)
+{
+    for (uint32_t i = 0; i < MASK_ROW_WORDS(width) * height; i++) {
+        dst[i] = a[i] ^ b[i];
+    }
+}
+
+/**
+ * @brief Count the pixels set in a mask.
+ *
+ * @param mask The mask
+ * @param width The width of the mask in pixels
+ * @param height The height of the mask
+ * @return uint32_t The number of pixels set
+ */
+static inline uint32_t maskCount(const uint32_t *mask, uint32_t width, uint32_t height)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < MASK_ROW_WORDS(width) * height; i++) {
+        count += __builtin_popcount(mask[i]);
+    }
+    return count;
+}
+
+#endif /* __MASK_H */
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Block based motion detection.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "motion.h"
+
+int motionBegin(MotionDetector &md, uint32_t grid_cols, uint32_t grid_rows, uint32_t threshold)
+{
+    if (grid_cols == 0 || grid_cols > MOTION_GRID_MAX
+            || grid_rows == 0 || grid_rows > MOTION_GRID_MAX) {
+        return -1;
+    }
+
+    memset(&md, 0, sizeof(md));
+    md.grid_cols = grid_cols;
+    md.grid_rows = grid_rows;
+    md.threshold = threshold;
+    md.min_blocks = 1;
+    return 0;
+}
+
+int motionSetThreshold(MotionDetector &md, uint32_t threshold, uint32_t min_blocks)
+{
+    if (min_blocks == 0 || min_blocks > md.grid_cols * md.grid_rows) {
+        return -1;
+    }
+    md.threshold = threshold;
+    md.min_blocks = min_blocks;
+    return 0;
+}
+
+int motionSetWindow(MotionDetector &md, uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    md.win_x = x;
+    md.win_y = y;
+    md.win_w = w;
+    md.win_h = h;
+    motionReset(md);
+    return 0;
+}
+
+void motionReset(MotionDetector &md)
+{
+    md.width = 0;
+    md.height = 0;
+    md.changed = 0;
+}
+
+// Number of sampled positions in [start, end), when one out of step is sampled from 0.
+static inline uint32_t motion_samples(uint32_t start, uint32_t end, uint32_t step)
+{
+    return (end + step - 1) / step - (start + step - 1) / step;
+}
+
+// Sum the luma of the sampled pixels [x0, x1) of a row.
+template <typename PixelFormat>
+static uint32_t motion_segment(const typename PixelFormat::pixel_t *row, uint32_t x0, uint32_t x1, bool fast)
+{
+    uint32_t sum = 0;
+    uint32_t x = x0;
+
+    if (PixelFormat::format == CAMERA_RGB565 || PixelFormat::format == CAMERA_RGB565_LE) {
+        // Every other pixel, the conversion to luma costs more than the sum.
+        for (x = (x0 + 1) & ~1; x < x1; x += 2) {
+            int32_t r, g, b;
+            rgb565_unpack(rgb565_load<PixelFormat>(row, x), &r, &g, &b);
+            sum += rgb_to_luma(r, g, b);
+        }
+        return sum;
+    }
+
+    const uint8_t *p = (const uint8_t *) row;
+    if (PixelFormat::format == CAMERA_YUV422) {
+        #if IMG_USE_DSP
+        if (fast) {
+            // The luma is in the bytes 0 and 2 of every pair of pixels.
+            for (; x + 2 <= x1; x += 2) {
+                sum = __USADA8(img_read32(p + 2 * x) & 0x00FF00FF, 0, sum);
+            }
+        }
+        #endif
+        for (; x < x1; x++) {
+            sum += p[2 * x];
+        }
+        return sum;
+    }
+
+    #if IMG_USE_DSP
+    if (fast) {
+        for (; x + 4 <= x1; x += 4) {
+            sum = __USADA8(img_read32(p + x), 0, sum);
+        }
+    }
+    #endif
+    for (; x < x1; x++) {
+        sum += p[x];
+    }
+    return sum;
+}
+
+template <typename PixelFormat>
+static int motion_update(MotionDetector &md, const ImageView<PixelFormat> &frame, bool fast)
+{
+    if (!frame.isValid() || md.grid_cols == 0 || md.grid_rows == 0
+            || md.win_x >= frame.getWidth() || md.win_y >= frame.getHeight()) {
+        return -1;
+    }
+    uint32_t w = md.win_w ? md.win_w : frame.getWidth() - md.win_x;
+    uint32_t h = md.win_h ? md.win_h : frame.getHeight() - md.win_y;
+    // Every block must have at least one sampled row and column.
+    if (w > frame.getWidth() - md.win_x || h > frame.getHeight() - md.win_y
+            || w < md.grid_cols * MOTION_ROW_STEP || h < md.grid_rows * MOTION_ROW_STEP) {
+        return -1;
+    }
+    ImageView<PixelFormat> win = frame.subView(md.win_x, md.win_y, w, h);
+    uint32_t x_step = (PixelFormat::format == CAMERA_GRAYSCALE || PixelFormat::format == CAMERA_YUV422) ? 1 : 2;
+
+    uint16_t col_edges[MOTION_GRID_MAX + 1];
+    for (uint32_t c = 0; c <= md.grid_cols; c++) {
+        col_edges[c] = c * w / md.grid_cols;
+    }
+    memset(md.block_sums, 0, md.grid_cols * md.grid_rows * sizeof(uint32_t));
+
+    uint32_t grid_row = 0;
+    uint32_t row_end = h / md.grid_rows;
+    for (uint32_t y = 0; y < h; y += MOTION_ROW_STEP) {
+        while (y >= row_end) {
+            grid_row++;
+            row_end = (grid_row + 1) * h / md.grid_rows;
+        }
+        const typename PixelFormat::pixel_t *row = win.row(y);
+        uint32_t *block_sums = &md.block_sums[grid_row * md.grid_cols];
+        for (uint32_t c = 0; c < md.grid_cols; c++) {
+            block_sums[c] += motion_segment<PixelFormat>(row, col_edges[c], col_edges[c + 1], fast);
+        }
+    }
+
+    // The first frame, or the first frame of a new size, only sets the background.
+    bool first = (md.width != frame.getWidth() || md.height != frame.getHeight());
+    md.width = frame.getWidth();
+    md.height = frame.getHeight();
+    md.changed = 0;
+
+    for (uint32_t r = 0; r < md.grid_rows; r++) {
+        uint32_t rows = motion_samples(r * h / md.grid_rows, (r + 1) * h / md.grid_rows, MOTION_ROW_STEP);
+        for (uint32_t c = 0; c < md.grid_cols; c++) {
+            uint32_t count = rows * motion_samples(col_edges[c], col_edges[c + 1], x_step);
+            uint32_t i = r * md.grid_cols + c;
+            // Block mean in 8.8 fixed point
+            int32_t mean = ((uint64_t) md.block_sums[i] * 256 + count / 2) / count;
+            int32_t bg = md.background[i];
+            if (first) {
+                md.background[i] = mean;
+                continue;
+            }
+            int32_t diff = mean - bg;
+            if ((uint32_t) ((diff < 0) ? -diff : diff) > md.threshold * 256) {
+                md.changed++;
+            }
+            md.background[i] = bg + (diff >> MOTION_IIR_SHIFT);
+        }
+    }
+
+    return (!first && md.changed >= md.min_blocks) ? 1 : 0;
+}
+
+int motionUpdate(MotionDetector &md, const ImageView<PixelGrayscale> &frame)
+{
+    return motion_update(md, frame, true);
+}
+
+int motionUpdate(MotionDetector &md, const ImageView<PixelYUV422> &frame)
+{
+    return motion_update(md, frame, true);
+}
+
+int motionUpdate(MotionDetector &md, const ImageView<PixelRGB565> &frame)
+{
+    return motion_update(md, frame, true);
+}
+
+int motionUpdate(MotionDetector &md, const ImageView<PixelRGB565LE> &frame)
+{
+    return motion_update(md, frame, true);
+}
+
+int motionUpdateReference(MotionDetector &md, const ImageView<PixelGrayscale> &frame)
+{
+    return motion_update(md, frame, false);
+}
+
+bool frameMotionSupported(int32_t pixformat)
+{
+    return pixformat == CAMERA_GRAYSCALE || pixformat == CAMERA_YUV422
+        || pixformat == CAMERA_RGB565 || pixformat == CAMERA_RGB565_LE;
+}
+
+int frameMotion(FrameBuffer &fb, MotionDetector &md)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return motion_update(md, ImageView<PixelGrayscale>(fb), true);
+        case CAMERA_YUV422:
+            return motion_update(md, ImageView<PixelYUV422>(fb), true);
+        case CAMERA_RGB565:
+            return motion_update(md, ImageView<PixelRGB565>(fb), true);
+        case CAMERA_RGB565_LE:
+            return motion_update(md, ImageView<PixelRGB565LE>(fb), true);
+        default:
+            return -1;
+    }
+}
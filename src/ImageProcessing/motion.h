@@ -0,0 +1,183 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Block based motion detection.
+ */
+
+/**
+ * @file motion.h
+ * @brief Software motion detection from the mean luma of a grid of blocks.
+ *
+ * The window of the frame is divided in a grid of blocks. The mean luma of every block is
+ * computed from every MOTION_ROW_STEP-th row and compared to a background, the block means of
+ * the previous frames filtered by an IIR filter, the same way as the motion detection of the
+ * Himax sensors. Motion is detected when enough blocks differ from the background by more
+ * than the threshold:
+ * @code {.cpp}
+ * MotionDetector md;
+ * motionBegin(md, 8, 6, 16);
+ * while (cam.grabFrame(fb, 3000) == 0) {
+ *     if (frameMotion(fb, md) == 1) {
+ *         Serial.println("Motion!");
+ *     }
+ * }
+ * @endcode
+ * Camera uses it for the sensors without motion detection, e.g. the GC2145 and the OV7670.
+ *
+ * Grayscale and YUV422 rows are summed 4 and 2 pixels at a time with __USADA8.
+ * RGB565 rows are sampled every other pixel and converted to luma.
+ */
+
+#ifndef __MOTION_H
+#define __MOTION_H
+
+#include "imageview.h"
+
+/// Maximum number of columns and rows of the grid of blocks
+#define MOTION_GRID_MAX             (16)
+/// Default number of columns of the grid of blocks
+#define MOTION_GRID_COLS            (8)
+/// Default number of rows of the grid of blocks
+#define MOTION_GRID_ROWS            (6)
+/// Default threshold, in luma levels
+#define MOTION_THRESHOLD_DEFAULT    (16)
+/// Only one row out of MOTION_ROW_STEP is sampled, the minimum width and height of a block
+#define MOTION_ROW_STEP             (2)
+/// The background follows the block means with a weight of 1 / 2^MOTION_IIR_SHIFT, about 8 frames
+#define MOTION_IIR_SHIFT            (3)
+
+/**
+ * @struct MotionDetector
+ * @brief State of the software motion detection.
+ */
+struct MotionDetector {
+    uint32_t grid_cols;         /// Number of columns of the grid of blocks
+    uint32_t grid_rows;         /// Number of rows of the grid of blocks
+    uint32_t threshold;         /// Difference of a block mean to its background that changes the block, in luma levels
+    uint32_t min_blocks;        /// Number of changed blocks that is detected as motion
+    uint32_t win_x;             /// X coordinate of the window
+    uint32_t win_y;             /// Y coordinate of the window
+    uint32_t win_w;             /// Width of the window, 0 to the right edge of the frame
+    uint32_t win_h;             /// Height of the window, 0 to the bottom edge of the frame
+    uint32_t width;             /// Width of the frames of the background, 0 if there is no background yet
+    uint32_t height;            /// Height of the frames of the background
+    uint32_t changed;           /// Number of changed blocks of the last frame
+    uint16_t background[MOTION_GRID_MAX * MOTION_GRID_MAX];    /// Background of every block, in 8.8 fixed point
+    uint32_t block_sums[MOTION_GRID_MAX * MOTION_GRID_MAX];    /// Sum of the sampled luma values of every block
+};
+
+/**
+ * @brief Initialize the motion detection, the window is the whole frame.
+ *
+ * @param md The motion detection state
+ * @param grid_cols The number of columns of the grid of blocks, up to MOTION_GRID_MAX (default: MOTION_GRID_COLS)
+ * @param grid_rows The number of rows of the grid of blocks, up to MOTION_GRID_MAX (default: MOTION_GRID_ROWS)
+ * @param threshold The threshold in luma levels (default: MOTION_THRESHOLD_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int motionBegin(MotionDetector &md, uint32_t grid_cols=MOTION_GRID_COLS, uint32_t grid_rows=MOTION_GRID_ROWS,
+        uint32_t threshold=MOTION_THRESHOLD_DEFAULT);
+
+/**
+ * @brief Set the motion detection threshold.
+ *
+ * @param md The motion detection state
+ * @param threshold The difference of a block mean to its background that changes the block, in luma levels
+ * @param min_blocks The number of changed blocks that is detected as motion (default: 1)
+ * @return int 0 on success, -1 on failure
+ */
+int motionSetThreshold(MotionDetector &md, uint32_t threshold, uint32_t min_blocks=1);
+
+/**
+ * @brief Set the motion detection window, the background is reset.
+ *
+ * @param md The motion detection state
+ * @param x The X coordinate of the window
+ * @param y The Y coordinate of the window
+ * @param w The width of the window, 0 to the right edge of the frame
+ * @param h The height of the window, 0 to the bottom edge of the frame
+ * @return int 0 on success, -1 on failure
+ */
+int motionSetWindow(MotionDetector &md, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+/**
+ * @brief Reset the background, the next frame becomes the new background.
+ *
+ * @param md The motion detection state
+ */
+void motionReset(MotionDetector &md);
+
+/**
+ * @brief Detect motion in a grayscale frame and update the background.
+ * The first frame, or the first frame after a change of size, only sets the background.
+ *
+ * @param md The motion detection state
+ * @param frame The frame
+ * @return int 1 if motion is detected, 0 if not, -1 on failure
+ */
+int motionUpdate(MotionDetector &md, const ImageView<PixelGrayscale> &frame);
+
+/**
+ * @brief Detect motion in the luma of a YUV422 frame and update the background.
+ *
+ * @param md The motion detection state
+ * @param frame The frame
+ * @return int 1 if motion is detected, 0 if not, -1 on failure
+ */
+int motionUpdate(MotionDetector &md, const ImageView<PixelYUV422> &frame);
+
+/**
+ * @brief Detect motion in the luma of a big-endian RGB565 frame and update the background.
+ *
+ * @param md The motion detection state
+ * @param frame The frame
+ * @return int 1 if motion is detected, 0 if not, -1 on failure
+ */
+int motionUpdate(MotionDetector &md, const ImageView<PixelRGB565> &frame);
+
+/**
+ * @brief Detect motion in the luma of a little-endian RGB565 frame and update the background.
+ *
+ * @param md The motion detection state
+ * @param frame The frame
+ * @return int 1 if motion is detected, 0 if not, -1 on failure
+ */
+int motionUpdate(MotionDetector &md, const ImageView<PixelRGB565LE> &frame);
+
+/**
+ * @brief Check if motion can be detected in the frames of a pixel format by frameMotion().
+ *
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @return true if frameMotion() supports the pixel format, false otherwise
+ */
+bool frameMotionSupported(int32_t pixformat);
+
+/**
+ * @brief Detect motion in the grayscale, YUV422 or RGB565 frame stored in a frame buffer.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param md The motion detection state
+ * @return int 1 if motion is detected, 0 if not, -1 on failure
+ */
+int frameMotion(FrameBuffer &fb, MotionDetector &md);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int motionUpdateReference(MotionDetector &md, const ImageView<PixelGrayscale> &frame);
+
+#endif /* __MOTION_H */
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Pixel packing helpers shared by the image processing kernels.
+ * This header is private to the library and only included by the kernel sources.
+ */
+#ifndef __IMG_PIXEL_H
+#define __IMG_PIXEL_H
+
+#include "imageview.h"
+
+// BT.601 luma coefficients, in 8-bit fixed point
+#define LUMA_R              (77)
+#define LUMA_G              (150)
+#define LUMA_B              (29)
+
+static inline uint8_t rgb_to_luma(int32_t r, int32_t g, int32_t b)
+{
+    return (LUMA_R * r + LUMA_G * g + LUMA_B * b + 128) >> 8;
+}
+
+static inline uint16_t rgb565_pack(int32_t r, int32_t g, int32_t b)
+{
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Expand an RGB565 pixel to 8 bits per channel, the most significant bits are replicated
+// into the least significant bits, so that the full range is kept.
+static inline void rgb565_unpack(uint16_t pixel, int32_t *r, int32_t *g, int32_t *b)
+{
+    int32_t r5 = pixel >> 11;
+    int32_t g6 = (pixel >> 5) & 0x3F;
+    int32_t b5 = pixel & 0x1F;
+    *r = (r5 << 3) | (r5 >> 2);
+    *g = (g6 << 2) | (g6 >> 4);
+    *b = (b5 << 3) | (b5 >> 2);
+}
+
+/*
+ * Reads an RGB565 pixel of a source view, in the byte order of its pixel format.
+ */
+template <typename PixelFormat>
+static inline uint16_t rgb565_load(const typename PixelFormat::pixel_t *row, uint32_t x)
+{
+    const uint8_t *p = (const uint8_t *) (row + x);
+    return (PixelFormat::format == CAMERA_RGB565_LE) ? (p[0] | (p[1] << 8)) : ((p[0] << 8) | p[1]);
+}
+
+/*
+ * Writes an 8-bit per channel RGB pixel in the pixel format of a destination view.
+ */
+template <typename PixelFormat>
+struct PixelWriter;
+
+template <>
+struct PixelWriter<PixelGrayscale> {
+    static inline void write(uint8_t *row, uint32_t x, int32_t r, int32_t g, int32_t b)
+    {
+        row[x] = rgb_to_luma(r, g, b);
+    }
+};
+
+template <>
+struct PixelWriter<PixelRGB565> {
+    static inline void write(uint16_t *row, uint32_t x, int32_t r, int32_t g, int32_t b)
+    {
+        uint16_t pixel = rgb565_pack(r, g, b);
+        uint8_t *p = (uint8_t *) (row + x);
+        p[0] = pixel >> 8;
+        p[1] = pixel & 0xFF;
+    }
+};
+
+template <>
+struct PixelWriter<PixelRGB565LE> {
+    static inline void write(uint16_t *row, uint32_t x, int32_t r, int32_t g, int32_t b)
+    {
+        uint16_t pixel = rgb565_pack(r, g, b);
+        uint8_t *p = (uint8_t *) (row + x);
+        p[0] = pixel & 0xFF;
+        p[1] = pixel >> 8;
+    }
+};
+
+template <>
+struct PixelWriter<PixelRGB888> {
+    static inline void write(rgb888_t *row, uint32_t x, int32_t r, int32_t g, int32_t b)
+    {
+        row[x].r = r;
+        row[x].g = g;
+        row[x].b = b;
+    }
+};
+
+template <>
+struct PixelWriter<PixelARGB8888> {
+    static inline void write(uint32_t *row, uint32_t x, int32_t r, int32_t g, int32_t b)
+    {
+        row[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+};
+
+/*
+ * Reads and writes the channels of a pixel, without changing the pixel format.
+ * RGB565 channels are expanded to 8 bits, so that all formats share the same range.
+ */
+template <typename PixelFormat>
+struct PixelAccess;
+
+template <>
+struct PixelAccess<PixelGrayscale> {
+    static const uint32_t channels = 1;
+    static inline void read(const uint8_t *row, uint32_t x, int32_t *c)
+    {
+        c[0] = row[x];
+    }
+    static inline void write(uint8_t *row, uint32_t x, const int32_t *c)
+    {
+        row[x] = c[0];
+    }
+};
+
+template <typename PixelFormat>
+struct PixelAccessRGB565 {
+    static const uint32_t channels = 3;
+    static inline void read(const uint16_t *row, uint32_t x, int32_t *c)
+    {
+        rgb565_unpack(rgb565_load<PixelFormat>(row, x), &c[0], &c[1], &c[2]);
+    }
+    static inline void write(uint16_t *row, uint32_t x, const int32_t *c)
+    {
+        PixelWriter<PixelFormat>::write(row, x, c[0], c[1], c[2]);
+    }
+};
+
+template <>
+struct PixelAccess<PixelRGB565> : PixelAccessRGB565<PixelRGB565> { };
+
+template <>
+struct PixelAccess<PixelRGB565LE> : PixelAccessRGB565<PixelRGB565LE> { };
+
+template <>
+struct PixelAccess<PixelRGB888> {
+    static const uint32_t channels = 3;
+    static inline void read(const rgb888_t *row, uint32_t x, int32_t *c)
+    {
+        c[0] = row[x].r;
+        c[1] = row[x].g;
+        c[2] = row[x].b;
+    }
+    static inline void write(rgb888_t *row, uint32_t x, const int32_t *c)
+    {
+        PixelWriter<PixelRGB888>::write(row, x, c[0], c[1], c[2]);
+    }
+};
+
+#endif /* __IMG_PIXEL_H */
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image quality metrics.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "quality.h"
+
+// Width of the strips of luma extracted from the formats other than grayscale
+#define QUALITY_CHUNK   (64)
+
+// Sums accumulated over the image
+struct QualitySums {
+    int64_t lap_sum;
+    uint64_t lap_sq;
+    uint32_t lap_count;
+    uint64_t sum;
+    uint32_t count;
+    uint32_t dark;
+    uint32_t saturated;
+};
+
+// Count the pixels of a row, their sum and the dark and saturated pixels.
+static void quality_levels(QualitySums &s, const uint8_t *p, uint32_t n, uint8_t dark, uint8_t saturated, bool fast)
+{
+    uint32_t sum = 0;
+    uint32_t n_dark = 0;
+    uint32_t n_saturated = 0;
+    uint32_t x = 0;
+
+    #if IMG_USE_DSP
+    if (fast) {
+        // A byte of (dark + 1) - p is not 0 for a dark pixel, and of p - (saturated - 1) for a
+        // saturated pixel. Adding 127 with saturation moves any such byte to the top bit.
+        uint32_t dark4 = (dark + 1) * 0x01010101u;
+        uint32_t saturated4 = (saturated - 1) * 0x01010101u;
+        for (; x + 4 <= n; x += 4) {
+            uint32_t w = img_read32(p + x);
+            uint32_t d = __UQADD8(__UQSUB8(dark4, w), 0x7F7F7F7F);
+            uint32_t s = __UQADD8(__UQSUB8(w, saturated4), 0x7F7F7F7F);
+            sum = __USADA8(w, 0, sum);
+            n_dark = __USADA8((d >> 7) & 0x01010101, 0, n_dark);
+            n_saturated = __USADA8((s >> 7) & 0x01010101, 0, n_saturated);
+        }
+    }
+    #endif
+
+    for (; x < n; x++) {
+        sum += p[x];
+        n_dark += (p[x] <= dark);
+        n_saturated += (p[x] >= saturated);
+    }
+
+    s.sum += sum;
+    s.count += n;
+    s.dark += n_dark;
+    s.saturated += n_saturated;
+}
+
+// Accumulate the Laplacian 4 * p - up - down - left - right of n pixels of a row,
+// and its square. p[-1] and p[n] are read.
+static void quality_laplacian(QualitySums &s, const uint8_t *up, const uint8_t *p, const uint8_t *down,
+        uint32_t n, bool fast)
+{
+    const uint8_t *left = p - 1;
+    const uint8_t *right = p + 1;
+    int32_t sum = 0;
+    uint64_t sq = 0;
+    uint32_t x = 0;
+
+    #if IMG_USE_DSP
+    if (fast) {
+        for (; x + 4 <= n; x += 4) {
+            uint32_t c = img_read32(p + x);
+            uint32_t u = img_read32(up + x);
+            uint32_t d = img_read32(down + x);
+            uint32_t l = img_read32(left + x);
+            uint32_t r = img_read32(right + x);
+            // Pixels 0 and 2 in the even lanes, 1 and 3 in the odd lanes
+            uint32_t n_even = __UXTAB16(__UXTAB16(__UXTAB16(__UXTB16(u), d), l), r);
+            uint32_t n_odd = __UXTAB16(__UXTAB16(__UXTAB16(__UXTB16(__ROR(u, 8)), __ROR(d, 8)), __ROR(l, 8)), __ROR(r, 8));
+            uint32_t lap_even = __SSUB16(__UXTB16(c) << 2, n_even);
+            uint32_t lap_odd = __SSUB16(__UXTB16(__ROR(c, 8)) << 2, n_odd);
+            sum = __SMLAD(lap_even, 0x00010001, sum);
+            sum = __SMLAD(lap_odd, 0x00010001, sum);
+            sq = __SMLALD(lap_even, lap_even, sq);
+            sq = __SMLALD(lap_odd, lap_odd, sq);
+        }
+    }
+    #endif
+
+    for (; x < n; x++) {
+        int32_t lap = 4 * p[x] - up[x] - down[x] - left[x] - right[x];
+        sum += lap;
+        sq += lap * lap;
+    }
+
+    s.lap_sum += sum;
+    s.lap_sq += sq;
+    s.lap_count += n;
+}
+
+static void quality_result(const QualitySums &s, FrameQuality &q)
+{
+    float lap_mean = (float) s.lap_sum / s.lap_count;
+    float variance = (float) s.lap_sq / s.lap_count - lap_mean * lap_mean;
+    q.sharpness = (variance > 0.0f) ? variance : 0.0f;
+    q.mean = (float) s.sum / s.count;
+    q.saturated = (float) s.saturated / s.count;
+    q.dark = (float) s.dark / s.count;
+}
+
+static int quality_gray(const ImageView<PixelGrayscale> &src, FrameQuality &q, uint8_t dark, uint8_t saturated, bool fast)
+{
+    QualitySums s;
+    memset(&s, 0, sizeof(s));
+
+    uint32_t width = src.getWidth();
+    uint32_t height = src.getHeight();
+    for (uint32_t y = 0; y < height; y++) {
+        quality_levels(s, src.row(y), width, dark, saturated, fast);
+        if (y >= 2) {
+            quality_laplacian(s, src.row(y - 2) + 1, src.row(y - 1) + 1, src.row(y) + 1, width - 2, fast);
+        }
+    }
+    quality_result(s, q);
+    return 0;
+}
+
+// Extract the luma of a pixel of the formats other than grayscale.
+template <typename PixelFormat>
+static inline uint8_t quality_luma(const typename PixelFormat::pixel_t *row, uint32_t x)
+{
+    if (PixelFormat::format == CAMERA_YUV422) {
+        return ((const uint8_t *) row)[2 * x];
+    }
+    int32_t r, g, b;
+    rgb565_unpack(rgb565_load<PixelFormat>(row, x), &r, &g, &b);
+    return rgb_to_luma(r, g, b);
+}
+
+// The image is processed in vertical strips, the luma of the last 3 rows of a strip, with one
+// more column on each side, is kept in a ring so that every pixel is converted once per strip.
+template <typename PixelFormat>
+static int quality_luma_image(const ImageView<PixelFormat> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    QualitySums s;
+    memset(&s, 0, sizeof(s));
+
+    uint32_t width = src.getWidth();
+    uint32_t height = src.getHeight();
+    for (uint32_t x0 = 0; x0 < width; x0 += QUALITY_CHUNK) {
+        uint32_t n = (width - x0 < QUALITY_CHUNK) ? width - x0 : QUALITY_CHUNK;
+        // Columns of the Laplacian, that have their left and right neighbors in the image
+        uint32_t lap_x0 = (x0 == 0) ? 1 : x0;
+        uint32_t lap_x1 = (x0 + n == width) ? width - 1 : x0 + n;
+        // Columns of the luma, from x0 - 1 to x0 + n included
+        uint8_t luma[3][QUALITY_CHUNK + 2];
+        uint32_t luma_x0 = (x0 == 0) ? 0 : x0 - 1;
+        uint32_t luma_x1 = (lap_x1 + 1 < width) ? lap_x1 + 1 : width;
+
+        for (uint32_t y = 0; y < height; y++) {
+            const typename PixelFormat::pixel_t *row = src.row(y);
+            uint8_t *l = luma[y % 3];
+            for (uint32_t x = luma_x0; x < luma_x1; x++) {
+                l[x + 1 - x0] = quality_luma<PixelFormat>(row, x);
+            }
+            quality_levels(s, l + 1, n, dark, saturated, true);
+            if (y >= 2 && lap_x1 > lap_x0) {
+                uint32_t offset = lap_x0 - x0 + 1;
+                quality_laplacian(s, luma[(y - 2) % 3] + offset, luma[(y - 1) % 3] + offset, luma[y % 3] + offset,
+                        lap_x1 - lap_x0, true);
+            }
+        }
+    }
+    quality_result(s, q);
+    return 0;
+}
+
+static inline bool quality_valid(uint32_t width, uint32_t height, uint8_t dark, uint8_t saturated)
+{
+    return width >= 3 && height >= 3 && dark < saturated;
+}
+
+int imageQuality(const ImageView<PixelGrayscale> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    if (!src.isValid() || !quality_valid(src.getWidth(), src.getHeight(), dark, saturated)) {
+        return -1;
+    }
+    return quality_gray(src, q, dark, saturated, true);
+}
+
+int imageQuality(const ImageView<PixelYUV422> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    if (!src.isValid() || !quality_valid(src.getWidth(), src.getHeight(), dark, saturated)) {
+        return -1;
+    }
+    return quality_luma_image(src, q, dark, saturated);
+}
+
+int imageQuality(const ImageView<PixelRGB565> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    if (!src.isValid() || !quality_valid(src.getWidth(), src.getHeight(), dark, saturated)) {
+        return -1;
+    }
+    return quality_luma_image(src, q, dark, saturated);
+}
+
+int imageQuality(const ImageView<PixelRGB565LE> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    if (!src.isValid() || !quality_valid(src.getWidth(), src.getHeight(), dark, saturated)) {
+        return -1;
+    }
+    return quality_luma_image(src, q, dark, saturated);
+}
+
+int imageQualityReference(const ImageView<PixelGrayscale> &src, FrameQuality &q, uint8_t dark, uint8_t saturated)
+{
+    if (!src.isValid() || !quality_valid(src.getWidth(), src.getHeight(), dark, saturated)) {
+        return -1;
+    }
+    return quality_gray(src, q, dark, saturated, false);
+}
+
+template <typename PixelFormat>
+static int frame_quality(FrameBuffer &fb, FrameQuality &q, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+        uint8_t dark, uint8_t saturated)
+{
+    ImageView<PixelFormat> frame(fb);
+    if (!frame.isValid() || x >= frame.getWidth() || y >= frame.getHeight()) {
+        return -1;
+    }
+    w = (w == 0) ? frame.getWidth() - x : w;
+    h = (h == 0) ? frame.getHeight() - y : h;
+    return imageQuality(frame.subView(x, y, w, h), q, dark, saturated);
+}
+
+int frameQuality(FrameBuffer &fb, FrameQuality &q, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+        uint8_t dark, uint8_t saturated)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return frame_quality<PixelGrayscale>(fb, q, x, y, w, h, dark, saturated);
+        case CAMERA_YUV422:
+            return frame_quality<PixelYUV422>(fb, q, x, y, w, h, dark, saturated);
+        case CAMERA_RGB565:
+            return frame_quality<PixelRGB565>(fb, q, x, y, w, h, dark, saturated);
+        case CAMERA_RGB565_LE:
+            return frame_quality<PixelRGB565LE>(fb, q, x, y, w, h, dark, saturated);
+        default:
+            return -1;
+    }
+}
+
+bool qualityCheck(const FrameQuality &q, float min_sharpness, float max_saturated, float max_dark)
+{
+    return q.sharpness >= min_sharpness && q.saturated <= max_saturated && q.dark <= max_dark;
+}
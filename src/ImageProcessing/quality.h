@@ -0,0 +1,149 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image quality metrics.
+ */
+
+/**
+ * @file quality.h
+ * @brief Sharpness and exposure quality metrics, to drop the bad frames before processing them.
+ *
+ * The sharpness is the variance of the Laplacian of the luma: blurred frames, e.g. by motion or
+ * out of focus, have few edges and a low variance. The exposure is checked from the fractions
+ * of saturated and dark pixels:
+ * @code {.cpp}
+ * FrameQuality q;
+ * if (cam.grabFrame(fb, 3000) == 0 && frameQuality(fb, q, 80, 60, 160, 120) == 0
+ *         && qualityCheck(q, 50.0f)) {
+ *     // Run the inference
+ * }
+ * @endcode
+ * All the metrics are computed in a single pass over the region of interest. With the DSP
+ * extension the Laplacian of 4 pixels is computed at once in 16-bit lanes and squared with
+ * __SMLALD, and the saturated and dark pixels are counted 4 at a time.
+ */
+
+#ifndef __QUALITY_H
+#define __QUALITY_H
+
+#include "imageview.h"
+
+/// Default level at or below which a pixel is dark
+#define QUALITY_DARK_DEFAULT            (16)
+/// Default level at or above which a pixel is saturated
+#define QUALITY_SATURATED_DEFAULT       (250)
+/// Default maximum fraction of saturated pixels of qualityCheck()
+#define QUALITY_MAX_SATURATED_DEFAULT   (0.05f)
+/// Default maximum fraction of dark pixels of qualityCheck()
+#define QUALITY_MAX_DARK_DEFAULT        (0.5f)
+
+/**
+ * @struct FrameQuality
+ * @brief Quality metrics of a region of a frame.
+ */
+struct FrameQuality {
+    float sharpness;            /// Variance of the Laplacian of the luma, higher is sharper
+    float mean;                 /// Mean luma
+    float saturated;            /// Fraction of the pixels at or above the saturated level
+    float dark;                 /// Fraction of the pixels at or below the dark level
+};
+
+/**
+ * @brief Compute the quality metrics of a grayscale image.
+ * The Laplacian is computed for the pixels that have their 4 neighbors in the image.
+ *
+ * @param src The image, at least 3x3 pixels, e.g. a region of interest of a frame from ImageView::subView()
+ * @param q The quality metrics
+ * @param dark The level at or below which a pixel is dark (default: QUALITY_DARK_DEFAULT)
+ * @param saturated The level at or above which a pixel is saturated, higher than dark (default: QUALITY_SATURATED_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int imageQuality(const ImageView<PixelGrayscale> &src, FrameQuality &q,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+/**
+ * @brief Compute the quality metrics of the luma of a YUV422 image.
+ *
+ * @param src The image, at least 3x3 pixels
+ * @param q The quality metrics
+ * @param dark The level at or below which a pixel is dark (default: QUALITY_DARK_DEFAULT)
+ * @param saturated The level at or above which a pixel is saturated, higher than dark (default: QUALITY_SATURATED_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int imageQuality(const ImageView<PixelYUV422> &src, FrameQuality &q,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+/**
+ * @brief Compute the quality metrics of the luma of a big-endian RGB565 image.
+ *
+ * @param src The image, at least 3x3 pixels
+ * @param q The quality metrics
+ * @param dark The level at or below which a pixel is dark (default: QUALITY_DARK_DEFAULT)
+ * @param saturated The level at or above which a pixel is saturated, higher than dark (default: QUALITY_SATURATED_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int imageQuality(const ImageView<PixelRGB565> &src, FrameQuality &q,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+/**
+ * @brief Compute the quality metrics of the luma of a little-endian RGB565 image.
+ *
+ * @param src The image, at least 3x3 pixels
+ * @param q The quality metrics
+ * @param dark The level at or below which a pixel is dark (default: QUALITY_DARK_DEFAULT)
+ * @param saturated The level at or above which a pixel is saturated, higher than dark (default: QUALITY_SATURATED_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int imageQuality(const ImageView<PixelRGB565LE> &src, FrameQuality &q,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+/**
+ * @brief Compute the quality metrics of a region of interest of the grayscale, YUV422 or RGB565
+ * frame stored in a frame buffer, with the default dark and saturated levels.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param q The quality metrics
+ * @param x The X coordinate of the region of interest (default: 0)
+ * @param y The Y coordinate of the region of interest (default: 0)
+ * @param w The width of the region of interest, 0 for the rest of the frame (default: 0)
+ * @param h The height of the region of interest, 0 for the rest of the frame (default: 0)
+ * @param dark The level at or below which a pixel is dark (default: QUALITY_DARK_DEFAULT)
+ * @param saturated The level at or above which a pixel is saturated, higher than dark (default: QUALITY_SATURATED_DEFAULT)
+ * @return int 0 on success, -1 on failure
+ */
+int frameQuality(FrameBuffer &fb, FrameQuality &q, uint32_t x=0, uint32_t y=0, uint32_t w=0, uint32_t h=0,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+/**
+ * @brief Check the quality metrics against quality gates.
+ *
+ * @param q The quality metrics
+ * @param min_sharpness The minimum sharpness, it depends on the scene and the resolution
+ * @param max_saturated The maximum fraction of saturated pixels (default: QUALITY_MAX_SATURATED_DEFAULT)
+ * @param max_dark The maximum fraction of dark pixels (default: QUALITY_MAX_DARK_DEFAULT)
+ * @return true if the frame passes all the gates
+ */
+bool qualityCheck(const FrameQuality &q, float min_sharpness,
+        float max_saturated=QUALITY_MAX_SATURATED_DEFAULT, float max_dark=QUALITY_MAX_DARK_DEFAULT);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int imageQualityReference(const ImageView<PixelGrayscale> &src, FrameQuality &q,
+        uint8_t dark=QUALITY_DARK_DEFAULT, uint8_t saturated=QUALITY_SATURATED_DEFAULT);
+
+#endif /* __QUALITY_H */
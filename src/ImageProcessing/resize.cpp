@@ -0,0 +1,281 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image resize kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "resize.h"
+
+int resizeCoords(uint32_t src_size, uint32_t dst_size, int32_t method, ResizeCoord *coords)
+{
+    if (src_size == 0 || dst_size == 0 || src_size > 0x7FFF || coords == NULL
+            || (method != RESIZE_NEAREST && method != RESIZE_BILINEAR)) {
+        return -1;
+    }
+
+    // The pixel centers are aligned: s = (d + 0.5) * src_size / dst_size - 0.5
+    int32_t step = ((src_size << 16) + dst_size / 2) / dst_size;
+    int32_t pos = step / 2 - 0x8000;
+
+    for (uint32_t d = 0; d < dst_size; d++, pos += step) {
+        if (method == RESIZE_NEAREST) {
+            // Exact center of the destination pixel, to avoid accumulating rounding errors
+            coords[d].i0 = ((2 * d + 1) * src_size) / (2 * dst_size);
+            coords[d].i1 = coords[d].i0;
+            coords[d].w1 = 0;
+            continue;
+        }
+
+        uint32_t p = (pos < 0) ? 0 : pos;
+        uint32_t i0 = p >> 16;
+        uint32_t w1 = (p >> 8) & 0xFF;
+        if (i0 >= src_size - 1) {
+            // Past the center of the last source pixel
+            i0 = src_size - 1;
+            w1 = 0;
+        }
+        coords[d].i0 = i0;
+        coords[d].i1 = (i0 + 1 < src_size) ? i0 + 1 : i0;
+        coords[d].w1 = w1;
+    }
+    return 0;
+}
+
+template <typename PixelFormat>
+static void resize_nearest(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst,
+        const ResizeCoord *xc, const ResizeCoord *yc)
+{
+    for (uint32_t y = 0; y < dst.getHeight(); y++) {
+        const typename PixelFormat::pixel_t *s = src.row(yc[y].i0);
+        typename PixelFormat::pixel_t *d = dst.row(y);
+        for (uint32_t x = 0; x < dst.getWidth(); x++) {
+            d[x] = s[xc[x].i0];
+        }
+    }
+}
+
+// Interpolate a source row horizontally, every value is scaled by 256.
+template <typename PixelFormat>
+static void resize_row_horizontal(const typename PixelFormat::pixel_t *s, const ResizeCoord *xc,
+        uint32_t width, uint16_t *h)
+{
+    const uint32_t channels = PixelAccess<PixelFormat>::channels;
+
+    for (uint32_t x = 0; x < width; x++, h += channels) {
+        int32_t c0[channels], c1[channels];
+        PixelAccess<PixelFormat>::read(s, xc[x].i0, c0);
+        PixelAccess<PixelFormat>::read(s, xc[x].i1, c1);
+        for (uint32_t c = 0; c < channels; c++) {
+            h[c] = c0[c] * (256 - xc[x].w1) + c1[c] * xc[x].w1;
+        }
+    }
+}
+
+template <typename PixelFormat>
+static void resize_bilinear(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst,
+        const ResizeCoord *xc, const ResizeCoord *yc, uint16_t *rows)
+{
+    const uint32_t channels = PixelAccess<PixelFormat>::channels;
+    uint32_t width = dst.getWidth();
+    uint16_t *top = rows;
+    uint16_t *bottom = rows + width * channels;
+    int32_t top_y = -1;
+    int32_t bottom_y = -1;
+
+    for (uint32_t y = 0; y < dst.getHeight(); y++) {
+        int32_t y0 = yc[y].i0;
+        int32_t y1 = yc[y].i1;
+
+        // Reuse the rows that were already interpolated for the previous destination row.
+        if (y0 == bottom_y) {
+            uint16_t *tmp = top;
+            top = bottom;
+            bottom = tmp;
+            top_y = bottom_y;
+            bottom_y = -1;
+        }
+        if (y0 != top_y) {
+            resize_row_horizontal<PixelFormat>(src.row(y0), xc, width, top);
+            top_y = y0;
+        }
+        if (y1 != bottom_y) {
+            resize_row_horizontal<PixelFormat>(src.row(y1), xc, width, bottom);
+            bottom_y = y1;
+        }
+
+        int32_t w1 = yc[y].w1;
+        int32_t w0 = 256 - w1;
+        typename PixelFormat::pixel_t *d = dst.row(y);
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t c[channels];
+            for (uint32_t i = 0; i < channels; i++) {
+                c[i] = (top[x * channels + i] * w0 + bottom[x * channels + i] * w1 + 0x8000) >> 16;
+            }
+            PixelAccess<PixelFormat>::write(d, x, c);
+        }
+    }
+}
+
+template <typename PixelFormat>
+static void resize_area(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, uint32_t *sums)
+{
+    const uint32_t channels = PixelAccess<PixelFormat>::channels;
+    uint32_t width = dst.getWidth();
+    uint32_t kx = src.getWidth() / width;
+    uint32_t ky = src.getHeight() / dst.getHeight();
+    uint32_t n = kx * ky;
+
+    for (uint32_t y = 0; y < dst.getHeight(); y++) {
+        memset(sums, 0, width * channels * sizeof(uint32_t));
+        // Accumulate the block rows in source order, so the source is read sequentially.
+        for (uint32_t sy = y * ky; sy < (y + 1) * ky; sy++) {
+            const typename PixelFormat::pixel_t *s = src.row(sy);
+            uint32_t *sum = sums;
+            for (uint32_t x = 0, sx = 0; x < width; x++, sum += channels) {
+                for (uint32_t k = 0; k < kx; k++, sx++) {
+                    int32_t c[channels];
+                    PixelAccess<PixelFormat>::read(s, sx, c);
+                    for (uint32_t i = 0; i < channels; i++) {
+                        sum[i] += c[i];
+                    }
+                }
+            }
+        }
+
+        typename PixelFormat::pixel_t *d = dst.row(y);
+        for (uint32_t x = 0; x < width; x++) {
+            int32_t c[channels];
+            for (uint32_t i = 0; i < channels; i++) {
+                c[i] = (sums[x * channels + i] + n / 2) / n;
+            }
+            PixelAccess<PixelFormat>::write(d, x, c);
+        }
+    }
+}
+
+template <typename PixelFormat>
+static int resize_image(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, int32_t method,
+        const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch)
+{
+    uint32_t dw = dst.getWidth();
+    uint32_t dh = dst.getHeight();
+
+    if (!src.isValid() || !dst.isValid() || method < 0 || method >= RESIZE_MAX) {
+        return -1;
+    }
+
+    if (method == RESIZE_AREA) {
+        if ((src.getWidth() % dw) || (src.getHeight() % dh) || scratch == NULL) {
+            return -1;
+        }
+        resize_area(src, dst, scratch);
+        return 0;
+    }
+
+    // The coordinates increase, the last ones are the largest.
+    if (xc == NULL || yc == NULL || xc[dw - 1].i1 >= src.getWidth() || yc[dh - 1].i1 >= src.getHeight()) {
+        return -1;
+    }
+    if (method == RESIZE_NEAREST) {
+        resize_nearest(src, dst, xc, yc);
+        return 0;
+    }
+    if (scratch == NULL) {
+        return -1;
+    }
+    resize_bilinear(src, dst, xc, yc, (uint16_t *) scratch);
+    return 0;
+}
+
+template <typename PixelFormat>
+static int resize_image(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, int32_t method)
+{
+    const uint32_t channels = PixelAccess<PixelFormat>::channels;
+    uint32_t dw = dst.getWidth();
+    uint32_t dh = dst.getHeight();
+
+    if (!src.isValid() || !dst.isValid() || method < 0 || method >= RESIZE_MAX) {
+        return -1;
+    }
+
+    // Scratch rows, followed by the coordinate tables.
+    uint32_t scratch_size = (method == RESIZE_NEAREST) ? 0 : RESIZE_SCRATCH_WORDS(dw, channels) * sizeof(uint32_t);
+    uint32_t coords_size = (method == RESIZE_AREA) ? 0 : (dw + dh) * sizeof(ResizeCoord);
+    uint8_t *buffer = (uint8_t *) malloc(scratch_size + coords_size);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    uint32_t *scratch = (scratch_size != 0) ? (uint32_t *) buffer : NULL;
+    ResizeCoord *xc = NULL;
+    ResizeCoord *yc = NULL;
+    if (coords_size != 0) {
+        xc = (ResizeCoord *) (buffer + scratch_size);
+        yc = xc + dw;
+    }
+    int ret = -1;
+    if (xc == NULL || (resizeCoords(src.getWidth(), dw, method, xc) == 0
+                && resizeCoords(src.getHeight(), dh, method, yc) == 0)) {
+        ret = resize_image(src, dst, method, xc, yc, scratch);
+    }
+    free(buffer);
+    return ret;
+}
+
+int resizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, int32_t method)
+{
+    return resize_image(src, dst, method);
+}
+
+int resizeImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, int32_t method)
+{
+    return resize_image(src, dst, method);
+}
+
+int resizeImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, int32_t method)
+{
+    return resize_image(src, dst, method);
+}
+
+int resizeImage(const ImageView<PixelRGB888> &src, const ImageView<PixelRGB888> &dst, int32_t method)
+{
+    return resize_image(src, dst, method);
+}
+
+int resizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch)
+{
+    return resize_image(src, dst, method, xc, yc, scratch);
+}
+
+int resizeImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch)
+{
+    return resize_image(src, dst, method, xc, yc, scratch);
+}
+
+int resizeImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch)
+{
+    return resize_image(src, dst, method, xc, yc, scratch);
+}
+
+int resizeImage(const ImageView<PixelRGB888> &src, const ImageView<PixelRGB888> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch)
+{
+    return resize_image(src, dst, method, xc, yc, scratch);
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image resize kernels.
+ */
+
+/**
+ * @file resize.h
+ * @brief Fixed-point image resize kernels.
+ *
+ * The sensors only have a few native resolutions, these kernels scale a captured frame,
+ * or a region of interest of it, to any size, e.g. the input size of a model:
+ * @code {.cpp}
+ * ImageView<PixelGrayscale> frame(fb);
+ * ImageView<PixelGrayscale> input(tensor_buffer, 96, 96);
+ * resizeImage(frame.subView(40, 0, 240, 240), input, RESIZE_BILINEAR);
+ * @endcode
+ * The source coordinates of every destination row and column are computed once per call,
+ * in 16.16 fixed point with the pixel centers aligned, and the bilinear interpolation is
+ * done separably: every source row is interpolated horizontally at most once.
+ *
+ * To resize every frame without allocating memory, the coordinate tables and the scratch
+ * rows can be kept by the caller, and the tables computed once for the sizes of the frames:
+ * @code {.cpp}
+ * static ResizeCoord xc[96], yc[96];
+ * static uint32_t scratch[RESIZE_SCRATCH_WORDS(96, 1)];
+ * resizeCoords(240, 96, RESIZE_BILINEAR, xc);
+ * resizeCoords(240, 96, RESIZE_BILINEAR, yc);
+ * while (cam.grabFrame(fb, 3000) == 0) {
+ *     resizeImage(ImageView<PixelGrayscale>(fb).subView(40, 0, 240, 240), input, RESIZE_BILINEAR, xc, yc, scratch);
+ * }
+ * @endcode
+ *
+ * All kernels return 0 on success and -1 if a view is empty, if the method is invalid,
+ * or if the sizes don't have an integer ratio for RESIZE_AREA.
+ */
+
+#ifndef __RESIZE_H
+#define __RESIZE_H
+
+#include "imageview.h"
+
+/// Resize method enumeration
+enum {
+    RESIZE_NEAREST      = 0,    /* Nearest neighbour                                                     */
+    RESIZE_BILINEAR     = 1,    /* Bilinear interpolation of the 4 nearest source pixels                 */
+    RESIZE_AREA         = 2,    /* Average of the source block, the sizes must have an integer ratio     */
+    RESIZE_MAX                  /* Sentinel value */
+};
+
+/// Number of 32-bit words of the scratch buffer of a resize to a width, for pixels of a number of
+/// channels: 1 for grayscale, 3 for RGB565 and RGB888
+#define RESIZE_SCRATCH_WORDS(dst_width, channels)   ((dst_width) * (channels))
+
+/**
+ * @struct ResizeCoord
+ * @brief Source coordinates of a destination row or column.
+ */
+struct ResizeCoord {
+    uint16_t i0;    /// Index of the nearest source pixel, or of the first one for bilinear interpolation
+    uint16_t i1;    /// Index of the second source pixel for bilinear interpolation
+    uint16_t w1;    /// Weight of the second source pixel, from 0 to 256
+};
+
+/**
+ * @brief Compute the source coordinates of every destination row or column of a resize.
+ *
+ * @param src_size The source width or height
+ * @param dst_size The destination width or height
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR
+ * @param coords The table of dst_size coordinates to fill
+ * @return int 0 on success, -1 on failure
+ */
+int resizeCoords(uint32_t src_size, uint32_t dst_size, int32_t method, ResizeCoord *coords);
+
+/**
+ * @brief Resize a grayscale image.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param dst The destination image
+ * @param method The resize method, as defined in the resize method enum (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int resizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize a big-endian RGB565 image.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param dst The destination image
+ * @param method The resize method, as defined in the resize method enum (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int resizeImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize a little-endian RGB565 image.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param dst The destination image
+ * @param method The resize method, as defined in the resize method enum (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int resizeImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize an RGB888 image.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param dst The destination image
+ * @param method The resize method, as defined in the resize method enum (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int resizeImage(const ImageView<PixelRGB888> &src, const ImageView<PixelRGB888> &dst,
+        int32_t method=RESIZE_BILINEAR);
+
+/*
+ * Resize with coordinate tables and scratch buffers owned by the caller, to avoid allocating
+ * memory for every frame. The tables are those of resizeCoords() for the widths and for the
+ * heights of the source and destination, they are not used by RESIZE_AREA. The scratch buffer
+ * has RESIZE_SCRATCH_WORDS(dst width, channels) words, it is not used by RESIZE_NEAREST.
+ */
+int resizeImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch);
+int resizeImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch);
+int resizeImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch);
+int resizeImage(const ImageView<PixelRGB888> &src, const ImageView<PixelRGB888> &dst,
+        int32_t method, const ResizeCoord *xc, const ResizeCoord *yc, uint32_t *scratch);
+
+#endif /* __RESIZE_H */
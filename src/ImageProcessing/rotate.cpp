@@ -0,0 +1,353 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image rotation and flip kernels.
+ */
+#include "simd.h"
+#include "rotate.h"
+
+template <typename PixelFormat>
+static int flip_check(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst)
+{
+    if (!src.isValid() || !dst.isValid()
+            || src.getWidth() != dst.getWidth() || src.getHeight() != dst.getHeight()) {
+        return -1;
+    }
+    // In place only if the views are the same, a partial overlap would overwrite unread pixels.
+    if (src.getData() == dst.getData() && src.getStride() != dst.getStride()) {
+        return -1;
+    }
+    return 0;
+}
+
+template <typename PixelFormat>
+static int rotate_check(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, int32_t rotation)
+{
+    if (rotation < 0 || rotation >= ROTATE_MAX) {
+        return -1;
+    }
+    if (rotation == ROTATE_0 || rotation == ROTATE_180) {
+        return flip_check(src, dst);
+    }
+    if (!src.isValid() || !dst.isValid() || src.getData() == dst.getData()
+            || src.getWidth() != dst.getHeight() || src.getHeight() != dst.getWidth()) {
+        return -1;
+    }
+    return 0;
+}
+
+#if IMG_USE_DSP
+// Reverse the order of the pixels of a 32-bit word.
+template <typename T>
+static inline uint32_t reverse_word(uint32_t w);
+
+template <>
+inline uint32_t reverse_word<uint8_t>(uint32_t w)
+{
+    return __REV(w);
+}
+
+template <>
+inline uint32_t reverse_word<uint16_t>(uint32_t w)
+{
+    return __ROR(w, 16);
+}
+#endif
+
+// Mirror two rows into each other: a_dst gets b_src mirrored and b_dst gets a_src mirrored.
+// The pixels are processed from both ends, so the destination rows can be the source rows,
+// and a single row is mirrored if a_src and b_src (and a_dst and b_dst) are the same row.
+template <typename T>
+static void mirror_rows(const T *a_src, const T *b_src, T *a_dst, T *b_dst, uint32_t w)
+{
+    bool same = (a_src == b_src);
+    uint32_t n = same ? w / 2 : w;
+    uint32_t i = 0;
+
+    #if IMG_USE_DSP
+    const uint32_t k = sizeof(uint32_t) / sizeof(T);
+    for (; i + k <= n; i += k) {
+        uint32_t a = img_read32(a_src + i);
+        uint32_t b = img_read32(b_src + w - i - k);
+        img_write32(a_dst + i, reverse_word<T>(b));
+        img_write32(b_dst + w - i - k, reverse_word<T>(a));
+    }
+    #endif
+
+    for (; i < n; i++) {
+        T a = a_src[i];
+        T b = b_src[w - 1 - i];
+        a_dst[i] = b;
+        b_dst[w - 1 - i] = a;
+    }
+    if (same && (w & 1)) {
+        a_dst[w / 2] = a_src[w / 2];
+    }
+}
+
+// Exchange two rows of the same image, 4 bytes at a time.
+static void swap_rows(uint8_t *a, uint8_t *b, uint32_t size)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        uint32_t t = img_read32(a + i);
+        img_write32(a + i, img_read32(b + i));
+        img_write32(b + i, t);
+    }
+    for (; i < size; i++) {
+        uint8_t t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+template <typename PixelFormat>
+static int flip_image(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, bool vflip, bool hmirror)
+{
+    typedef typename PixelFormat::pixel_t pixel_t;
+
+    if (flip_check(src, dst) != 0) {
+        return -1;
+    }
+
+    bool in_place = (src.getData() == dst.getData());
+    uint32_t w = src.getWidth();
+    uint32_t h = src.getHeight();
+    uint32_t size = w * sizeof(pixel_t);
+
+    if (!vflip) {
+        for (uint32_t y = 0; y < h; y++) {
+            if (hmirror) {
+                mirror_rows<pixel_t>(src.row(y), src.row(y), dst.row(y), dst.row(y), w);
+            } else if (!in_place) {
+                memcpy(dst.row(y), src.row(y), size);
+            }
+        }
+        return 0;
+    }
+
+    // Rows are processed by pairs from both ends, the middle row of an odd height only needs a mirror.
+    for (uint32_t y = 0; y < h / 2; y++) {
+        uint32_t y2 = h - 1 - y;
+        if (hmirror) {
+            mirror_rows<pixel_t>(src.row(y), src.row(y2), dst.row(y), dst.row(y2), w);
+        } else if (in_place) {
+            swap_rows((uint8_t *) dst.row(y), (uint8_t *) dst.row(y2), size);
+        } else {
+            memcpy(dst.row(y), src.row(y2), size);
+            memcpy(dst.row(y2), src.row(y), size);
+        }
+    }
+    if (h & 1) {
+        uint32_t y = h / 2;
+        if (hmirror) {
+            mirror_rows<pixel_t>(src.row(y), src.row(y), dst.row(y), dst.row(y), w);
+        } else if (!in_place) {
+            memcpy(dst.row(y), src.row(y), size);
+        }
+    }
+    return 0;
+}
+
+// Transpose the image by square tiles, so that the ROTATE_BLOCK source rows and destination rows
+// of a tile stay in the data cache, instead of writing a full destination column per source row.
+template <typename PixelFormat>
+static void rotate_blocked(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, bool clockwise)
+{
+    typedef typename PixelFormat::pixel_t pixel_t;
+    uint32_t w = src.getWidth();
+    uint32_t h = src.getHeight();
+    uint32_t stride = src.getStride();
+
+    for (uint32_t by = 0; by < h; by += ROTATE_BLOCK) {
+        uint32_t ey = (by + ROTATE_BLOCK < h) ? by + ROTATE_BLOCK : h;
+        for (uint32_t bx = 0; bx < w; bx += ROTATE_BLOCK) {
+            uint32_t ex = (bx + ROTATE_BLOCK < w) ? bx + ROTATE_BLOCK : w;
+            // Every source column of the tile is a destination row segment.
+            for (uint32_t x = bx; x < ex; x++) {
+                const uint8_t *s = (const uint8_t *) (src.row(by) + x);
+                if (clockwise) {
+                    pixel_t *d = dst.row(x) + (h - 1 - by);
+                    for (uint32_t y = by; y < ey; y++, s += stride) {
+                        *d-- = *(const pixel_t *) s;
+                    }
+                } else {
+                    pixel_t *d = dst.row(w - 1 - x) + by;
+                    for (uint32_t y = by; y < ey; y++, s += stride) {
+                        *d++ = *(const pixel_t *) s;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename PixelFormat>
+static int rotate_image(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, int32_t rotation)
+{
+    if (rotate_check(src, dst, rotation) != 0) {
+        return -1;
+    }
+
+    switch (rotation) {
+        case ROTATE_0:
+            return flip_image(src, dst, false, false);
+        case ROTATE_180:
+            return flip_image(src, dst, true, true);
+        default:
+            rotate_blocked(src, dst, rotation == ROTATE_90);
+            return 0;
+    }
+}
+
+int flipImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, bool vflip, bool hmirror)
+{
+    return flip_image(src, dst, vflip, hmirror);
+}
+
+int flipImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, bool vflip, bool hmirror)
+{
+    return flip_image(src, dst, vflip, hmirror);
+}
+
+int flipImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, bool vflip, bool hmirror)
+{
+    return flip_image(src, dst, vflip, hmirror);
+}
+
+int rotateImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, int32_t rotation)
+{
+    return rotate_image(src, dst, rotation);
+}
+
+int rotateImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, int32_t rotation)
+{
+    return rotate_image(src, dst, rotation);
+}
+
+int rotateImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, int32_t rotation)
+{
+    return rotate_image(src, dst, rotation);
+}
+
+bool flipFrameSupported(int32_t pixformat)
+{
+    return pixformat == CAMERA_GRAYSCALE || pixformat == CAMERA_RGB565 || pixformat == CAMERA_RGB565_LE;
+}
+
+int flipFrame(FrameBuffer &fb, bool vflip, bool hmirror)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE: {
+            ImageView<PixelGrayscale> frame(fb);
+            return flip_image(frame, frame, vflip, hmirror);
+        }
+        case CAMERA_RGB565: {
+            ImageView<PixelRGB565> frame(fb);
+            return flip_image(frame, frame, vflip, hmirror);
+        }
+        case CAMERA_RGB565_LE: {
+            ImageView<PixelRGB565LE> frame(fb);
+            return flip_image(frame, frame, vflip, hmirror);
+        }
+        default:
+            return -1;
+    }
+}
+
+/*
+ * Per-pixel reference implementations.
+ */
+template <typename PixelFormat>
+static int flip_image_reference(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, bool vflip, bool hmirror)
+{
+    if (flip_check(src, dst) != 0) {
+        return -1;
+    }
+
+    bool in_place = (src.getData() == dst.getData());
+    uint32_t w = src.getWidth();
+    uint32_t h = src.getHeight();
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            uint32_t sx = hmirror ? w - 1 - x : x;
+            uint32_t sy = vflip ? h - 1 - y : y;
+            if (!in_place) {
+                dst.at(x, y) = src.at(sx, sy);
+            } else if (sy * w + sx > y * w + x) {
+                // Every pair of pixels is exchanged once, from its first pixel.
+                typename PixelFormat::pixel_t t = dst.at(x, y);
+                dst.at(x, y) = dst.at(sx, sy);
+                dst.at(sx, sy) = t;
+            }
+        }
+    }
+    return 0;
+}
+
+template <typename PixelFormat>
+static int rotate_image_reference(const ImageView<PixelFormat> &src, const ImageView<PixelFormat> &dst, int32_t rotation)
+{
+    if (rotate_check(src, dst, rotation) != 0) {
+        return -1;
+    }
+    if (rotation == ROTATE_0 || rotation == ROTATE_180) {
+        return flip_image_reference(src, dst, rotation == ROTATE_180, rotation == ROTATE_180);
+    }
+
+    uint32_t w = src.getWidth();
+    uint32_t h = src.getHeight();
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            if (rotation == ROTATE_90) {
+                dst.at(h - 1 - y, x) = src.at(x, y);
+            } else {
+                dst.at(y, w - 1 - x) = src.at(x, y);
+            }
+        }
+    }
+    return 0;
+}
+
+int flipImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, bool vflip, bool hmirror)
+{
+    return flip_image_reference(src, dst, vflip, hmirror);
+}
+
+int flipImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, bool vflip, bool hmirror)
+{
+    return flip_image_reference(src, dst, vflip, hmirror);
+}
+
+int flipImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, bool vflip, bool hmirror)
+{
+    return flip_image_reference(src, dst, vflip, hmirror);
+}
+
+int rotateImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, int32_t rotation)
+{
+    return rotate_image_reference(src, dst, rotation);
+}
+
+int rotateImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, int32_t rotation)
+{
+    return rotate_image_reference(src, dst, rotation);
+}
+
+int rotateImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, int32_t rotation)
+{
+    return rotate_image_reference(src, dst, rotation);
+}
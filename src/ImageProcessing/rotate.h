@@ -0,0 +1,147 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image rotation and flip kernels.
+ */
+
+/**
+ * @file rotate.h
+ * @brief Rotation and flip kernels for 8-bit and 16-bit pixels.
+ *
+ * Some sensors can't flip or mirror the image themselves, these kernels do it for a camera
+ * mounted upside down or sideways. Camera::setVerticalFlip() and Camera::setHorizontalMirror()
+ * use them transparently when the sensor can't:
+ * @code {.cpp}
+ * ImageView<PixelGrayscale> frame(fb);
+ * ImageView<PixelGrayscale> rotated(buffer, frame.getHeight(), frame.getWidth());
+ * rotateImage(frame, rotated, ROTATE_90);
+ * @endcode
+ * Flips and 180° rotations can be done in place, by passing the same view as source and
+ * destination, they mirror the rows 4 bytes at a time from both ends. 90° and 270° rotations
+ * transpose the image by tiles of ROTATE_BLOCK x ROTATE_BLOCK pixels, so that the source and
+ * destination rows of a tile stay in the data cache, their source and destination must not overlap.
+ */
+
+#ifndef __ROTATE_H
+#define __ROTATE_H
+
+#include "imageview.h"
+
+/// Size in pixels of the square tiles of the 90° and 270° rotations
+#define ROTATE_BLOCK            (16)
+
+/// Rotation enumeration, clockwise
+enum {
+    ROTATE_0            = 0,
+    ROTATE_90           = 1,
+    ROTATE_180          = 2,
+    ROTATE_270          = 3,
+    ROTATE_MAX                  /* Sentinel value */
+};
+
+/**
+ * @brief Flip a grayscale image vertically and/or mirror it horizontally.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the same size, or the source view to flip in place
+ * @param vflip Set to true to flip the image vertically
+ * @param hmirror Set to true to mirror the image horizontally
+ * @return int 0 on success, -1 on failure
+ */
+int flipImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, bool vflip, bool hmirror);
+
+/**
+ * @brief Flip a big-endian RGB565 image vertically and/or mirror it horizontally.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the same size, or the source view to flip in place
+ * @param vflip Set to true to flip the image vertically
+ * @param hmirror Set to true to mirror the image horizontally
+ * @return int 0 on success, -1 on failure
+ */
+int flipImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, bool vflip, bool hmirror);
+
+/**
+ * @brief Flip a little-endian RGB565 image vertically and/or mirror it horizontally.
+ *
+ * @param src The source image
+ * @param dst The destination image, of the same size, or the source view to flip in place
+ * @param vflip Set to true to flip the image vertically
+ * @param hmirror Set to true to mirror the image horizontally
+ * @return int 0 on success, -1 on failure
+ */
+int flipImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, bool vflip, bool hmirror);
+
+/**
+ * @brief Rotate a grayscale image clockwise.
+ *
+ * @param src The source image
+ * @param dst The destination image, its width and height are swapped for ROTATE_90 and ROTATE_270
+ * @param rotation The rotation, as defined in the rotation enum
+ * @return int 0 on success, -1 on failure
+ */
+int rotateImage(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, int32_t rotation);
+
+/**
+ * @brief Rotate a big-endian RGB565 image clockwise.
+ *
+ * @param src The source image
+ * @param dst The destination image, its width and height are swapped for ROTATE_90 and ROTATE_270
+ * @param rotation The rotation, as defined in the rotation enum
+ * @return int 0 on success, -1 on failure
+ */
+int rotateImage(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, int32_t rotation);
+
+/**
+ * @brief Rotate a little-endian RGB565 image clockwise.
+ *
+ * @param src The source image
+ * @param dst The destination image, its width and height are swapped for ROTATE_90 and ROTATE_270
+ * @param rotation The rotation, as defined in the rotation enum
+ * @return int 0 on success, -1 on failure
+ */
+int rotateImage(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, int32_t rotation);
+
+/**
+ * @brief Check if the frames of a pixel format can be flipped by flipFrame().
+ *
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @return true if flipFrame() supports the pixel format, false otherwise
+ */
+bool flipFrameSupported(int32_t pixformat);
+
+/**
+ * @brief Flip the grayscale or RGB565 frame stored in a frame buffer in place.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param vflip Set to true to flip the frame vertically
+ * @param hmirror Set to true to mirror the frame horizontally
+ * @return int 0 on success, -1 on failure
+ */
+int flipFrame(FrameBuffer &fb, bool vflip, bool hmirror);
+
+/*
+ * Per-pixel reference implementations.
+ * They are always available, so the results of the blocked kernels can be checked against them.
+ */
+int flipImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, bool vflip, bool hmirror);
+int flipImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, bool vflip, bool hmirror);
+int flipImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, bool vflip, bool hmirror);
+int rotateImageReference(const ImageView<PixelGrayscale> &src, const ImageView<PixelGrayscale> &dst, int32_t rotation);
+int rotateImageReference(const ImageView<PixelRGB565> &src, const ImageView<PixelRGB565> &dst, int32_t rotation);
+int rotateImageReference(const ImageView<PixelRGB565LE> &src, const ImageView<PixelRGB565LE> &dst, int32_t rotation);
+
+#endif /* __ROTATE_H */
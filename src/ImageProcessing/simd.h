@@ -0,0 +1,54 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SIMD helpers shared by the image processing kernels.
+ * This header is private to the library and only included by the kernel sources.
+ */
+#ifndef __IMG_SIMD_H
+#define __IMG_SIMD_H
+
+#include "Arduino.h"
+#include <string.h>
+
+// The Cortex-M7 and M4 cores have the DSP extension, which provides the
+// packed 8/16-bit SIMD instructions (CMSIS intrinsics such as __UHADD8).
+// Every kernel also has a portable scalar implementation that computes
+// the exact same result, which is used on cores without the extension.
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define IMG_USE_DSP                 (1)
+#else
+#define IMG_USE_DSP                 (0)
+#endif
+
+// Unaligned 32-bit accesses, supported by the Cortex-M7 and M4 cores on normal memory.
+static inline uint32_t img_read32(const void *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void img_write32(void *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline uint8_t img_clamp8(int32_t x)
+{
+    return (x < 0) ? 0 : ((x > 255) ? 255 : x);
+}
+
+#endif /* __IMG_SIMD_H */
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image statistics kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "stats.h"
+
+// Number of pixels converted to luma at once, for the formats other than grayscale
+#define STATS_CHUNK             (64)
+
+int statsBegin(ImageStats &stats, uint32_t width, uint32_t height, uint32_t grid_cols, uint32_t grid_rows)
+{
+    if (width == 0 || height == 0 || width > STATS_WIDTH_MAX || height > 0xFFFF
+            || grid_cols == 0 || grid_cols > STATS_GRID_MAX || grid_cols > width
+            || grid_rows == 0 || grid_rows > STATS_GRID_MAX || grid_rows > height) {
+        return -1;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    stats.width = width;
+    stats.height = height;
+    stats.grid_cols = grid_cols;
+    stats.grid_rows = grid_rows;
+    for (uint32_t i = 0; i <= grid_cols; i++) {
+        stats.col_edges[i] = i * width / grid_cols;
+    }
+    for (uint32_t i = 0; i <= grid_rows; i++) {
+        stats.row_edges[i] = i * height / grid_rows;
+    }
+    return 0;
+}
+
+// Accumulate n consecutive luma values of a block row segment.
+static void stats_segment(ImageStats &stats, const uint8_t *p, uint32_t n, uint32_t *block_sum, bool fast)
+{
+    uint32_t *hist = stats.histogram;
+    uint32_t sum = 0;
+    uint32_t sum_sq = 0;
+    uint32_t i = 0;
+
+    #if IMG_USE_DSP
+    if (fast) {
+        for (; i + 4 <= n; i += 4) {
+            uint32_t w = img_read32(p + i);
+            uint32_t even = __UXTB16(w);
+            uint32_t odd = __UXTB16(__ROR(w, 8));
+            sum = __USADA8(w, 0, sum);
+            sum_sq = __SMLAD(even, even, sum_sq);
+            sum_sq = __SMLAD(odd, odd, sum_sq);
+            hist[w & 0xFF]++;
+            hist[(w >> 8) & 0xFF]++;
+            hist[(w >> 16) & 0xFF]++;
+            hist[w >> 24]++;
+        }
+    }
+    #endif
+
+    for (; i < n; i++) {
+        uint32_t v = p[i];
+        sum += v;
+        sum_sq += v * v;
+        hist[v]++;
+    }
+
+    stats.count += n;
+    stats.sum += sum;
+    stats.sum_sq += sum_sq;
+    *block_sum += sum;
+}
+
+// Extract the luma of a pixel of the formats other than grayscale.
+template <typename PixelFormat>
+static inline uint8_t stats_luma(const typename PixelFormat::pixel_t *row, uint32_t x)
+{
+    if (PixelFormat::format == CAMERA_YUV422) {
+        return ((const uint8_t *) row)[2 * x];
+    }
+    int32_t r, g, b;
+    rgb565_unpack(rgb565_load<PixelFormat>(row, x), &r, &g, &b);
+    return rgb_to_luma(r, g, b);
+}
+
+template <typename PixelFormat>
+static int stats_update(ImageStats &stats, const ImageView<PixelFormat> &band, uint32_t y, bool fast)
+{
+    if (!band.isValid() || band.getWidth() != stats.width
+            || y > stats.height || band.getHeight() > stats.height - y) {
+        return -1;
+    }
+
+    // Grid row of the first row of the band
+    uint32_t grid_row = 0;
+    while (y >= stats.row_edges[grid_row + 1]) {
+        grid_row++;
+    }
+
+    for (uint32_t by = 0; by < band.getHeight(); by++, y++) {
+        if (y >= stats.row_edges[grid_row + 1]) {
+            grid_row++;
+        }
+        const typename PixelFormat::pixel_t *row = band.row(by);
+        uint32_t *block_sums = &stats.block_sums[grid_row * stats.grid_cols];
+
+        for (uint32_t c = 0; c < stats.grid_cols; c++) {
+            uint32_t x0 = stats.col_edges[c];
+            uint32_t x1 = stats.col_edges[c + 1];
+            if (PixelFormat::format == CAMERA_GRAYSCALE) {
+                stats_segment(stats, (const uint8_t *) row + x0, x1 - x0, &block_sums[c], fast);
+                continue;
+            }
+            for (uint32_t x = x0; x < x1; x += STATS_CHUNK) {
+                uint8_t luma[STATS_CHUNK];
+                uint32_t n = (x1 - x < STATS_CHUNK) ? x1 - x : STATS_CHUNK;
+                for (uint32_t i = 0; i < n; i++) {
+                    luma[i] = stats_luma<PixelFormat>(row, x + i);
+                }
+                stats_segment(stats, luma, n, &block_sums[c], fast);
+            }
+        }
+    }
+    return 0;
+}
+
+int statsUpdate(ImageStats &stats, const ImageView<PixelGrayscale> &band, uint32_t y)
+{
+    return stats_update(stats, band, y, true);
+}
+
+int statsUpdate(ImageStats &stats, const ImageView<PixelYUV422> &band, uint32_t y)
+{
+    return stats_update(stats, band, y, true);
+}
+
+int statsUpdate(ImageStats &stats, const ImageView<PixelRGB565> &band, uint32_t y)
+{
+    return stats_update(stats, band, y, true);
+}
+
+int statsUpdate(ImageStats &stats, const ImageView<PixelRGB565LE> &band, uint32_t y)
+{
+    return stats_update(stats, band, y, true);
+}
+
+int statsUpdateReference(ImageStats &stats, const ImageView<PixelGrayscale> &band, uint32_t y)
+{
+    return stats_update(stats, band, y, false);
+}
+
+template <typename PixelFormat>
+static int frame_stats(FrameBuffer &fb, ImageStats &stats, uint32_t grid_cols, uint32_t grid_rows)
+{
+    ImageView<PixelFormat> frame(fb);
+    if (statsBegin(stats, frame.getWidth(), frame.getHeight(), grid_cols, grid_rows) != 0) {
+        return -1;
+    }
+    return stats_update(stats, frame, 0, true);
+}
+
+int frameStats(FrameBuffer &fb, ImageStats &stats, uint32_t grid_cols, uint32_t grid_rows)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return frame_stats<PixelGrayscale>(fb, stats, grid_cols, grid_rows);
+        case CAMERA_YUV422:
+            return frame_stats<PixelYUV422>(fb, stats, grid_cols, grid_rows);
+        case CAMERA_RGB565:
+            return frame_stats<PixelRGB565>(fb, stats, grid_cols, grid_rows);
+        case CAMERA_RGB565_LE:
+            return frame_stats<PixelRGB565LE>(fb, stats, grid_cols, grid_rows);
+        default:
+            return -1;
+    }
+}
+
+float statsMean(const ImageStats &stats)
+{
+    if (stats.count == 0) {
+        return 0.0f;
+    }
+    return (float) stats.sum / stats.count;
+}
+
+float statsVariance(const ImageStats &stats)
+{
+    if (stats.count == 0) {
+        return 0.0f;
+    }
+    float mean = (float) stats.sum / stats.count;
+    float variance = (float) stats.sum_sq / stats.count - mean * mean;
+    return (variance > 0.0f) ? variance : 0.0f;
+}
+
+uint8_t statsMin(const ImageStats &stats)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        if (stats.histogram[i]) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+uint8_t statsMax(const ImageStats &stats)
+{
+    for (uint32_t i = 256; i > 0; i--) {
+        if (stats.histogram[i - 1]) {
+            return i - 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t statsBlockMean(const ImageStats &stats, uint32_t col, uint32_t row)
+{
+    if (col >= stats.grid_cols || row >= stats.grid_rows) {
+        return 0;
+    }
+    uint32_t area = (stats.col_edges[col + 1] - stats.col_edges[col])
+            * (stats.row_edges[row + 1] - stats.row_edges[row]);
+    return (stats.block_sums[row * stats.grid_cols + col] + area / 2) / area;
+}
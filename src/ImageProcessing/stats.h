@@ -0,0 +1,182 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Image statistics kernels.
+ */
+
+/**
+ * @file stats.h
+ * @brief Single pass image statistics: histogram, mean, variance, block means, min and max.
+ *
+ * The statistics of the luma of a frame are accumulated in a single pass, so that auto exposure,
+ * motion checks and quality gating don't rescan the frame:
+ * @code {.cpp}
+ * ImageStats stats;
+ * if (cam.grabFrame(fb, 3000) == 0 && frameStats(fb, stats, 4, 3) == 0) {
+ *     Serial.println(statsMean(stats));
+ *     Serial.println(statsBlockMean(stats, 0, 0));
+ * }
+ * @endcode
+ * The statistics can also be accumulated band by band, as the rows of a frame are received,
+ * by calling statsBegin() once and then statsUpdate() for every band, so the numbers are ready
+ * when the last band is done.
+ *
+ * Grayscale pixels are summed 4 at a time with __USADA8, their squares with __SMLAD.
+ * The luma of YUV422 and RGB565 pixels is extracted by chunks and accumulated the same way.
+ */
+
+#ifndef __STATS_H
+#define __STATS_H
+
+#include "imageview.h"
+
+/// Maximum number of columns and rows of the grid of blocks
+#define STATS_GRID_MAX          (16)
+/// Maximum width of the frames, so that the sum of the squares of a row fits in 31 bits
+#define STATS_WIDTH_MAX         (16384)
+
+/**
+ * @struct ImageStats
+ * @brief Statistics of the luma of a frame.
+ * The frame is divided in a grid of grid_cols x grid_rows blocks of nearly equal sizes.
+ */
+struct ImageStats {
+    uint32_t histogram[256];    /// Number of pixels of every luma value
+    uint32_t count;             /// Number of pixels accumulated
+    uint64_t sum;               /// Sum of the luma values
+    uint64_t sum_sq;            /// Sum of the squared luma values
+    uint32_t width;             /// Width of the frame in pixels
+    uint32_t height;            /// Height of the frame in pixels
+    uint32_t grid_cols;         /// Number of columns of the grid of blocks
+    uint32_t grid_rows;         /// Number of rows of the grid of blocks
+    uint16_t col_edges[STATS_GRID_MAX + 1];     /// First column of every block column, then the width
+    uint16_t row_edges[STATS_GRID_MAX + 1];     /// First row of every block row, then the height
+    uint32_t block_sums[STATS_GRID_MAX * STATS_GRID_MAX];   /// Sum of the luma values of every block, row by row
+};
+
+/**
+ * @brief Reset the statistics before accumulating the bands of a frame.
+ *
+ * @param stats The statistics to reset
+ * @param width The width of the frame, up to STATS_WIDTH_MAX
+ * @param height The height of the frame
+ * @param grid_cols The number of columns of the grid of blocks, up to STATS_GRID_MAX (default: 1)
+ * @param grid_rows The number of rows of the grid of blocks, up to STATS_GRID_MAX (default: 1)
+ * @return int 0 on success, -1 on failure
+ */
+int statsBegin(ImageStats &stats, uint32_t width, uint32_t height, uint32_t grid_cols=1, uint32_t grid_rows=1);
+
+/**
+ * @brief Accumulate the statistics of a band of rows of a grayscale frame.
+ *
+ * @param stats The statistics, reset by statsBegin()
+ * @param band The band, as wide as the frame
+ * @param y The index in the frame of the first row of the band
+ * @return int 0 on success, -1 on failure
+ */
+int statsUpdate(ImageStats &stats, const ImageView<PixelGrayscale> &band, uint32_t y);
+
+/**
+ * @brief Accumulate the statistics of the luma of a band of rows of a YUV422 frame.
+ *
+ * @param stats The statistics, reset by statsBegin()
+ * @param band The band, as wide as the frame
+ * @param y The index in the frame of the first row of the band
+ * @return int 0 on success, -1 on failure
+ */
+int statsUpdate(ImageStats &stats, const ImageView<PixelYUV422> &band, uint32_t y);
+
+/**
+ * @brief Accumulate the statistics of the luma of a band of rows of a big-endian RGB565 frame.
+ *
+ * @param stats The statistics, reset by statsBegin()
+ * @param band The band, as wide as the frame
+ * @param y The index in the frame of the first row of the band
+ * @return int 0 on success, -1 on failure
+ */
+int statsUpdate(ImageStats &stats, const ImageView<PixelRGB565> &band, uint32_t y);
+
+/**
+ * @brief Accumulate the statistics of the luma of a band of rows of a little-endian RGB565 frame.
+ *
+ * @param stats The statistics, reset by statsBegin()
+ * @param band The band, as wide as the frame
+ * @param y The index in the frame of the first row of the band
+ * @return int 0 on success, -1 on failure
+ */
+int statsUpdate(ImageStats &stats, const ImageView<PixelRGB565LE> &band, uint32_t y);
+
+/**
+ * @brief Compute the statistics of the grayscale, YUV422 or RGB565 frame stored in a frame buffer.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param stats The statistics to compute
+ * @param grid_cols The number of columns of the grid of blocks, up to STATS_GRID_MAX (default: 1)
+ * @param grid_rows The number of rows of the grid of blocks, up to STATS_GRID_MAX (default: 1)
+ * @return int 0 on success, -1 on failure
+ */
+int frameStats(FrameBuffer &fb, ImageStats &stats, uint32_t grid_cols=1, uint32_t grid_rows=1);
+
+/**
+ * @brief Get the mean of the luma values.
+ *
+ * @param stats The statistics
+ * @return float The mean, 0 if no pixel was accumulated
+ */
+float statsMean(const ImageStats &stats);
+
+/**
+ * @brief Get the variance of the luma values.
+ *
+ * @param stats The statistics
+ * @return float The variance, 0 if no pixel was accumulated
+ */
+float statsVariance(const ImageStats &stats);
+
+/**
+ * @brief Get the lowest luma value, from the histogram.
+ *
+ * @param stats The statistics
+ * @return uint8_t The lowest value, 0 if no pixel was accumulated
+ */
+uint8_t statsMin(const ImageStats &stats);
+
+/**
+ * @brief Get the highest luma value, from the histogram.
+ *
+ * @param stats The statistics
+ * @return uint8_t The highest value, 0 if no pixel was accumulated
+ */
+uint8_t statsMax(const ImageStats &stats);
+
+/**
+ * @brief Get the mean of the luma values of a block of the grid, rounded to the nearest integer.
+ * The mean is complete once all the rows of the block were accumulated.
+ *
+ * @param stats The statistics
+ * @param col The column of the block in the grid
+ * @param row The row of the block in the grid
+ * @return uint8_t The mean, 0 if the block is outside of the grid
+ */
+uint8_t statsBlockMean(const ImageStats &stats, uint32_t col, uint32_t row);
+
+/*
+ * Portable scalar reference implementation.
+ * It is always available, so the results of the accelerated kernel can be checked against it.
+ */
+int statsUpdateReference(ImageStats &stats, const ImageView<PixelGrayscale> &band, uint32_t y);
+
+#endif /* __STATS_H */
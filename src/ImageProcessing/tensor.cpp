@@ -0,0 +1,216 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Model input tensor kernels.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "tensor.h"
+#include <math.h>
+
+// Build the table of the quantized values of the 256 pixel values.
+static void tensor_lut(const TensorDescriptor &tensor, uint8_t *lut)
+{
+    int32_t qmin = (tensor.type == TENSOR_INT8) ? -128 : 0;
+    int32_t qmax = (tensor.type == TENSOR_INT8) ? 127 : 255;
+
+    for (int32_t p = 0; p < 256; p++) {
+        float value = tensor.min + p * (tensor.max - tensor.min) / 255.0f;
+        int32_t q = (int32_t) lroundf(value / tensor.scale) + tensor.zero_point;
+        q = (q < qmin) ? qmin : ((q > qmax) ? qmax : q);
+        lut[p] = (uint8_t) q;
+    }
+}
+
+int tensorBegin(TensorConverter &tc, const TensorDescriptor &tensor, uint32_t src_width, uint32_t src_height,
+        int32_t method)
+{
+    if (tensor.data == NULL || tensor.width == 0 || tensor.height == 0
+            || (tensor.channels != 1 && tensor.channels != 3)
+            || tensor.type < 0 || tensor.type >= TENSOR_MAX || !(tensor.scale > 0.0f)
+            || (method != RESIZE_NEAREST && method != RESIZE_BILINEAR)) {
+        return -1;
+    }
+
+    memset(&tc, 0, sizeof(tc));
+    tc.xc = (ResizeCoord *) malloc((tensor.width + tensor.height) * sizeof(ResizeCoord));
+    if (tc.xc == NULL) {
+        return -1;
+    }
+    tc.yc = tc.xc + tensor.width;
+    if (resizeCoords(src_width, tensor.width, method, tc.xc) != 0
+            || resizeCoords(src_height, tensor.height, method, tc.yc) != 0) {
+        tensorEnd(tc);
+        return -1;
+    }
+
+    tc.tensor = tensor;
+    tc.src_width = src_width;
+    tc.src_height = src_height;
+    tc.method = method;
+    tensor_lut(tensor, tc.lut);
+    return 0;
+}
+
+void tensorEnd(TensorConverter &tc)
+{
+    free(tc.xc);
+    tc.xc = NULL;
+    tc.yc = NULL;
+}
+
+template <typename PixelFormat>
+static int image_to_tensor(const TensorConverter &tc, const ImageView<PixelFormat> &src)
+{
+    const uint32_t channels = PixelAccess<PixelFormat>::channels;
+    const TensorDescriptor &tensor = tc.tensor;
+    const ResizeCoord *xc = tc.xc;
+    const ResizeCoord *yc = tc.yc;
+    const uint8_t *lut = tc.lut;
+
+    if (!src.isValid() || xc == NULL || src.getWidth() != tc.src_width || src.getHeight() != tc.src_height) {
+        return -1;
+    }
+
+    uint8_t *out = (uint8_t *) tensor.data;
+    for (uint32_t ty = 0; ty < tensor.height; ty++) {
+        const typename PixelFormat::pixel_t *r0 = src.row(yc[ty].i0);
+        const typename PixelFormat::pixel_t *r1 = src.row(yc[ty].i1);
+        int32_t wy1 = yc[ty].w1;
+        int32_t wy0 = 256 - wy1;
+
+        for (uint32_t tx = 0; tx < tensor.width; tx++) {
+            int32_t c[channels];
+            if (tc.method == RESIZE_NEAREST) {
+                PixelAccess<PixelFormat>::read(r0, xc[tx].i0, c);
+            } else {
+                // Same rounding as resizeImage(), so the fused kernel gives the same result.
+                int32_t c00[channels], c01[channels], c10[channels], c11[channels];
+                int32_t wx1 = xc[tx].w1;
+                int32_t wx0 = 256 - wx1;
+                PixelAccess<PixelFormat>::read(r0, xc[tx].i0, c00);
+                PixelAccess<PixelFormat>::read(r0, xc[tx].i1, c01);
+                PixelAccess<PixelFormat>::read(r1, xc[tx].i0, c10);
+                PixelAccess<PixelFormat>::read(r1, xc[tx].i1, c11);
+                for (uint32_t i = 0; i < channels; i++) {
+                    int32_t top = c00[i] * wx0 + c01[i] * wx1;
+                    int32_t bottom = c10[i] * wx0 + c11[i] * wx1;
+                    c[i] = (top * wy0 + bottom * wy1 + 0x8000) >> 16;
+                }
+            }
+
+            if (tensor.channels == 1) {
+                *out++ = lut[(channels == 1) ? c[0] : rgb_to_luma(c[0], c[1], c[2])];
+            } else {
+                *out++ = lut[c[0]];
+                *out++ = lut[c[(channels == 1) ? 0 : 1]];
+                *out++ = lut[c[(channels == 1) ? 0 : 2]];
+            }
+        }
+    }
+    return 0;
+}
+
+template <typename PixelFormat>
+static int image_to_tensor(const ImageView<PixelFormat> &src, const TensorDescriptor &tensor, int32_t method)
+{
+    TensorConverter tc;
+    if (!src.isValid() || tensorBegin(tc, tensor, src.getWidth(), src.getHeight(), method) != 0) {
+        return -1;
+    }
+    int ret = image_to_tensor(tc, src);
+    tensorEnd(tc);
+    return ret;
+}
+
+int imageToTensor(const ImageView<PixelGrayscale> &src, const TensorDescriptor &tensor, int32_t method)
+{
+    return image_to_tensor(src, tensor, method);
+}
+
+int imageToTensor(const ImageView<PixelRGB565> &src, const TensorDescriptor &tensor, int32_t method)
+{
+    return image_to_tensor(src, tensor, method);
+}
+
+int imageToTensor(const ImageView<PixelRGB565LE> &src, const TensorDescriptor &tensor, int32_t method)
+{
+    return image_to_tensor(src, tensor, method);
+}
+
+template <typename PixelFormat>
+static int frame_to_tensor(FrameBuffer &fb, const TensorDescriptor &tensor,
+        uint32_t x, uint32_t y, uint32_t w, uint32_t h, int32_t method)
+{
+    ImageView<PixelFormat> frame(fb);
+    if (x > frame.getWidth() || y > frame.getHeight()) {
+        return -1;
+    }
+    w = w ? w : frame.getWidth() - x;
+    h = h ? h : frame.getHeight() - y;
+    return image_to_tensor(frame.subView(x, y, w, h), tensor, method);
+}
+
+int frameToTensor(FrameBuffer &fb, const TensorDescriptor &tensor,
+        uint32_t x, uint32_t y, uint32_t w, uint32_t h, int32_t method)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return frame_to_tensor<PixelGrayscale>(fb, tensor, x, y, w, h, method);
+        case CAMERA_RGB565:
+            return frame_to_tensor<PixelRGB565>(fb, tensor, x, y, w, h, method);
+        case CAMERA_RGB565_LE:
+            return frame_to_tensor<PixelRGB565LE>(fb, tensor, x, y, w, h, method);
+        default:
+            return -1;
+    }
+}
+
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelGrayscale> &src)
+{
+    return image_to_tensor(tc, src);
+}
+
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelRGB565> &src)
+{
+    return image_to_tensor(tc, src);
+}
+
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelRGB565LE> &src)
+{
+    return image_to_tensor(tc, src);
+}
+
+template <typename PixelFormat>
+static int frame_to_tensor(FrameBuffer &fb, const TensorConverter &tc, uint32_t x, uint32_t y)
+{
+    ImageView<PixelFormat> frame(fb);
+    return image_to_tensor(tc, frame.subView(x, y, tc.src_width, tc.src_height));
+}
+
+int frameToTensor(FrameBuffer &fb, const TensorConverter &tc, uint32_t x, uint32_t y)
+{
+    switch (fb.getPixelFormat()) {
+        case CAMERA_GRAYSCALE:
+            return frame_to_tensor<PixelGrayscale>(fb, tc, x, y);
+        case CAMERA_RGB565:
+            return frame_to_tensor<PixelRGB565>(fb, tc, x, y);
+        case CAMERA_RGB565_LE:
+            return frame_to_tensor<PixelRGB565LE>(fb, tc, x, y);
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Model input tensor kernels.
+ */
+
+/**
+ * @file tensor.h
+ * @brief Fused crop, resize and quantize of a frame into a model input tensor.
+ *
+ * A single pass reads the region of interest of a frame, resizes it and writes the quantized
+ * values to the input tensor of a model, e.g. a TensorFlow Lite Micro model, without any
+ * intermediate image:
+ * @code {.cpp}
+ * TfLiteTensor *input = interpreter.input(0);
+ * TensorDescriptor tensor = { input->data.int8, 96, 96, 1, TENSOR_INT8,
+ *                             input->params.scale, input->params.zero_point, 0.0f, 1.0f };
+ * if (cam.grabFrame(fb, 3000) == 0) {
+ *     frameToTensor(fb, tensor, 40, 0, 240, 240);
+ *     interpreter.Invoke();
+ * }
+ * @endcode
+ * The coordinate tables of the resize and the table of the quantized values are built for
+ * every call. To keep them from frame to frame, when the region of interest has a fixed size,
+ * use a TensorConverter:
+ * @code {.cpp}
+ * TensorConverter tc;
+ * tensorBegin(tc, tensor, 240, 240);
+ * while (cam.grabFrame(fb, 3000) == 0) {
+ *     frameToTensor(fb, tc, 40, 0);
+ *     interpreter.Invoke();
+ * }
+ * tensorEnd(tc);
+ * @endcode
+ * The tensor is laid out as NHWC with a batch of 1: rows of pixels, with interleaved channels.
+ * The pixels are resized exactly as resizeImage() does. Every 8-bit pixel value p is then mapped
+ * to the real value min + p * (max - min) / 255 the model expects, and quantized to
+ * round(value / scale) + zero_point, saturated to the range of the tensor type.
+ */
+
+#ifndef __TENSOR_H
+#define __TENSOR_H
+
+#include "imageview.h"
+#include "resize.h"
+
+/// Tensor type enumeration
+enum {
+    TENSOR_UINT8        = 0,
+    TENSOR_INT8         = 1,
+    TENSOR_MAX                  /* Sentinel value */
+};
+
+/**
+ * @struct TensorDescriptor
+ * @brief Describes the layout and the quantization of a model input tensor.
+ */
+struct TensorDescriptor {
+    void *data;             /// Tensor buffer, of width * height * channels bytes
+    uint32_t width;         /// Width of the tensor in pixels
+    uint32_t height;        /// Height of the tensor in pixels
+    uint32_t channels;      /// 1 for grayscale, 3 for RGB
+    int32_t type;           /// Type of the elements, as defined in the tensor type enum
+    float scale;            /// Quantization scale
+    int32_t zero_point;     /// Quantization zero point
+    float min;              /// Real value of the black pixels, e.g. 0.0f or -1.0f
+    float max;              /// Real value of the white pixels, e.g. 1.0f or 255.0f
+};
+
+/**
+ * @struct TensorConverter
+ * @brief State of the conversion of images of a fixed size into a tensor.
+ */
+struct TensorConverter {
+    TensorDescriptor tensor;    /// The destination tensor
+    uint32_t src_width;         /// Width of the source images
+    uint32_t src_height;        /// Height of the source images
+    int32_t method;             /// Resize method, RESIZE_NEAREST or RESIZE_BILINEAR
+    ResizeCoord *xc;            /// Source coordinates of the columns of the tensor
+    ResizeCoord *yc;            /// Source coordinates of the rows of the tensor
+    uint8_t lut[256];           /// Quantized value of every pixel value
+};
+
+/**
+ * @brief Allocate and build the tables of the conversion of images of a given size into a tensor.
+ *
+ * @param tc The state
+ * @param tensor The destination tensor
+ * @param src_width The width of the source images
+ * @param src_height The height of the source images
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int tensorBegin(TensorConverter &tc, const TensorDescriptor &tensor, uint32_t src_width, uint32_t src_height,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Free the memory of the conversion into a tensor.
+ *
+ * @param tc The state
+ */
+void tensorEnd(TensorConverter &tc);
+
+/**
+ * @brief Resize and quantize a grayscale image into a tensor.
+ * An RGB tensor gets the same value in all channels.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param tensor The destination tensor
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int imageToTensor(const ImageView<PixelGrayscale> &src, const TensorDescriptor &tensor,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize and quantize a big-endian RGB565 image into a tensor.
+ * A grayscale tensor gets the BT.601 luma of the pixels.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param tensor The destination tensor
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int imageToTensor(const ImageView<PixelRGB565> &src, const TensorDescriptor &tensor,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize and quantize a little-endian RGB565 image into a tensor.
+ * A grayscale tensor gets the BT.601 luma of the pixels.
+ *
+ * @param src The source image, it can be a sub-view
+ * @param tensor The destination tensor
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int imageToTensor(const ImageView<PixelRGB565LE> &src, const TensorDescriptor &tensor,
+        int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Crop, resize and quantize the grayscale or RGB565 frame stored in a frame buffer into a tensor.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param tensor The destination tensor
+ * @param x The x-coordinate of the region of interest (default: 0)
+ * @param y The y-coordinate of the region of interest (default: 0)
+ * @param w The width of the region of interest (default: 0, up to the right edge of the frame)
+ * @param h The height of the region of interest (default: 0, up to the bottom edge of the frame)
+ * @param method The resize method, RESIZE_NEAREST or RESIZE_BILINEAR (default: RESIZE_BILINEAR)
+ * @return int 0 on success, -1 on failure
+ */
+int frameToTensor(FrameBuffer &fb, const TensorDescriptor &tensor, uint32_t x=0, uint32_t y=0,
+        uint32_t w=0, uint32_t h=0, int32_t method=RESIZE_BILINEAR);
+
+/**
+ * @brief Resize and quantize an image into the tensor of a converter.
+ *
+ * @param tc The state, for images of the size of the source
+ * @param src The source image, it can be a sub-view
+ * @return int 0 on success, -1 on failure
+ */
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelGrayscale> &src);
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelRGB565> &src);
+int imageToTensor(const TensorConverter &tc, const ImageView<PixelRGB565LE> &src);
+
+/**
+ * @brief Crop, resize and quantize the grayscale or RGB565 frame stored in a frame buffer into the
+ * tensor of a converter. The region of interest has the size of the source images of the converter.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param tc The state
+ * @param x The x-coordinate of the region of interest (default: 0)
+ * @param y The y-coordinate of the region of interest (default: 0)
+ * @return int 0 on success, -1 on failure
+ */
+int frameToTensor(FrameBuffer &fb, const TensorConverter &tc, uint32_t x=0, uint32_t y=0);
+
+#endif /* __TENSOR_H */
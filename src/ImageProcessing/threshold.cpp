@@ -0,0 +1,195 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Thresholding to bit-packed masks.
+ */
+#include "simd.h"
+#include "pixel.h"
+#include "stats.h"
+#include "threshold.h"
+
+int otsuThreshold(const uint32_t *histogram)
+{
+    if (histogram == NULL) {
+        return -1;
+    }
+
+    uint32_t total = 0;
+    uint64_t sum = 0;
+    for (uint32_t v = 0; v < 256; v++) {
+        total += histogram[v];
+        sum += (uint64_t) v * histogram[v];
+    }
+    if (total == 0) {
+        return -1;
+    }
+
+    // Maximize the variance between the classes, (sum * w0 - sum0 * total)^2 / (w0 * w1)
+    // up to a constant factor.
+    int threshold = 0;
+    float best = -1.0f;
+    uint32_t w0 = 0;
+    uint64_t sum0 = 0;
+    for (uint32_t t = 0; t < 255; t++) {
+        w0 += histogram[t];
+        sum0 += (uint64_t) t * histogram[t];
+        uint32_t w1 = total - w0;
+        if (w0 == 0 || w1 == 0) {
+            continue;
+        }
+        float diff = (float) ((int64_t) (sum * w0) - (int64_t) (sum0 * total));
+        float between = diff * diff / ((float) w0 * w1);
+        if (between > best) {
+            best = between;
+            threshold = t;
+        }
+    }
+    return threshold;
+}
+
+static int threshold_image(const ImageView<PixelGrayscale> &src, uint32_t *mask, uint8_t threshold, bool invert, bool fast)
+{
+    if (!src.isValid() || mask == NULL) {
+        return -1;
+    }
+
+    uint32_t width = src.getWidth();
+    uint32_t words = MASK_ROW_WORDS(width);
+    uint32_t flip = invert ? 0xFFFFFFFF : 0;
+    for (uint32_t y = 0; y < src.getHeight(); y++) {
+        const uint8_t *p = src.row(y);
+        uint32_t *m = mask + y * words;
+        for (uint32_t x0 = 0; x0 < width; x0 += 32) {
+            uint32_t n = (width - x0 < 32) ? width - x0 : 32;
+            uint32_t bits = 0;
+            uint32_t x = 0;
+
+            #if IMG_USE_DSP
+            if (fast) {
+                // The bytes of p - threshold are not 0 for the pixels above the threshold, adding
+                // 127 with saturation moves them to the top bit of the bytes.
+                uint32_t t4 = threshold * 0x01010101u;
+                for (; x + 4 <= n; x += 4) {
+                    uint32_t above = __UQADD8(__UQSUB8(img_read32(p + x0 + x), t4), 0x7F7F7F7F);
+                    uint32_t b = ((above >> 7) & 1) | ((above >> 14) & 2) | ((above >> 21) & 4) | ((above >> 28) & 8);
+                    bits |= b << x;
+                }
+            }
+            #endif
+
+            for (; x < n; x++) {
+                bits |= (uint32_t) (p[x0 + x] > threshold) << x;
+            }
+
+            bits ^= flip;
+            // Keep the bits after the last pixel clear
+            if (n < 32) {
+                bits &= (1u << n) - 1;
+            }
+            m[x0 / 32] = bits;
+        }
+    }
+    return 0;
+}
+
+int thresholdImage(const ImageView<PixelGrayscale> &src, uint32_t *mask, uint8_t threshold, bool invert)
+{
+    return threshold_image(src, mask, threshold, invert, true);
+}
+
+int thresholdImageReference(const ImageView<PixelGrayscale> &src, uint32_t *mask, uint8_t threshold, bool invert)
+{
+    return threshold_image(src, mask, threshold, invert, false);
+}
+
+int frameThreshold(FrameBuffer &fb, uint32_t *mask, bool invert)
+{
+    ImageStats stats;
+    ImageView<PixelGrayscale> frame(fb);
+    if (!frame.isValid() || frameStats(fb, stats) != 0) {
+        return -1;
+    }
+    int threshold = otsuThreshold(stats.histogram);
+    if (threshold < 0 || threshold_image(frame, mask, threshold, invert, true) != 0) {
+        return -1;
+    }
+    return threshold;
+}
+
+static int adaptive_threshold(const ImageView<PixelGrayscale> &src, const IntegralImage &ii, uint32_t *mask,
+        uint32_t radius, int32_t offset, bool invert, bool fast)
+{
+    if (!src.isValid() || mask == NULL || ii.sum == NULL || radius > THRESHOLD_RADIUS_MAX
+            || src.getWidth() != ii.width || src.getHeight() != ii.height) {
+        return -1;
+    }
+
+    int32_t width = src.getWidth();
+    int32_t height = src.getHeight();
+    int32_t r = radius;
+    uint32_t words = MASK_ROW_WORDS(width);
+    // Columns whose box isn't cut by the left and right borders
+    int32_t inner_x0 = (r < width) ? r : width;
+    int32_t inner_x1 = (width - r > inner_x0) ? width - r : inner_x0;
+
+    for (int32_t y = 0; y < height; y++) {
+        const uint8_t *p = src.row(y);
+        uint32_t *m = mask + y * words;
+        int32_t y0 = (y - r > 0) ? y - r : 0;
+        int32_t y1 = (y + r + 1 < height) ? y + r + 1 : height;
+        const uint32_t *top = ii.sum + y0 * (width + 1);
+        const uint32_t *bottom = ii.sum + y1 * (width + 1);
+        // The pixel is set if p > sum / area - offset, or the opposite if inverted
+        auto set = [&](int32_t x, uint32_t sum, int32_t area) {
+            return (uint32_t) (((int32_t) (p[x] + offset) * area > (int32_t) sum) != invert);
+        };
+
+        memset(m, 0, words * sizeof(uint32_t));
+        int32_t x = 0;
+        if (fast) {
+            for (; x < inner_x0; x++) {
+                int32_t x1 = (x + r + 1 < width) ? x + r + 1 : width;
+                uint32_t sum = bottom[x1] - bottom[0] - top[x1] + top[0];
+                m[x / 32] |= set(x, sum, x1 * (y1 - y0)) << (x % 32);
+            }
+            // The box has a constant area and needs no clamping
+            int32_t area = (2 * r + 1) * (y1 - y0);
+            for (; x < inner_x1; x++) {
+                uint32_t sum = bottom[x + r + 1] - bottom[x - r] - top[x + r + 1] + top[x - r];
+                m[x / 32] |= set(x, sum, area) << (x % 32);
+            }
+        }
+        for (; x < width; x++) {
+            int32_t x0 = (x - r > 0) ? x - r : 0;
+            int32_t x1 = (x + r + 1 < width) ? x + r + 1 : width;
+            uint32_t sum = integralSum(ii, x0, y0, x1 - x0, y1 - y0);
+            m[x / 32] |= set(x, sum, (x1 - x0) * (y1 - y0)) << (x % 32);
+        }
+    }
+    return 0;
+}
+
+int adaptiveThreshold(const ImageView<PixelGrayscale> &src, const IntegralImage &ii, uint32_t *mask,
+        uint32_t radius, int32_t offset, bool invert)
+{
+    return adaptive_threshold(src, ii, mask, radius, offset, invert, true);
+}
+
+int adaptiveThresholdReference(const ImageView<PixelGrayscale> &src, const IntegralImage &ii, uint32_t *mask,
+        uint32_t radius, int32_t offset, bool invert)
+{
+    return adaptive_threshold(src, ii, mask, radius, offset, invert, false);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Thresholding to bit-packed masks.
+ */
+
+/**
+ * @file threshold.h
+ * @brief Global (Otsu) and local mean adaptive thresholding of grayscale images to bit-packed masks.
+ *
+ * The masks take 1 bit per pixel (see mask.h), a QVGA mask takes 9600 bytes instead of 76800,
+ * and they can be combined 32 pixels at a time with maskAnd(), maskOr() and maskXor():
+ * @code {.cpp}
+ * static uint32_t mask[MASK_ROW_WORDS(320) * 240];
+ * ImageStats stats;
+ * if (cam.grabFrame(fb, 3000) == 0 && frameStats(fb, stats) == 0) {
+ *     ImageView<PixelGrayscale> frame(fb);
+ *     thresholdImage(frame, mask, otsuThreshold(stats.histogram));
+ * }
+ * @endcode
+ * The adaptive threshold compares every pixel with the mean of the box around it, from an
+ * integral image, so that uneven lighting doesn't change the result:
+ * @code {.cpp}
+ * integralImage(ii, frame);
+ * adaptiveThreshold(frame, ii, mask, 7, 5, true);
+ * @endcode
+ * With the DSP extension, 4 pixels are compared with the global threshold at once.
+ */
+
+#ifndef __THRESHOLD_H
+#define __THRESHOLD_H
+
+#include "imageview.h"
+#include "mask.h"
+#include "integral.h"
+
+/// Default radius of the box of the adaptive threshold
+#define THRESHOLD_RADIUS_DEFAULT    (7)
+/// Maximum radius of the box of the adaptive threshold, so that the box fits in INTEGRAL_BOX_MAX
+#define THRESHOLD_RADIUS_MAX        (127)
+/// Default offset of the adaptive threshold
+#define THRESHOLD_OFFSET_DEFAULT    (5)
+
+/**
+ * @brief Find the threshold that best separates the two classes of pixels of a histogram (Otsu's method).
+ *
+ * @param histogram The histogram, e.g. ImageStats::histogram
+ * @return int The threshold, the pixels above it are in the bright class, -1 if the histogram is empty
+ */
+int otsuThreshold(const uint32_t *histogram);
+
+/**
+ * @brief Threshold a grayscale image to a bit-packed mask.
+ *
+ * @param src The source image
+ * @param mask The mask, of the size of the source
+ * @param threshold The threshold, the pixels above it are set
+ * @param invert true to set the pixels at or below the threshold instead (default: false)
+ * @return int 0 on success, -1 on failure
+ */
+int thresholdImage(const ImageView<PixelGrayscale> &src, uint32_t *mask, uint8_t threshold, bool invert=false);
+
+/**
+ * @brief Threshold a grayscale image to a bit-packed mask, with the mean of the box around every
+ * pixel as the threshold. The box is cut at the borders of the image.
+ *
+ * @param src The source image
+ * @param ii The integral image of the source
+ * @param mask The mask, of the size of the source
+ * @param radius The radius of the box, up to THRESHOLD_RADIUS_MAX (default: THRESHOLD_RADIUS_DEFAULT)
+ * @param offset The pixels above the mean minus the offset are set (default: THRESHOLD_OFFSET_DEFAULT)
+ * @param invert true to set the pixels at or below the mean minus the offset instead,
+ * e.g. dark text on a bright background (default: false)
+ * @return int 0 on success, -1 on failure
+ */
+int adaptiveThreshold(const ImageView<PixelGrayscale> &src, const IntegralImage &ii, uint32_t *mask,
+        uint32_t radius=THRESHOLD_RADIUS_DEFAULT, int32_t offset=THRESHOLD_OFFSET_DEFAULT, bool invert=false);
+
+/**
+ * @brief Threshold the grayscale frame stored in a frame buffer with Otsu's threshold.
+ *
+ * @param fb Reference to the FrameBuffer object the frame was captured in
+ * @param mask The mask, of the size of the frame
+ * @param invert true to set the pixels at or below the threshold instead (default: false)
+ * @return int The threshold, -1 on failure
+ */
+int frameThreshold(FrameBuffer &fb, uint32_t *mask, bool invert=false);
+
+/*
+ * Portable scalar reference implementations.
+ * They are always available, so the results of the accelerated kernels can be checked against them.
+ */
+int thresholdImageReference(const ImageView<PixelGrayscale> &src, uint32_t *mask, uint8_t threshold, bool invert=false);
+int adaptiveThresholdReference(const ImageView<PixelGrayscale> &src, const IntegralImage &ii, uint32_t *mask,
+        uint32_t radius=THRESHOLD_RADIUS_DEFAULT, int32_t offset=THRESHOLD_OFFSET_DEFAULT, bool invert=false);
+
+#endif /* __THRESHOLD_H */
@@ -699,17 +699,64 @@ int OV7670::setFrameRate(int32_t framerate)
 
 int OV7670::setVerticalFlip(bool flip_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
 }
 
 int OV7670::setHorizontalMirror(bool mirror_enable)
 {
-  return -1;
+  return CAMERA_ENOTSUP;
+}
+
+int OV7670::setAutoExposure(bool enable)
+{
+    uint8_t com8;
+    int ret = regRead(getID(), COM8, &com8);
+    if (ret != 0) {
+        return ret;
+    }
+    com8 &= ~(COM8_AEC_EN | COM8_AGC_EN);
+    return regWrite(getID(), COM8, enable ? (com8 | COM8_AEC_EN | COM8_AGC_EN) : com8);
+}
+
+int OV7670::setExposure(uint32_t exposure)
+{
+    uint8_t com1;
+
+    // AEC[15:0] is split between AECHH[5:0], AECH and COM1[1:0]
+    exposure = (exposure > 0xFFFF) ? 0xFFFF : exposure;
+    int ret = regRead(getID(), COM1, &com1);
+    if (ret != 0) {
+        return ret;
+    }
+    ret |= regWrite(getID(), COM1, (com1 & ~0x03) | (exposure & 0x03));
+    ret |= regWrite(getID(), AECH, (exposure >> 2) & 0xFF);
+    ret |= regWrite(getID(), AECHH, (exposure >> 10) & 0x3F);
+    return ret;
+}
+
+int OV7670::setGain(uint32_t gain)
+{
+    // GAIN[7:4] each double the gain, GAIN[3:0] is a fine gain of 1 + n / 16.
+    // The extra gain bits in VREF[7:6] are not used, the maximum gain is 31x.
+    uint8_t value = 0;
+    gain = (gain < 16) ? 16 : gain;
+    for (uint8_t bit = 0x10; bit && gain >= 32; bit <<= 1) {
+        value |= bit;
+        gain >>= 1;
+    }
+    value |= (gain - 16 > 0x0F) ? 0x0F : gain - 16;
+    return regWrite(getID(), GAIN, value);
+}
+
+uint32_t OV7670::getMaxGain()
+{
+    // GAIN = 0xFF, 16x coarse gain times a fine gain of 31 / 16.
+    return 31 * 16;
 }
 
 int OV7670::setResolution(int32_t resolution)
 {
-    setResolutionWithZoom(resolution, resolution, 0, 0);
+    return setResolutionWithZoom(resolution, resolution, 0, 0);
 }
 
 int OV7670::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, uint32_t zoom_x, uint32_t zoom_y)
@@ -737,9 +784,14 @@ int OV7670::setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, u
             return -1;
     }
 
-    // Write pixel format registers
+    // Write resolution registers
     for (int i=0; regs[i][0] != 0xFF; i++) {
-        ret |= regWrite(getID(), regs[i][0], regs[i][1]);
+        uint8_t value = regs[i][1];
+        // Keep the byte order of the pixel format.
+        if (regs[i][0] == COM3 && byte_swap_state) {
+            value |= COM3_SWAP_MSB;
+        }
+        ret |= regWrite(getID(), regs[i][0], value);
     }
     return ret;
 }
@@ -751,9 +803,12 @@ int OV7670::setPixelFormat(int32_t pixformat)
 
     switch (pixformat) {
         case CAMERA_RGB565:
+        case CAMERA_RGB565_LE:
             regs = rgb565_regs;
             break;
         case CAMERA_GRAYSCALE:
+        case CAMERA_YUV422:
+            // Grayscale is extracted from the Y bytes by the DCMI.
             regs = yuv422_regs;
             break;
         default:
@@ -764,6 +819,17 @@ int OV7670::setPixelFormat(int32_t pixformat)
         ret |= regWrite(getID(), regs[i][0], regs[i][1]);
     }
 
+    // The sensor can swap the bytes of every pixel, so that RGB565 is
+    // stored in the native little-endian order without any CPU time.
+    uint8_t com3;
+    int err = regRead(getID(), COM3, &com3);
+    if (err != 0) {
+        return err;
+    }
+    byte_swap_state = (pixformat == CAMERA_RGB565_LE);
+    com3 &= ~COM3_SWAP_MSB;
+    ret |= regWrite(getID(), COM3, byte_swap_state ? (com3 | COM3_SWAP_MSB) : com3);
+
     return ret;
 }
 
@@ -781,6 +847,12 @@ int OV7670::regWrite(uint8_t dev_addr, uint16_t reg_addr, uint8_t reg_data, bool
 uint8_t OV7670::regRead(uint8_t dev_addr, uint16_t reg_addr, bool wide_addr)
 {
     uint8_t reg_data = 0;
+    regRead(dev_addr, reg_addr, &reg_data, wide_addr);
+    return reg_data;
+}
+
+int OV7670::regRead(uint8_t dev_addr, uint16_t reg_addr, uint8_t *reg_data, bool wide_addr)
+{
     uint8_t buf[2] = {(uint8_t) (reg_addr >> 8), (uint8_t) (reg_addr & 0xFF)};
     _i2c->beginTransmission(dev_addr);
     if (wide_addr) {
@@ -788,15 +860,18 @@ uint8_t OV7670::regRead(uint8_t dev_addr, uint16_t reg_addr, bool wide_addr)
     } else {
         _i2c->write(&buf[1], 1);
     }
-    _i2c->endTransmission(false);
+    // The error codes are the positive ones passed on from Wire, or -1 if no data was received
+    int ret = _i2c->endTransmission(false);
     _i2c->requestFrom(dev_addr, 1);
     if (_i2c->available()) {
-        reg_data = _i2c->read();
+        *reg_data = _i2c->read();
+    } else if (ret == 0) {
+        ret = -1;
     }
     while (_i2c->available()) {
         _i2c->read();
     }
-    return reg_data;
+    return ret;
 }
 
 void OV7670::debug(Stream &stream)
@@ -33,9 +33,11 @@ class OV7670: public ImageSensor {
         arduino::MbedI2C *_i2c;
         int regWrite(uint8_t dev_addr, uint16_t reg_addr, uint8_t reg_data, bool wide_addr = false);
         uint8_t regRead(uint8_t dev_addr, uint16_t reg_addr, bool wide_addr = false);
+        int regRead(uint8_t dev_addr, uint16_t reg_addr, uint8_t *reg_data, bool wide_addr = false);
         static const uint8_t qqvga_regs[][2];
         static const uint8_t qvga_regs[][2];
         static const uint8_t rgb565_regs[][2];
+        bool byte_swap_state = false;
 
    public:
         OV7670(arduino::MbedI2C &i2c = CameraWire);
@@ -48,13 +50,17 @@ class OV7670: public ImageSensor {
         int setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, uint32_t zoom_x, uint32_t zoom_y);
         int setResolution(int32_t resolution);
         int setPixelFormat(int32_t pixformat);
-        int enableMotionDetection(md_callback_t callback) { return 0; };
-        int disableMotionDetection() { return 0; };
-        int setMotionDetectionWindow(uint32_t x, uint32_t y, uint32_t w, uint32_t h) { return 0; };
-        int setMotionDetectionThreshold(uint32_t threshold) { return 0; };
+        int enableMotionDetection(md_callback_t callback) { return CAMERA_ENOTSUP; };
+        int disableMotionDetection() { return CAMERA_ENOTSUP; };
+        int setMotionDetectionWindow(uint32_t x, uint32_t y, uint32_t w, uint32_t h) { return CAMERA_ENOTSUP; };
+        int setMotionDetectionThreshold(uint32_t threshold) { return CAMERA_ENOTSUP; };
         int motionDetected() { return 0; };
         int setVerticalFlip(bool flip_enable);
         int setHorizontalMirror(bool mirror_enable);
+        int setAutoExposure(bool enable);
+        int setExposure(uint32_t exposure);
+        int setGain(uint32_t gain);
+        uint32_t getMaxGain();
         void debug(Stream &stream);
 };
 
@@ -18,6 +18,9 @@
  */
 #include "Arduino.h"
 #include "arducam_dvp.h"
+#include "ImageProcessing/bayer.h"
+#include "ImageProcessing/rotate.h"
+#include "ImageProcessing/motion.h"
 #include "Wire.h"
 #include "stm32h7xx_hal_dcmi.h"
 
@@ -124,22 +127,6 @@ static TIM_HandleTypeDef  htim  = {0};
 static DMA_HandleTypeDef  hdma  = {0};
 static DCMI_HandleTypeDef hdcmi = {0};
 
-/// Table to store the amount of bytes per pixel for each pixel format
-const uint32_t pixtab[CAMERA_PMAX] = {
-    1, // CAMERA_GRAYSCALE
-    1, // CAMERA_BAYER
-    2, // CAMERA_RGB565
-};
-
-const uint32_t restab[CAMERA_RMAX][2] = {
-    {160,   120 },
-    {320,   240 },
-    {320,   320 },
-    {640,   480 },
-    {800,   600 },
-    {1600,  1200},
-};
-
 extern "C" {
 
 void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim)
@@ -301,7 +288,7 @@ uint8_t camera_dcmi_config(bool bsm_skip)
     hdcmi.Init.CaptureRate      = DCMI_CR_ALL_FRAME;
     hdcmi.Init.ExtendedDataMode = DCMI_EXTEND_DATA_8B;
     hdcmi.Init.JPEGMode         = DCMI_JPEG_DISABLE;
-    hdcmi.Init.ByteSelectMode   = DCMI_BSM_ALL;     // bsm_skip ? DCMI_BSM_OTHER : DCMI_BSM_ALL
+    hdcmi.Init.ByteSelectMode   = bsm_skip ? DCMI_BSM_OTHER : DCMI_BSM_ALL;
     hdcmi.Init.ByteSelectStart  = DCMI_OEBS_ODD;    // Ignored unless BSM != ALL
     hdcmi.Init.LineSelectMode   = DCMI_LSM_ALL;     // Capture all received lines
     hdcmi.Init.LineSelectStart  = DCMI_OELS_ODD;    // Ignored, unless LSM != ALL
@@ -319,6 +306,18 @@ uint8_t camera_dcmi_config(bool bsm_skip)
     return 0;
 }
 
+void camera_dcmi_byte_select(bool bsm_skip)
+{
+    if (hdcmi.Instance == NULL) {
+        return;
+    }
+
+    // The byte select mode can only be changed while the DCMI is stopped.
+    hdcmi.Init.ByteSelectMode = bsm_skip ? DCMI_BSM_OTHER : DCMI_BSM_ALL;
+    hdcmi.Instance->CR &= ~(DCMI_CR_BSM | DCMI_CR_OEBS);
+    hdcmi.Instance->CR |= hdcmi.Init.ByteSelectMode | hdcmi.Init.ByteSelectStart;
+}
+
 void DCMI_IRQHandler(void)
 {
     HAL_DCMI_IRQHandler(&hdcmi);
@@ -329,6 +328,65 @@ void DMA2_Stream3_IRQHandler(void)
     HAL_DMA_IRQHandler(&hdma);
 }
 
+// State of a strided capture, the DMA is re-targeted to the next row at the end of every line.
+static struct {
+    uint32_t next_row;      // Address of the next row to be programmed
+    uint32_t stride;        // Distance in bytes between the start of two rows
+    uint32_t rows_left;     // Number of rows that still need to be programmed
+} dcmi_rows;
+
+static void dcmi_retarget_row(DMA_HandleTypeDef *hdma, HAL_DMA_MemoryTypeDef memory)
+{
+    // The DMA has switched to the other memory target, so this one is idle
+    // and can be pointed to the row after the one currently being written.
+    if (dcmi_rows.rows_left) {
+        HAL_DMAEx_ChangeMemory(hdma, dcmi_rows.next_row, memory);
+        dcmi_rows.next_row += dcmi_rows.stride;
+        dcmi_rows.rows_left--;
+    }
+}
+
+static void dcmi_m0_row_cplt(DMA_HandleTypeDef *hdma)
+{
+    dcmi_retarget_row(hdma, MEMORY0);
+}
+
+static void dcmi_m1_row_cplt(DMA_HandleTypeDef *hdma)
+{
+    dcmi_retarget_row(hdma, MEMORY1);
+}
+
+int camera_dcmi_start_strided(uint8_t *framebuffer, uint32_t linesize, uint32_t stride, uint32_t lines)
+{
+    // The first two rows are loaded in the double-buffer memory targets,
+    // the remaining ones are programmed from the transfer complete callbacks.
+    dcmi_rows.next_row  = (uint32_t) framebuffer + 2 * stride;
+    dcmi_rows.stride    = stride;
+    dcmi_rows.rows_left = lines - 2;
+
+    hdma.XferCpltCallback     = dcmi_m0_row_cplt;
+    hdma.XferM1CpltCallback   = dcmi_m1_row_cplt;
+    hdma.XferHalfCpltCallback = NULL;
+    hdma.XferErrorCallback    = NULL;
+    hdma.XferAbortCallback    = NULL;
+
+    // Enable the DCMI and configure the snapshot mode.
+    __HAL_DCMI_ENABLE(&hdcmi);
+    hdcmi.Instance->CR &= ~(DCMI_CR_CM);
+    hdcmi.Instance->CR |= DCMI_MODE_SNAPSHOT;
+
+    if (HAL_DMAEx_MultiBufferStart_IT(&hdma, (uint32_t) &hdcmi.Instance->DR, (uint32_t) framebuffer,
+                (uint32_t) framebuffer + stride, linesize / 4) != HAL_OK) {
+        __HAL_DCMI_DISABLE(&hdcmi);
+        return -1;
+    }
+
+    // Enable Capture
+    hdcmi.State = HAL_DCMI_STATE_BUSY;
+    hdcmi.Instance->CR |= DCMI_CR_CAPTURE;
+    return 0;
+}
+
 inline void pixelDataAssemble(uint8_t *framebuffer,uint32_t framesize)
 {
     for (uint32_t pidx = 0, idx = 0; idx < framesize; idx++)
@@ -347,16 +405,24 @@ inline void pixelDataAssemble(uint8_t *framebuffer,uint32_t framesize)
 
 } // extern "C"
 
-FrameBuffer::FrameBuffer(int32_t x, int32_t y, int32_t bpp) : 
-    _fb_size(x*y*bpp),
+FrameBuffer::FrameBuffer(int32_t x, int32_t y, int32_t bpp, uint32_t stride) : 
+    _fb_size(stride ? y*stride : x*y*bpp),
+    _stride(stride),
+    _width(0),
+    _height(0),
+    _pixformat(-1),
     _isAllocated(true)
 {
-    uint8_t *buffer = (uint8_t *)malloc(x*y*bpp);
+    uint8_t *buffer = (uint8_t *)malloc(_fb_size+32);
     _fb = (uint8_t *)ALIGN_PTR((uintptr_t)buffer, 32);
 }
 
 FrameBuffer::FrameBuffer(int32_t address) : 
     _fb_size(0),
+    _stride(0),
+    _width(0),
+    _height(0),
+    _pixformat(-1),
     _isAllocated(true)
 {
     _fb = (uint8_t *)ALIGN_PTR((uintptr_t)address, 32);
@@ -364,6 +430,10 @@ FrameBuffer::FrameBuffer(int32_t address) :
 
 FrameBuffer::FrameBuffer() : 
     _fb_size(0),
+    _stride(0),
+    _width(0),
+    _height(0),
+    _pixformat(-1),
     _isAllocated(false)
 {
 }
@@ -384,6 +454,38 @@ void FrameBuffer::setBuffer(uint8_t *buffer)
     _fb = buffer;
 }
 
+uint32_t FrameBuffer::getStride()
+{
+    return _stride;
+}
+
+void FrameBuffer::setStride(uint32_t stride)
+{
+    _stride = stride;
+}
+
+void FrameBuffer::setFrameFormat(uint32_t width, uint32_t height, int32_t pixformat)
+{
+    _width = width;
+    _height = height;
+    _pixformat = pixformat;
+}
+
+uint32_t FrameBuffer::getWidth()
+{
+    return _width;
+}
+
+uint32_t FrameBuffer::getHeight()
+{
+    return _height;
+}
+
+int32_t FrameBuffer::getPixelFormat()
+{
+    return _pixformat;
+}
+
 bool FrameBuffer::hasFixedSize()
 {
     if (_fb_size) {
@@ -400,10 +502,22 @@ bool FrameBuffer::isAllocated()
 Camera::Camera(ImageSensor &sensor) : 
     pixformat(-1),
     resolution(-1),
+    sensor_resolution(-1),
     framerate(-1),
     sensor(&sensor),
-    _debug(NULL)
+    _debug(NULL),
+    soft_vflip(false),
+    soft_hmirror(false),
+    soft_md(NULL),
+    soft_md_callback(NULL),
+    soft_md_enabled(false),
+    soft_md_detected(false)
+{
+}
+
+Camera::~Camera()
 {
+    free(this->soft_md);
 }
 
 int Camera::reset()
@@ -439,7 +553,7 @@ ScanResults<uint8_t> Camera::i2cScan()
 
 bool Camera::begin(int32_t resolution, int32_t pixformat, int32_t framerate)
 {  
-    if (resolution >= CAMERA_RMAX || pixformat >= CAMERA_PMAX) {
+    if (!resolutionIsValid(resolution) || pixformat >= CAMERA_PMAX) {
         return false;
     }
 
@@ -471,10 +585,11 @@ bool Camera::begin(int32_t resolution, int32_t pixformat, int32_t framerate)
         return false;
     }
 
-    // If the pixel format is Grayscale and sensor is Not monochrome, the
-    // actual pixel format will be YUV (i.e 2 bytes per pixel) and the DCMI
-    // needs to be configured to skip every other byte to extract the Y channel.
-    bool gs_from_yuv = (pixformat == CAMERA_GRAYSCALE) && !this->sensor->getMono();
+    // If the sensor sends twice the bits per pixel of the requested format on the bus,
+    // e.g. YUV (i.e 2 bytes per pixel) for Grayscale on a sensor that is Not monochrome,
+    // the DCMI needs to be configured to skip every other byte to extract the Y channel.
+    int32_t busformat = this->sensor->getBusFormat(pixformat);
+    bool gs_from_yuv = (pixtab[busformat].bpp == 2 * pixtab[pixformat].bpp);
     if (camera_dcmi_config(gs_from_yuv) != 0) {
         return false;
     }
@@ -521,11 +636,60 @@ int Camera::setFrameRate(int32_t framerate)
 
 int Camera::setResolution(int32_t resolution)
 {
-    if (this->sensor == NULL || resolution >= CAMERA_RMAX
+    if (this->sensor == NULL || !resolutionIsValid(resolution)
             || pixformat >= CAMERA_PMAX || pixformat == -1) {
         return -1;
     }
 
+    uint32_t width = resolutionWidth(resolution);
+    uint32_t height = resolutionHeight(resolution);
+
+    // The DMA transfers whole 32-bit words.
+    if (resolutionIsCustom(resolution) && (width & 0x3)) {
+        return -1;
+    }
+
+    // Bayer frames are converted to grayscale 2x2 blocks at a time.
+    int32_t busformat = this->sensor->getBusFormat(pixformat);
+    if (pixtab[busformat].bayer_phase != CAMERA_PHASE_NONE && ((width | height) & 0x1)) {
+        return -1;
+    }
+
+    // Let the sensor output the resolution if it supports it, otherwise use the
+    // smallest resolution that contains it and crop the frame out of its center.
+    int32_t sensor_resolution = -1;
+    if (this->sensor->setResolution(resolution) == 0) {
+        sensor_resolution = resolution;
+    } else if (resolutionIsCustom(resolution)) {
+        for (int32_t r = 0; r < CAMERA_RMAX; r++) {
+            if (resolutionIsValid(r) && restab[r][0] >= width && restab[r][1] >= height
+                    && this->sensor->setResolution(r) == 0) {
+                sensor_resolution = r;
+                break;
+            }
+        }
+    }
+
+    if (sensor_resolution == -1) {
+        return -1;
+    }
+
+    this->resolution = resolution;
+    this->sensor_resolution = sensor_resolution;
+    configureCrop();
+    return 0;
+}
+
+void Camera::configureCrop()
+{
+    uint32_t width = resolutionWidth(this->resolution);
+    uint32_t height = resolutionHeight(this->resolution);
+
+    // Keep the offsets on a pixel pair, so that YUV422 frames start with a Y0 U Y1 V block
+    // and Bayer frames with the color filter phase of the sensor.
+    uint32_t x = ((resolutionWidth(this->sensor_resolution) - width) / 2) & ~1;
+    uint32_t y = ((resolutionHeight(this->sensor_resolution) - height) / 2) & ~1;
+
     /*
      * @param  X0    DCMI window X offset
      * @param  Y0    DCMI window Y offset
@@ -533,20 +697,12 @@ int Camera::setResolution(int32_t resolution)
      * @param  YSize DCMI Line number
      */
     HAL_DCMI_EnableCROP(&hdcmi);
-    uint32_t bpl = restab[resolution][0] * this->sensor->getPixelReadingCycle();
-    if (pixformat == CAMERA_RGB565 ||
-       (pixformat == CAMERA_GRAYSCALE && !this->sensor->getMono())) {
-        // If the pixel format is Grayscale and sensor is Not monochrome,
-        // the actual pixel format will be YUV (i.e 2 bytes per pixel).
-        bpl *= 2;
-    }
-    HAL_DCMI_ConfigCROP(&hdcmi, 0, 0, bpl - 1, restab[resolution][1] - 1);
-
-    if (this->sensor->setResolution(resolution) == 0) {
-        this->resolution = resolution;
-        return 0;
-    }
-    return -1;
+    // The line size is determined by the format on the bus, e.g. if the pixel format
+    // is Grayscale and sensor is Not monochrome, it will be YUV (i.e 2 bytes per pixel).
+    int32_t busformat = this->sensor->getBusFormat(this->pixformat);
+    uint32_t bpl = pixelFormatLineBytes(busformat, width) * this->sensor->getPixelReadingCycle();
+    uint32_t x0 = pixelFormatLineBytes(busformat, x) * this->sensor->getPixelReadingCycle();
+    HAL_DCMI_ConfigCROP(&hdcmi, x0, y, bpl - 1, height - 1);
 }
 
 int Camera::setPixelFormat(int32_t pixformat)
@@ -555,8 +711,30 @@ int Camera::setPixelFormat(int32_t pixformat)
         return -1;
     }
 
+    // Keep flipping the frames in software if the sensor can't.
+    if ((this->soft_vflip || this->soft_hmirror) && !flipFrameSupported(pixformat)) {
+        return -1;
+    }
+    // Keep detecting motion in software if the sensor can't.
+    if (this->soft_md_enabled && !frameMotionSupported(pixformat)) {
+        return -1;
+    }
+
+    // Bayer frames are converted to grayscale 2x2 blocks at a time.
+    int32_t busformat = this->sensor->getBusFormat(pixformat);
+    if (this->resolution != -1 && pixtab[busformat].bayer_phase != CAMERA_PHASE_NONE
+            && (resolutionHeight(this->resolution) & 0x1)) {
+        return -1;
+    }
+
     if (this->sensor->setPixelFormat(pixformat) == 0) {
+        // Only keep every other byte if the bus carries twice the bits per pixel.
+        camera_dcmi_byte_select(pixtab[busformat].bpp == 2 * pixtab[pixformat].bpp);
         this->pixformat = pixformat;
+        // The bytes of the crop depend on the format on the bus.
+        if (this->resolution != -1) {
+            configureCrop();
+        }
         return 0;
     }
     return -1;
@@ -580,6 +758,42 @@ int Camera::setTestPattern(bool enable, bool walking)
     return this->sensor->setTestPattern(enable, walking);
 }
 
+int Camera::setAutoExposure(bool enable)
+{
+    if (this->sensor == NULL) {
+        return -1;
+    }
+
+    return this->sensor->setAutoExposure(enable);
+}
+
+int Camera::setExposure(uint32_t exposure)
+{
+    if (this->sensor == NULL) {
+        return -1;
+    }
+
+    return this->sensor->setExposure(exposure);
+}
+
+int Camera::setGain(uint32_t gain)
+{
+    if (this->sensor == NULL) {
+        return -1;
+    }
+
+    return this->sensor->setGain(gain);
+}
+
+uint32_t Camera::getMaxGain()
+{
+    if (this->sensor == NULL) {
+        return 0;
+    }
+
+    return this->sensor->getMaxGain();
+}
+
 int Camera::frameSize()
 {
     if (this->sensor == NULL
@@ -588,8 +802,8 @@ int Camera::frameSize()
         return -1;
     }
 
-    return restab[this->resolution][0] * restab[this->resolution][1] \
-            * pixtab[this->pixformat];
+    return pixelFormatImageBytes(this->pixformat,
+            resolutionWidth(this->resolution), resolutionHeight(this->resolution));
 }
 
 int Camera::grabFrame(FrameBuffer &fb, uint32_t timeout)
@@ -601,6 +815,29 @@ int Camera::grabFrame(FrameBuffer &fb, uint32_t timeout)
     }
 
     uint32_t framesize = frameSize() * this->sensor->getPixelReadingCycle();
+    uint32_t lines = resolutionHeight(this->resolution);
+    uint32_t linesize = framesize / lines;
+
+    // Rows are only laid out with a stride if it differs from the line size,
+    // otherwise the frame is captured with a single contiguous transfer.
+    uint32_t stride = fb.getStride();
+    bool strided = (stride != 0) && (stride != linesize) && (lines > 1);
+    if (strided) {
+        if (stride < linesize) {
+            if (_debug) {
+                _debug->println("The stride is smaller than a line!");
+            }
+            return -1;
+        }
+        if (this->sensor->getPixelReadingCycle() != 1) {
+            if (_debug) {
+                _debug->println("Strided capture is not supported by this sensor");
+            }
+            return -1;
+        }
+        // The last row doesn't need any padding.
+        framesize = (lines - 1) * stride + linesize;
+    }
 
     if (fb.isAllocated()) {
         //A buffer has already been allocated
@@ -626,19 +863,44 @@ int Camera::grabFrame(FrameBuffer &fb, uint32_t timeout)
 
     uint8_t *framebuffer = fb.getBuffer();
 
-    // Ensure FB is aligned to 32 bytes cache lines.
-    if ((uint32_t) framebuffer & 0x1F) {
-        if (_debug) {
-            _debug->println("Framebuffer not aligned to 32 bytes cache lines");
+    if (strided) {
+        // Every row is written by the DMA in 32-bit words.
+        if (((uint32_t) framebuffer & 0x3) || (stride & 0x3)) {
+            if (_debug) {
+                _debug->println("Framebuffer or stride not aligned to 4 bytes");
+            }
+            return -1;
         }
-        return -1;
-    }
 
-    // Start the Camera Snapshot Capture.
-    if (HAL_DCMI_Start_DMA(&hdcmi, DCMI_MODE_SNAPSHOT,
-                (uint32_t) framebuffer, framesize / 4) != HAL_OK) {
-        if (_debug) {
-            _debug->println("HAL_DCMI_Start_DMA FAILED!");
+        #if defined(__CORTEX_M7)  // only clean buffer for Cortex M7
+        // The rows may share cache lines with pixels outside of the frame,
+        // write them back so they are not lost when invalidating the buffer.
+        SCB_CleanInvalidateDCache_by_Addr((uint32_t*) framebuffer, framesize);
+        #endif
+
+        // Start the Camera Snapshot Capture, one DMA transfer per line.
+        if (camera_dcmi_start_strided(framebuffer, linesize, stride, lines) != 0) {
+            if (_debug) {
+                _debug->println("HAL_DMAEx_MultiBufferStart_IT FAILED!");
+            }
+            return -1;
+        }
+    } else {
+        // Ensure FB is aligned to 32 bytes cache lines.
+        if ((uint32_t) framebuffer & 0x1F) {
+            if (_debug) {
+                _debug->println("Framebuffer not aligned to 32 bytes cache lines");
+            }
+            return -1;
+        }
+
+        // Start the Camera Snapshot Capture.
+        if (HAL_DCMI_Start_DMA(&hdcmi, DCMI_MODE_SNAPSHOT,
+                    (uint32_t) framebuffer, framesize / 4) != HAL_OK) {
+            if (_debug) {
+                _debug->println("HAL_DCMI_Start_DMA FAILED!");
+            }
+            return -1;
         }
     }
 
@@ -658,46 +920,216 @@ int Camera::grabFrame(FrameBuffer &fb, uint32_t timeout)
 
     #if defined(__CORTEX_M7)  // only invalidate buffer for Cortex M7
     // Invalidate buffer after DMA transfer.
-    SCB_InvalidateDCache_by_Addr((uint32_t*) framebuffer, framesize);
+    if (strided) {
+        // Only invalidate the rows, so that the pixels written by the CPU in between during the capture
+        // are kept, except those that share a cache line with a row.
+        for (uint32_t i = 0; i < lines; i++) {
+            uint32_t start = ((uint32_t) framebuffer + i * stride) & ~0x1F;
+            uint32_t end = ((uint32_t) framebuffer + i * stride + linesize + 0x1F) & ~0x1F;
+            SCB_InvalidateDCache_by_Addr((uint32_t*) start, end - start);
+        }
+    } else {
+        SCB_InvalidateDCache_by_Addr((uint32_t*) framebuffer, framesize);
+    }
     #endif
 
     if (this->sensor->getPixelReadingCycle() == 2)
         pixelDataAssemble(framebuffer, framesize);
 
+    // Sensors without a grayscale output send raw Bayer frames, 1 byte per pixel like grayscale,
+    // convert them to luma in place.
+    int32_t busformat = this->sensor->getBusFormat(this->pixformat);
+    if (this->pixformat == CAMERA_GRAYSCALE && pixtab[busformat].bayer_phase != CAMERA_PHASE_NONE) {
+        uint32_t width = resolutionWidth(this->resolution);
+        ImageView<PixelBayer> raw(framebuffer, width, lines, strided ? stride : 0);
+        ImageView<PixelGrayscale> gray(framebuffer, width, lines, strided ? stride : 0);
+        if (bayerToLuma(raw, gray, busformat) != 0) {
+            if (_debug) {
+                _debug->println("The Bayer frame can't be converted to grayscale");
+            }
+            return -1;
+        }
+    }
+
+    fb.setFrameFormat(resolutionWidth(this->resolution), lines, this->pixformat);
+
+    // Flip the frame in place if the sensor can't.
+    if ((this->soft_vflip || this->soft_hmirror)
+            && flipFrame(fb, this->soft_vflip, this->soft_hmirror) != 0) {
+        if (_debug) {
+            _debug->println("The pixel format can't be flipped in software");
+        }
+        return -1;
+    }
+
+    // Detect motion if the sensor can't.
+    if (this->soft_md_enabled) {
+        int motion = frameMotion(fb, *this->soft_md);
+        if (motion < 0) {
+            if (_debug) {
+                _debug->println("Motion can't be detected in software in this pixel format");
+            }
+            return -1;
+        }
+        if (motion == 1) {
+            this->soft_md_detected = true;
+            if (this->soft_md_callback) {
+                this->soft_md_callback();
+            }
+        }
+    }
     return 0;
 }
 
+int Camera::setVerticalFlip(bool flip_enable)
+{
+    if (this->sensor == NULL) {
+        return -1;
+    }
+
+    int ret = this->sensor->setVerticalFlip(flip_enable);
+    if (ret != CAMERA_ENOTSUP) {
+        if (ret != 0) {
+            return -1;
+        }
+        this->soft_vflip = false;
+        return 0;
+    }
+    // The sensor can't flip the image, grabFrame() will do it.
+    if (flip_enable && !flipFrameSupported(this->pixformat)) {
+        return -1;
+    }
+    this->soft_vflip = flip_enable;
+    return 0;
+}
+
+int Camera::setHorizontalMirror(bool mirror_enable)
+{
+    if (this->sensor == NULL) {
+        return -1;
+    }
+
+    int ret = this->sensor->setHorizontalMirror(mirror_enable);
+    if (ret != CAMERA_ENOTSUP) {
+        if (ret != 0) {
+            return -1;
+        }
+        this->soft_hmirror = false;
+        return 0;
+    }
+    // The sensor can't mirror the image, grabFrame() will do it.
+    if (mirror_enable && !flipFrameSupported(this->pixformat)) {
+        return -1;
+    }
+    this->soft_hmirror = mirror_enable;
+    return 0;
+}
+
+MotionDetector *Camera::softMotionDetector()
+{
+    if (this->soft_md == NULL) {
+        this->soft_md = (MotionDetector *) malloc(sizeof(MotionDetector));
+        if (this->soft_md == NULL || motionBegin(*this->soft_md) != 0) {
+            free(this->soft_md);
+            this->soft_md = NULL;
+        }
+    }
+    return this->soft_md;
+}
+
 int Camera::setMotionDetectionThreshold(uint32_t threshold)
 {
-  return this->sensor->setMotionDetectionThreshold(threshold);
+  if (this->soft_md == NULL) {
+      int ret = this->sensor->setMotionDetectionThreshold(threshold);
+      if (ret != CAMERA_ENOTSUP) {
+          return ret;
+      }
+  }
+  // The sensor can't detect motion, grabFrame() will do it.
+  MotionDetector *md = softMotionDetector();
+  return (md == NULL) ? -1 : motionSetThreshold(*md, threshold);
 }
 
 int Camera::setMotionDetectionWindow(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
 {
   uint32_t width, height;
 
-  width = restab[this->resolution][0];
-  height= restab[this->resolution][1];
+  width = resolutionWidth(this->resolution);
+  height= resolutionHeight(this->resolution);
 
   if (((x+w) > width) || ((y+h) > height)) {
       return -1;
   }
-  return this->sensor->setMotionDetectionWindow(x, y, x+w, y+h);
+  if (this->soft_md == NULL) {
+      int ret = this->sensor->setMotionDetectionWindow(x, y, x+w, y+h);
+      if (ret != CAMERA_ENOTSUP) {
+          return ret;
+      }
+  }
+  // The sensor can't detect motion, grabFrame() will do it.
+  MotionDetector *md = softMotionDetector();
+  return (md == NULL) ? -1 : motionSetWindow(*md, x, y, w, h);
+}
+
+uint32_t Camera::getResolutionWidth()
+{
+  if (this->resolution == -1) {
+      return 0;
+  }
+  return resolutionWidth(this->resolution);
+}
+
+uint32_t Camera::getResolutionHeight()
+{
+  if (this->resolution == -1) {
+      return 0;
+  }
+  return resolutionHeight(this->resolution);
 }
 
 int Camera::enableMotionDetection(md_callback_t callback)
 {
-  return this->sensor->enableMotionDetection(callback);
+  if (this->soft_md == NULL) {
+      int ret = this->sensor->enableMotionDetection(callback);
+      if (ret != CAMERA_ENOTSUP) {
+          return ret;
+      }
+  }
+  // The sensor can't detect motion, grabFrame() will do it if it can analyse the frames.
+  if (!frameMotionSupported(this->pixformat)) {
+      return -1;
+  }
+  MotionDetector *md = softMotionDetector();
+  if (md == NULL) {
+      return -1;
+  }
+  // Start from a new background.
+  motionReset(*md);
+  this->soft_md_callback = callback;
+  this->soft_md_detected = false;
+  this->soft_md_enabled = true;
+  return 0;
 }
 
 int Camera::disableMotionDetection()
 {
-  return this->sensor->disableMotionDetection();
+  if (this->soft_md == NULL) {
+      return this->sensor->disableMotionDetection();
+  }
+  this->soft_md_enabled = false;
+  this->soft_md_callback = NULL;
+  this->soft_md_detected = false;
+  return 0;
 }
 
 int Camera::motionDetected()
 {
-  return this->sensor->motionDetected();
+  if (this->soft_md == NULL) {
+      return this->sensor->motionDetected();
+  }
+  int ret = this->soft_md_detected ? 1 : 0;
+  this->soft_md_detected = false;
+  return ret;
 }
 
 void Camera::debug(Stream &stream)
@@ -34,18 +34,102 @@
 #define HM0360_I2C_ADDR         (0x24)
 #define GC2145_I2C_ADDR         (0x3C)
 
+/// Returned by the sensor drivers for the features the sensor doesn't have
+#define CAMERA_ENOTSUP          (-2)
+
 /** 
  * Camera pixel format enumeration
- * The different formats use different number of bits per pixel:
- * Grayscale (8-bit), Bayer (8-bit), RGB565 (16-bit)
+ * The layout of every format is described by its entry in the pixel format table (pixtab).
+ * Grayscale (8-bit), Bayer (8-bit), RGB565 (16-bit), YUV422 (16-bit), RGB888 (24-bit),
+ * ARGB8888 (32-bit), signed 16-bit and packed grayscale formats with 4, 2 and 1 bits per pixel.
  **/
 enum {
     CAMERA_GRAYSCALE    = 0,
-    CAMERA_BAYER        = 1,
-    CAMERA_RGB565       = 2,
+    CAMERA_BAYER        = 1,    /* Raw Bayer, BGGR phase */
+    CAMERA_RGB565       = 2,    /* Big-endian, as sent by the sensors */
+    CAMERA_YUV422       = 3,    /* Y0 U Y1 V (YUYV) */
+    CAMERA_RGB888       = 4,    /* R, G, B bytes */
+    CAMERA_RGB565_LE    = 5,    /* Little-endian, native CPU order, sent by the OV767X */
+    CAMERA_BAYER_GBRG   = 6,    /* Raw Bayer, GBRG phase */
+    CAMERA_BAYER_GRBG   = 7,    /* Raw Bayer, GRBG phase */
+    CAMERA_BAYER_RGGB   = 8,    /* Raw Bayer, RGGB phase */
+    CAMERA_GRAYSCALE4   = 9,    /* 2 pixels per byte, first pixel in the high nibble */
+    CAMERA_GRAYSCALE2   = 10,   /* 4 pixels per byte, first pixel in the high bits */
+    CAMERA_BINARY       = 11,   /* 8 pixels per byte, first pixel in the most significant bit */
+    CAMERA_ARGB8888     = 12,   /* 32-bit native words, 0xAARRGGBB */
+    CAMERA_INT16        = 13,   /* Signed 16-bit native words, e.g. image gradients */
     CAMERA_PMAX                 /* Sentinel value */
 };
 
+/// Byte order of the pixels that are wider than a byte
+enum {
+    CAMERA_BYTE_ORDER_BE = 0,   /* Most significant byte first */
+    CAMERA_BYTE_ORDER_LE = 1,   /* Least significant byte first */
+};
+
+/// Bayer color filter phase, i.e. the colors of the top-left 2x2 block
+enum {
+    CAMERA_PHASE_NONE   = 0,    /* Not a Bayer format */
+    CAMERA_PHASE_BGGR   = 1,
+    CAMERA_PHASE_GBRG   = 2,
+    CAMERA_PHASE_GRBG   = 3,
+    CAMERA_PHASE_RGGB   = 4,
+};
+
+/**
+ * @struct PixelFormatDescriptor
+ * @brief Describes how the pixels of a pixel format are laid out in memory.
+ */
+struct PixelFormatDescriptor {
+    uint8_t bpp;            /// Bits per pixel
+    uint8_t planes;         /// Number of planes
+    uint8_t byte_order;     /// Byte order of the pixels that are wider than a byte
+    uint8_t bayer_phase;    /// Bayer color filter phase, CAMERA_PHASE_NONE for non-Bayer formats
+};
+
+/// Pixel format table, indexed by the pixel format enum
+constexpr PixelFormatDescriptor pixtab[CAMERA_PMAX] = {
+    { 8,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_GRAYSCALE
+    { 8,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_BGGR },     // CAMERA_BAYER
+    { 16, 1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_RGB565
+    { 16, 1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_YUV422
+    { 24, 1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_RGB888
+    { 16, 1, CAMERA_BYTE_ORDER_LE, CAMERA_PHASE_NONE },     // CAMERA_RGB565_LE
+    { 8,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_GBRG },     // CAMERA_BAYER_GBRG
+    { 8,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_GRBG },     // CAMERA_BAYER_GRBG
+    { 8,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_RGGB },     // CAMERA_BAYER_RGGB
+    { 4,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_GRAYSCALE4
+    { 2,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_GRAYSCALE2
+    { 1,  1, CAMERA_BYTE_ORDER_BE, CAMERA_PHASE_NONE },     // CAMERA_BINARY
+    { 32, 1, CAMERA_BYTE_ORDER_LE, CAMERA_PHASE_NONE },     // CAMERA_ARGB8888
+    { 16, 1, CAMERA_BYTE_ORDER_LE, CAMERA_PHASE_NONE },     // CAMERA_INT16
+};
+
+/**
+ * @brief Get the number of bytes of a line of pixels.
+ *
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @param width Width of the line in pixels
+ * @return The size of the line in bytes, partially used bytes included
+ */
+constexpr uint32_t pixelFormatLineBytes(int32_t pixformat, uint32_t width)
+{
+    return (width * pixtab[pixformat].bpp * pixtab[pixformat].planes + 7) / 8;
+}
+
+/**
+ * @brief Get the number of bytes of an image.
+ *
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @return The size of the image in bytes
+ */
+constexpr uint32_t pixelFormatImageBytes(int32_t pixformat, uint32_t width, uint32_t height)
+{
+    return pixelFormatLineBytes(pixformat, width) * height;
+}
+
 /// Camera resolution enumeration
 enum {
     CAMERA_R160x120     = 0,   /* QQVGA Resolution   */
@@ -54,12 +138,85 @@ enum {
     CAMERA_R640x480     = 3,   /* VGA                */
     CAMERA_R800x600     = 5,   /* SVGA               */
     CAMERA_R1600x1200   = 6,   /* UXGA               */
-    CAMERA_RMAX                /* Sentinel value */
+    CAMERA_RMAX,               /* Sentinel value */
+    CAMERA_RCUSTOM      = 0x40000000,   /* Flag of the custom resolutions, see cameraResolution() */
+};
+
+// Resolution table, indexed by the resolution enum
+constexpr uint32_t restab[CAMERA_RMAX][2] = {
+    {160,   120 },
+    {320,   240 },
+    {320,   320 },
+    {640,   480 },
+    {0,     0   },  // Unused
+    {800,   600 },
+    {1600,  1200},
 };
 
-// Resolution table
-extern const uint32_t restab[CAMERA_RMAX][2];
+/**
+ * @brief Get the resolution value of an arbitrary width and height.
+ * This can be used wherever a resolution from the resolution enum is expected, e.g. to capture
+ * frames with the input size of a model instead of resizing every frame:
+ * @code {.cpp}
+ * cam.begin(cameraResolution(96, 96), CAMERA_GRAYSCALE, 30);
+ * @endcode
+ * @note Not all sensors support all sizes. If the sensor can't output the size itself,
+ * the frame is cropped out of the center of the smallest resolution that contains it.
+ * @param width Width in pixels, up to 32767
+ * @param height Height in pixels, up to 32767
+ * @return int32_t The resolution value
+ */
+constexpr int32_t cameraResolution(uint32_t width, uint32_t height)
+{
+    return CAMERA_RCUSTOM | ((width & 0x7FFF) << 15) | (height & 0x7FFF);
+}
+
+/**
+ * @brief Check if a resolution is a custom resolution created by cameraResolution().
+ *
+ * @param resolution The resolution, as defined in the resolution enum or returned by cameraResolution()
+ * @return true If the resolution is a custom resolution
+ * @return false Otherwise
+ */
+constexpr bool resolutionIsCustom(int32_t resolution)
+{
+    return (resolution >= 0) && (resolution & CAMERA_RCUSTOM) != 0;
+}
+
+/**
+ * @brief Get the width of a resolution.
+ *
+ * @param resolution The resolution, as defined in the resolution enum or returned by cameraResolution()
+ * @return uint32_t The width in pixels
+ */
+constexpr uint32_t resolutionWidth(int32_t resolution)
+{
+    return resolutionIsCustom(resolution) ? ((resolution >> 15) & 0x7FFF) : restab[resolution][0];
+}
+
+/**
+ * @brief Get the height of a resolution.
+ *
+ * @param resolution The resolution, as defined in the resolution enum or returned by cameraResolution()
+ * @return uint32_t The height in pixels
+ */
+constexpr uint32_t resolutionHeight(int32_t resolution)
+{
+    return resolutionIsCustom(resolution) ? (resolution & 0x7FFF) : restab[resolution][1];
+}
 
+/**
+ * @brief Check if a value is a valid resolution.
+ *
+ * @param resolution The resolution, as defined in the resolution enum or returned by cameraResolution()
+ * @return true If the resolution has a non-zero width and height
+ * @return false Otherwise
+ */
+constexpr bool resolutionIsValid(int32_t resolution)
+{
+    return (resolutionIsCustom(resolution) || (resolution >= 0 && resolution < CAMERA_RMAX))
+            && resolutionWidth(resolution) && resolutionHeight(resolution);
+}
 
 /**
  * @class FrameBuffer
@@ -69,6 +226,10 @@ class FrameBuffer {
     private:
         int32_t _fb_size;       /// Frame buffer size in bytes
         uint8_t *_fb;           /// Pointer to the frame buffer
+        uint32_t _stride;       /// Distance in bytes between the start of two rows (0 = tightly packed)
+        uint32_t _width;        /// Width in pixels of the last frame stored in the buffer
+        uint32_t _height;       /// Height in pixels of the last frame stored in the buffer
+        int32_t _pixformat;     /// Pixel format of the last frame stored in the buffer
         bool _isAllocated;      /// Flag indicating if the buffer is allocated on the heap
 
     public:
@@ -77,9 +238,11 @@ class FrameBuffer {
          *
          * @param x Width of the frame buffer
          * @param y Height of the frame buffer
-         * @param bpp Bits per pixel
+         * @param bpp Bytes per pixel
+         * @param stride Distance in bytes between the start of two rows (default: 0, tightly packed).
+         * Rows can be padded e.g. to a multiple of 32 bytes so that every row starts on a cache line.
          */
-        FrameBuffer(int32_t x, int32_t y, int32_t bpp);
+        FrameBuffer(int32_t x, int32_t y, int32_t bpp, uint32_t stride=0);
 
         /**
          * @brief Construct a new FrameBuffer object with a given address.
@@ -132,6 +295,63 @@ class FrameBuffer {
          */
         void setBuffer(uint8_t *buffer);
 
+        /**
+         * @brief Get the row stride of the frame buffer.
+         *
+         * @return uint32_t The distance in bytes between the start of two rows, 0 if the rows are tightly packed
+         */
+        uint32_t getStride();
+
+        /**
+         * @brief Set the row stride of the frame buffer.
+         * This allows capturing a frame directly into a sub-rectangle of a larger buffer,
+         * e.g. a display buffer or a mosaic of several frames, without an extra copy pass.
+         * The buffer pointer must point to the top-left pixel of the sub-rectangle:
+         * @code {.cpp}
+         * // Capture a 160x120 RGB565 frame at position (x, y) of a 480x320 canvas.
+         * static uint16_t canvas[320][480] __attribute__((aligned(32)));
+         * fb.setBuffer((uint8_t *) &canvas[y][x]);
+         * fb.setStride(480 * 2);
+         * @endcode
+         * @note The buffer pointer and the stride must be a multiple of 4 bytes.
+         * @note The pixels of the larger buffer that share a 32-byte cache line with the rows of the frame
+         * must not be written while a frame is captured, they are discarded when the rows are invalidated.
+         * @param stride Distance in bytes between the start of two rows, 0 for tightly packed rows
+         */
+        void setStride(uint32_t stride);
+
+        /**
+         * @brief Set the format of the frame stored in the buffer.
+         * This is done by Camera::grabFrame(), so that the frame can be processed
+         * without having to look up the camera configuration.
+         *
+         * @param width Width of the frame in pixels
+         * @param height Height of the frame in pixels
+         * @param pixformat Pixel format of the frame, as defined in the pixel format enum
+         */
+        void setFrameFormat(uint32_t width, uint32_t height, int32_t pixformat);
+
+        /**
+         * @brief Get the width of the frame stored in the buffer.
+         *
+         * @return uint32_t The width in pixels, 0 if no frame was captured yet
+         */
+        uint32_t getWidth();
+
+        /**
+         * @brief Get the height of the frame stored in the buffer.
+         *
+         * @return uint32_t The height in pixels, 0 if no frame was captured yet
+         */
+        uint32_t getHeight();
+
+        /**
+         * @brief Get the pixel format of the frame stored in the buffer.
+         *
+         * @return int32_t The pixel format, as defined in the pixel format enum, -1 if no frame was captured yet
+         */
+        int32_t getPixelFormat();
+
         /**
          * @brief Check if the frame buffer has a fixed size.
          * This is the case if the frame buffer is constructed with a width, height, and bits per pixel.
@@ -152,6 +372,9 @@ class FrameBuffer {
 /// Function type definition for motion detection callbacks
 typedef void (*md_callback_t)();
 
+/// Software motion detection state, see ImageProcessing/motion.h
+struct MotionDetector;
+
 
 /**
  * @class ImageSensor
@@ -235,6 +458,18 @@ class ImageSensor {
          */
         virtual int setPixelFormat(int32_t pixelformat) = 0;
 
+        /**
+         * @brief Get the pixel format the sensor sends on the bus for a requested pixel format.
+         * The DCMI cropping is derived from this format. By default, color sensors send
+         * YUV422 for grayscale, and the DCMI only keeps the Y bytes. Sensors that send raw Bayer
+         * for grayscale have their frames converted to luma by Camera::grabFrame().
+         * @param pixelformat The requested pixel format, as defined in the pixel format enum
+         * @return int32_t The pixel format on the bus, as defined in the pixel format enum
+         */
+        virtual int32_t getBusFormat(int32_t pixelformat) {
+            return (pixelformat == CAMERA_GRAYSCALE && !getMono()) ? CAMERA_YUV422 : pixelformat;
+        }
+
         /**
          * @brief Enable motion detection with the specified callback.
          * 
@@ -242,7 +477,7 @@ class ImageSensor {
          * Currently only the Himax HM01B0 and HM0360 support motion detection.
          * @note This has no effect on cameras that do not support motion detection.
          * @param callback Function to be called when motion is detected
-         * @return int 0 on success, non-zero on failure
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't detect motion, other non-zero values on failure
          */
         virtual int enableMotionDetection(md_callback_t callback) = 0;
 
@@ -251,7 +486,7 @@ class ImageSensor {
          * 
          * @note This has no effect on cameras that do not support motion detection. 
          * Currently only the Himax HM01B0 and HM0360 support motion detection.
-         * @return int 0 on success, non-zero on failure
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't detect motion, other non-zero values on failure
          */
         virtual int disableMotionDetection() = 0;
 
@@ -264,7 +499,7 @@ class ImageSensor {
          * @param y The y-coordinate of the window origin
          * @param w The width of the window
          * @param h The height of the window
-         * @return int 0 on success, non-zero on failure
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't detect motion, other non-zero values on failure
          */
         virtual int setMotionDetectionWindow(uint32_t x, uint32_t y, uint32_t w, uint32_t h) = 0;
 
@@ -275,7 +510,7 @@ class ImageSensor {
          * Currently only the Himax HM01B0 and HM0360 support motion detection.
          * On the Himax HM01B0, the recommended threshold range is 3 - 240 (0x03 to 0xF0).
          * @param threshold The motion detection threshold
-         * @return int 0 on success, non-zero on failure
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't detect motion, other non-zero values on failure
          */
         virtual int setMotionDetectionThreshold(uint32_t threshold) = 0;
 
@@ -288,8 +523,22 @@ class ImageSensor {
          * @return int 0 if no motion is detected, non-zero if motion is detected
          */
         virtual int motionDetected() = 0;
+
+        /**
+         * @brief Flip the image vertically.
+         *
+         * @param flip_enable true to enable the vertical flip, false to disable
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't flip the image, other non-zero values on failure
+         */
         virtual int setVerticalFlip(bool flip_enable) = 0;
-        virtual int setHorizontalMirror(bool flip_enable) = 0;        
+
+        /**
+         * @brief Mirror the image horizontally.
+         *
+         * @param flip_enable true to enable the horizontal mirror, false to disable
+         * @return int 0 on success, CAMERA_ENOTSUP if the sensor can't mirror the image, other non-zero values on failure
+         */
+        virtual int setHorizontalMirror(bool flip_enable) = 0;
         /**
          * @brief Output debug information to a stream.
          * You can use this function to output debug information to the serial port by passing Serial as the stream.
@@ -322,6 +571,50 @@ class ImageSensor {
             return -1;
         }
 
+        /**
+         * @brief Enable or disable the automatic exposure and gain control of the sensor.
+         *
+         * @note This has no effect on cameras that do not support it.
+         * The exposure and gain can only be set with setExposure() and setGain() when it is disabled.
+         * @param enable true to enable the automatic exposure and gain control, false to disable
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        virtual int setAutoExposure(bool enable) {
+            return -1;
+        }
+
+        /**
+         * @brief Set the exposure time.
+         *
+         * @note This has no effect on cameras that do not support manual exposure.
+         * @param exposure The exposure time in line periods
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        virtual int setExposure(uint32_t exposure) {
+            return -1;
+        }
+
+        /**
+         * @brief Set the gain.
+         *
+         * @note This has no effect on cameras that do not support manual gain.
+         * The gain is rounded down to the nearest gain supported by the sensor.
+         * @param gain The gain in 1/16 steps, 16 is a gain of 1x
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        virtual int setGain(uint32_t gain) {
+            return -1;
+        }
+
+        /**
+         * @brief Get the highest gain supported by setGain(), higher gains are clipped to it.
+         *
+         * @return uint32_t The maximum gain in 1/16 steps, 0 if the sensor has no manual gain
+         */
+        virtual uint32_t getMaxGain() {
+            return 0;
+        }
+
         /**
          * @brief Get the number of pixel clocks required to read a single pixel from the sensor.
          *
@@ -396,6 +689,7 @@ class Camera {
         int32_t pixformat;       /// Pixel format
         int32_t resolution;      /// Camera resolution
         int32_t original_resolution;    /// The resolution originally set through setResolution()
+        int32_t sensor_resolution;      /// The resolution the sensor outputs, the frame is cropped out of it
         int32_t framerate;       /// Frame rate
         ImageSensor *sensor;     /// Pointer to the camera sensor
         int reset();             /// Reset the camera
@@ -403,6 +697,14 @@ class Camera {
         Stream *_debug;          /// Pointer to the debug stream
         arduino::MbedI2C *_i2c;  /// Pointer to the I2C interface
         FrameBuffer *_framebuffer; /// Pointer to the frame buffer
+        bool soft_vflip;         /// Flip the frames vertically in software, the sensor can't
+        bool soft_hmirror;       /// Mirror the frames horizontally in software, the sensor can't
+        MotionDetector *soft_md; /// Software motion detection, the sensor can't detect motion
+        md_callback_t soft_md_callback; /// Function called when motion is detected in software
+        bool soft_md_enabled;    /// Detect motion in software in grabFrame()
+        bool soft_md_detected;   /// Motion was detected in software since the last motionDetected()
+        MotionDetector *softMotionDetector(); /// Allocate the software motion detection
+        void configureCrop();    /// Crop the frame out of the center of the sensor output
         int setResolutionWithZoom(int32_t resolution, int32_t zoom_resolution, int32_t zoom_x, int32_t zoom_y);
 
     public:
@@ -413,6 +715,11 @@ class Camera {
          */
         Camera(ImageSensor &sensor);
 
+        /**
+         * @brief Destroy the Camera object and free the software motion detection.
+         */
+        ~Camera();
+
         /**
          * @brief Initialize the camera.
          *
@@ -443,7 +750,10 @@ class Camera {
          * @brief Set the resolution of the image sensor.
          * 
          * @note This has no effect on cameras that do not support variable resolutions.
-         * @param resolution The desired resolution, as defined in the resolution enum
+         * Arbitrary sizes created with cameraResolution() are output by the sensor if it supports them,
+         * otherwise they are cropped out of the center of the smallest resolution that contains them.
+         * The width of an arbitrary size must be a multiple of 4.
+         * @param resolution The desired resolution, as defined in the resolution enum or returned by cameraResolution()
          * @return int 0 on success, non-zero on failure
          */
         int setResolution(int32_t resolution);
@@ -453,6 +763,9 @@ class Camera {
          * 
          * @note This has no effect on cameras that do not support variable pixel formats.
          * e.g. the Himax HM01B0 only supports grayscale.
+         * @note The pixel format can't be changed to one that can't be flipped in software
+         * while the frames are flipped or mirrored in software, see setVerticalFlip(),
+         * or to one that can't be analysed while the motion is detected in software.
          * @param pixelformat The desired pixel format, as defined in the pixel format enum
          * @return int 0 on success, non-zero on failure
          */
@@ -480,6 +793,41 @@ class Camera {
          */
         int setTestPattern(bool enable, bool walking);
 
+        /**
+         * @brief Enable or disable the automatic exposure and gain control of the sensor.
+         *
+         * @note This has no effect on cameras that do not support it.
+         * The AutoExposure controller disables it to drive the exposure and gain from the frame statistics.
+         * @param enable true to enable the automatic exposure and gain control, false to disable
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        int setAutoExposure(bool enable);
+
+        /**
+         * @brief Set the exposure time, the automatic exposure control must be disabled.
+         *
+         * @note This has no effect on cameras that do not support manual exposure.
+         * @param exposure The exposure time in line periods
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        int setExposure(uint32_t exposure);
+
+        /**
+         * @brief Set the gain, the automatic gain control must be disabled.
+         *
+         * @note This has no effect on cameras that do not support manual gain.
+         * @param gain The gain in 1/16 steps, 16 is a gain of 1x
+         * @return int 0 on success, non-zero on failure (or not implemented)
+         */
+        int setGain(uint32_t gain);
+
+        /**
+         * @brief Get the highest gain supported by the sensor, higher gains are clipped to it.
+         *
+         * @return uint32_t The maximum gain in 1/16 steps, 0 if the sensor has no manual gain
+         */
+        uint32_t getMaxGain();
+
         /**
          * @brief Get the frame size. This is the number of bytes in a frame as determined by the resolution and pixel format.
          * 
@@ -490,6 +838,8 @@ class Camera {
         /**
          * @brief Capture a frame.
          * 
+         * If the frame buffer has a row stride set, every line is written at the start of its row
+         * and the padding bytes in between are left untouched.
          * @param fb Reference to a FrameBuffer object to store the frame data
          * @param timeout Time in milliseconds to wait for a frame (default: 5000)
          * @return int 0 if successful, non-zero otherwise
@@ -499,18 +849,19 @@ class Camera {
         /**
          * @brief Enable motion detection with the specified callback.
          * 
-         * @note This has no effect on cameras that do not support motion detection. 
-         * Currently only the Himax HM01B0 and HM0360 support motion detection.
+         * @note The Himax HM01B0 and HM0360 detect motion in the sensor. On the other cameras,
+         * the motion is detected in software by grabFrame(), see ImageProcessing/motion.h.
          * @param callback Function to be called when motion is detected
-         * @return int 0 on success, non-zero on failure
+         * @return int 0 on success, non-zero on failure, e.g. if the motion is detected in software
+         * and the current pixel format can't be analysed in software.
          */
         int enableMotionDetection(md_callback_t callback=NULL);
 
         /**
          * @brief Disable motion detection.
          * 
-         * @note This has no effect on cameras that do not support motion detection. 
-         * Currently only the Himax HM01B0 and HM0360 support motion detection.
+         * @note The Himax HM01B0 and HM0360 detect motion in the sensor. On the other cameras,
+         * the motion is detected in software by grabFrame(), see ImageProcessing/motion.h.
          * @return int 0 on success, non-zero on failure
          */
         int disableMotionDetection();
@@ -518,8 +869,8 @@ class Camera {
         /**
          * @brief Set the motion detection window.
          *
-         * @note This has no effect on cameras that do not support motion detection. 
-         * Currently only the Himax HM01B0 and HM0360 support motion detection.
+         * @note The Himax HM01B0 and HM0360 detect motion in the sensor. On the other cameras,
+         * the motion is detected in software by grabFrame(), see ImageProcessing/motion.h.
          * @param x The x-coordinate of the window origin
          * @param y The y-coordinate of the window origin
          * @param w The width of the window
@@ -531,9 +882,10 @@ class Camera {
         /**
          * @brief Set the motion detection threshold.
          * 
-         * @note This has no effect on cameras that do not support motion detection. 
-         * Currently only the Himax HM01B0 and HM0360 support motion detection.
+         * @note The Himax HM01B0 and HM0360 detect motion in the sensor. On the other cameras,
+         * the motion is detected in software by grabFrame(), see ImageProcessing/motion.h.
          * On the Himax HM01B0, the recommended threshold range is 3 - 240 (0x03 to 0xF0).
+         * In software, the threshold is the difference of the mean luma of a block to its background.
          * @param threshold The motion detection threshold
          * @return int 0 on success, non-zero on failure
          */
@@ -542,8 +894,8 @@ class Camera {
         /**
          * @brief Check if motion was detected and clear the motion detection flag.
          * 
-         * @note This has no effect on cameras that do not support motion detection. 
-         * Currently only the Himax HM01B0 and HM0360 support motion detection.
+         * @note The Himax HM01B0 and HM0360 detect motion in the sensor. On the other cameras,
+         * the motion is detected in software by grabFrame(), see ImageProcessing/motion.h.
          * @note This function must be called after the motion detection callback was executed to clear the motion detection flag.
          * @return int 0 if no motion is detected, non-zero if motion is detected
          */
@@ -589,17 +941,21 @@ class Camera {
 
         /**
          * @brief Flips the camera image vertically.
+         * If the sensor can't flip the image, grabFrame() flips grayscale and RGB565 frames in software.
          * 
          * @param flip_enable Set to true to enable vertical flip, false to disable.
-         * @return 0 on success, -1 on failure.
+         * @return 0 on success, -1 on failure, e.g. if the sensor can't flip the image
+         * and the current pixel format can't be flipped in software.
          */
         int setVerticalFlip(bool flip_enable);
 
         /**
          * @brief Mirrors the camera image horizontally.
+         * If the sensor can't mirror the image, grabFrame() mirrors grayscale and RGB565 frames in software.
          * 
          * @param mirror_enable Set to true to enable horizontal mirror, false to disable.
-         * @return 0 on success, -1 on failure.
+         * @return 0 on success, -1 on failure, e.g. if the sensor can't mirror the image
+         * and the current pixel format can't be mirrored in software.
          */
         int setHorizontalMirror(bool mirror_enable);
 
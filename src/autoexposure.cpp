@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Software auto exposure controller.
+ */
+#include "autoexposure.h"
+
+AutoExposure::AutoExposure(Camera &camera) :
+    camera(&camera),
+    exposure(0),
+    max_exposure(0),
+    gain(16),
+    max_gain(16),
+    target(AE_TARGET_DEFAULT),
+    settle(0)
+{
+}
+
+int AutoExposure::begin(uint32_t max_exposure, uint32_t max_gain, uint8_t target)
+{
+    // Higher gains are clipped by the sensor, the controller would lose track of the gain.
+    uint32_t sensor_max_gain = this->camera->getMaxGain();
+    if (max_gain > sensor_max_gain) {
+        max_gain = sensor_max_gain;
+    }
+
+    if (max_exposure == 0 || max_gain < 16 || target == 0) {
+        return -1;
+    }
+
+    this->max_exposure = max_exposure;
+    this->max_gain = max_gain;
+    this->target = target;
+
+    if (this->camera->setAutoExposure(false) != 0) {
+        return -1;
+    }
+
+    // Start from the middle of the exposure range, without gain.
+    this->exposure = (max_exposure + 1) / 2;
+    this->gain = 16;
+    if (this->camera->setExposure(this->exposure) != 0
+            || this->camera->setGain(this->gain) != 0) {
+        return -1;
+    }
+    this->settle = AE_SETTLE_FRAMES;
+    return 0;
+}
+
+int AutoExposure::end()
+{
+    return (this->camera->setAutoExposure(true) == 0) ? 0 : -1;
+}
+
+void AutoExposure::setTarget(uint8_t target)
+{
+    if (target) {
+        this->target = target;
+    }
+}
+
+int AutoExposure::update(const ImageStats &stats)
+{
+    if (stats.count == 0 || this->max_exposure == 0) {
+        return -1;
+    }
+
+    // Wait until the last values are used by the sensor.
+    if (this->settle) {
+        this->settle--;
+        return 0;
+    }
+
+    uint32_t mean = (stats.sum + stats.count / 2) / stats.count;
+    uint32_t saturated = 0;
+    for (uint32_t i = AE_SATURATED; i < 256; i++) {
+        saturated += stats.histogram[i];
+    }
+    // More than 5% of saturated pixels, the mean underestimates the brightness.
+    bool clipped = (saturated * 20 > stats.count);
+
+    // Dead band around the target, so the values don't toggle between two steps.
+    uint32_t tolerance = this->target / 16 + 1;
+    if (!clipped && mean + tolerance >= this->target && mean <= this->target + tolerance) {
+        return 0;
+    }
+
+    // The brightness is proportional to the exposure times the gain.
+    // The step is limited, the response of the sensor isn't linear near saturation.
+    uint64_t total = (uint64_t) this->exposure * this->gain;
+    uint64_t next = total * this->target / (mean ? mean : 1);
+    next = (next < total / 2) ? total / 2 : ((next > total * 2) ? total * 2 : next);
+    if (clipped && next > total * 3 / 4) {
+        next = total * 3 / 4;
+    }
+
+    // Prefer the exposure, it doesn't amplify the noise, up to the maximum that keeps the frame rate.
+    uint64_t new_exposure = next / 16;
+    new_exposure = (new_exposure < 1) ? 1 : ((new_exposure > this->max_exposure) ? this->max_exposure : new_exposure);
+    uint64_t new_gain = next / new_exposure;
+    new_gain = (new_gain < 16) ? 16 : ((new_gain > this->max_gain) ? this->max_gain : new_gain);
+
+    int ret = 0;
+    if (new_exposure != this->exposure) {
+        if (this->camera->setExposure(new_exposure) != 0) {
+            return -1;
+        }
+        this->exposure = new_exposure;
+        ret = 1;
+    }
+    if (new_gain != this->gain) {
+        if (this->camera->setGain(new_gain) != 0) {
+            return -1;
+        }
+        this->gain = new_gain;
+        ret = 1;
+    }
+    if (ret) {
+        this->settle = AE_SETTLE_FRAMES;
+    }
+    return ret;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Software auto exposure controller.
+ */
+
+/**
+ * @file autoexposure.h
+ * @brief Closed-loop exposure and gain control driven by the frame statistics.
+ *
+ * The controller replaces the automatic exposure of sensors such as the OV7670 and the GC2145:
+ * after every frame it compares the mean luma to a target and writes new exposure and gain values.
+ * The exposure never exceeds a configured maximum, so that the sensor never extends the frames
+ * and the frame rate stays the same, the gain makes up for the rest:
+ * @code {.cpp}
+ * AutoExposure ae(cam);
+ * ImageStats stats;
+ * ae.begin(400);
+ * while (cam.grabFrame(fb, 3000) == 0) {
+ *     frameStats(fb, stats);
+ *     ae.update(stats);
+ * }
+ * @endcode
+ * The I2C traffic is bounded: an update writes the exposure and the gain at most once each,
+ * only when they change, and the controller then waits AE_SETTLE_FRAMES frames for the new
+ * values to take effect before the next update.
+ */
+
+#ifndef __AUTOEXPOSURE_H
+#define __AUTOEXPOSURE_H
+
+#include "arducam_dvp.h"
+#include "ImageProcessing/stats.h"
+
+/// Number of frames skipped after writing new values, until they take effect
+#define AE_SETTLE_FRAMES        (2)
+/// Default target mean luma
+#define AE_TARGET_DEFAULT       (110)
+/// Luma values counted as saturated
+#define AE_SATURATED            (250)
+
+/**
+ * @class AutoExposure
+ * @brief Software auto exposure and gain controller.
+ */
+class AutoExposure {
+    private:
+        Camera *camera;             /// Camera to control
+        uint32_t exposure;          /// Current exposure, in line periods
+        uint32_t max_exposure;      /// Maximum exposure, in line periods
+        uint32_t gain;              /// Current gain, in 1/16 steps
+        uint32_t max_gain;          /// Maximum gain, in 1/16 steps
+        uint8_t target;             /// Target mean luma
+        uint32_t settle;            /// Frames left until the last values take effect
+
+    public:
+        /**
+         * @brief Construct a new AutoExposure object.
+         *
+         * @param camera Reference to the camera to control
+         */
+        AutoExposure(Camera &camera);
+
+        /**
+         * @brief Disable the automatic exposure of the sensor and start controlling it.
+         *
+         * @param max_exposure The maximum exposure in line periods, lower than the number of
+         * lines of a frame to keep the frame rate
+         * @param max_gain The maximum gain in 1/16 steps (default: 128, 8x), lowered to the
+         * maximum gain of the sensor, see Camera::getMaxGain()
+         * @param target The target mean luma (default: AE_TARGET_DEFAULT)
+         * @return int 0 on success, -1 on failure, e.g. if the sensor has no manual exposure
+         */
+        int begin(uint32_t max_exposure, uint32_t max_gain=128, uint8_t target=AE_TARGET_DEFAULT);
+
+        /**
+         * @brief Stop controlling the exposure and enable the automatic exposure of the sensor.
+         *
+         * @return int 0 on success, -1 on failure
+         */
+        int end();
+
+        /**
+         * @brief Update the exposure and gain from the statistics of the last frame.
+         *
+         * @param stats The statistics of the last frame, see frameStats()
+         * @return int 1 if new values were written, 0 if not, -1 on failure
+         */
+        int update(const ImageStats &stats);
+
+        /**
+         * @brief Set the target mean luma.
+         *
+         * @param target The target mean luma
+         */
+        void setTarget(uint8_t target);
+
+        /// Get the current exposure, in line periods
+        uint32_t getExposure() { return exposure; }
+
+        /// Get the current gain, in 1/16 steps
+        uint32_t getGain() { return gain; }
+};
+
+#endif /* __AUTOEXPOSURE_H */
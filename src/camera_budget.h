@@ -0,0 +1,223 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Compile-time memory budget planner.
+ */
+
+/**
+ * @file camera_budget.h
+ * @brief Compile-time memory budget planner for capture configurations.
+ *
+ * The planner computes the number of bytes a capture configuration needs in every
+ * memory region, so that a configuration that does not fit is rejected by the compiler
+ * instead of by a failing malloc() in Camera::grabFrame():
+ * @code {.cpp}
+ * #include "camera_budget.h"
+ *
+ * constexpr CameraMemoryPlan plan = CameraMemoryPlan()
+ *     .frames(CAMERA_SENSOR_GC2145, CAMERA_R320x240, CAMERA_RGB565, 2)
+ *     .image(96, 96, CAMERA_GRAYSCALE)
+ *     .bytes(CAMERA_MEM_SRAM, 16 * 1024);
+ * static_assert(plan.fits(), "The capture buffers do not fit in memory");
+ * @endcode
+ */
+
+#ifndef __CAMERA_BUDGET_H
+#define __CAMERA_BUDGET_H
+
+#include "arducam_dvp.h"
+
+/// Memory available for the frame buffers on the internal SRAM
+#ifndef CAMERA_SRAM_SIZE
+#if defined(ARDUINO_PORTENTA_H7_M4) || defined(ARDUINO_GIGA_M4)
+#define CAMERA_SRAM_SIZE        (288 * 1024)        /* D2 domain SRAM */
+#else
+#define CAMERA_SRAM_SIZE        (512 * 1024)        /* D1 domain AXI SRAM */
+#endif
+#endif
+
+/// Memory available for the frame buffers on the external SDRAM
+#ifndef CAMERA_SDRAM_SIZE
+#if defined(ARDUINO_PORTENTA_H7_M7) || defined(ARDUINO_GIGA)
+#define CAMERA_SDRAM_SIZE       (8 * 1024 * 1024)
+#else
+#define CAMERA_SDRAM_SIZE       (0)                 /* No external RAM */
+#endif
+#endif
+
+/// Memory region enumeration
+enum {
+    CAMERA_MEM_SRAM     = 0,    /* Internal SRAM, used by malloc()  */
+    CAMERA_MEM_SDRAM    = 1,    /* External SDRAM                   */
+    CAMERA_MEM_MAX              /* Sentinel value */
+};
+
+/// Camera sensor enumeration
+enum {
+    CAMERA_SENSOR_HM01B0    = 0,
+    CAMERA_SENSOR_HM0360    = 1,
+    CAMERA_SENSOR_OV7670    = 2,
+    CAMERA_SENSOR_OV7675    = 3,
+    CAMERA_SENSOR_GC2145    = 4,
+    CAMERA_SENSOR_MAX               /* Sentinel value */
+};
+
+/**
+ * @brief Get the number of pixel clocks a sensor needs to read a single pixel.
+ * This is the compile-time counterpart of ImageSensor::getPixelReadingCycle().
+ *
+ * @param sensor The sensor, as defined in the sensor enum
+ * @return The number of pixel clocks per pixel
+ */
+constexpr uint32_t cameraPixelReadingCycle(int32_t sensor)
+{
+    return (sensor == CAMERA_SENSOR_HM01B0) ? 2 : 1;
+}
+
+/**
+ * @brief Get the number of bytes an image needs, as allocated by the library.
+ * The 32 bytes used to align the buffer to a cache line are included.
+ *
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @return The size of the image buffer in bytes
+ */
+constexpr uint32_t cameraImageBytes(uint32_t width, uint32_t height, int32_t pixformat)
+{
+    return pixelFormatImageBytes(pixformat, width, height) + 32;
+}
+
+/**
+ * @brief Get the number of bytes Camera::grabFrame() needs for a single frame.
+ *
+ * @param sensor The sensor, as defined in the sensor enum
+ * @param resolution The resolution, as defined in the resolution enum or returned by cameraResolution()
+ * @param pixformat The pixel format, as defined in the pixel format enum
+ * @return The size of the frame buffer in bytes
+ */
+constexpr uint32_t cameraFrameBytes(int32_t sensor, int32_t resolution, int32_t pixformat)
+{
+    return pixelFormatImageBytes(pixformat, resolutionWidth(resolution), resolutionHeight(resolution))
+            * cameraPixelReadingCycle(sensor) + 32;
+}
+
+/**
+ * @class CameraMemoryPlan
+ * @brief Accumulates the buffers of a capture configuration per memory region.
+ *
+ * All methods are constexpr and return a new plan, so a whole configuration can be
+ * described in a single constant expression and checked with static_assert().
+ */
+class CameraMemoryPlan {
+    private:
+        uint32_t _sram;     /// Bytes needed on the internal SRAM
+        uint32_t _sdram;    /// Bytes needed on the external SDRAM
+
+    public:
+        /**
+         * @brief Construct a plan, empty by default.
+         *
+         * @param sram Bytes needed on the internal SRAM
+         * @param sdram Bytes needed on the external SDRAM
+         */
+        constexpr CameraMemoryPlan(uint32_t sram=0, uint32_t sdram=0) :
+            _sram(sram),
+            _sdram(sdram)
+        {
+        }
+
+        /**
+         * @brief Add a number of bytes to a memory region.
+         * This can be used for any buffer that isn't an image, e.g. a tensor arena.
+         *
+         * @param region The memory region, as defined in the memory region enum
+         * @param size The number of bytes
+         * @return CameraMemoryPlan The new plan
+         */
+        constexpr CameraMemoryPlan bytes(int32_t region, uint32_t size) const
+        {
+            return (region == CAMERA_MEM_SDRAM) ? CameraMemoryPlan(_sram, _sdram + size)
+                                                : CameraMemoryPlan(_sram + size, _sdram);
+        }
+
+        /**
+         * @brief Add the frame buffers captured by a camera.
+         *
+         * @param sensor The sensor, as defined in the sensor enum
+         * @param resolution The resolution, as defined in the resolution enum
+         * @param pixformat The pixel format, as defined in the pixel format enum
+         * @param count Number of frame buffers (default: 1), e.g. 2 for double buffering
+         * @param region The memory region the frame buffers are placed in (default: CAMERA_MEM_SRAM)
+         * @return CameraMemoryPlan The new plan
+         */
+        constexpr CameraMemoryPlan frames(int32_t sensor, int32_t resolution, int32_t pixformat,
+                uint32_t count=1, int32_t region=CAMERA_MEM_SRAM) const
+        {
+            return bytes(region, count * cameraFrameBytes(sensor, resolution, pixformat));
+        }
+
+        /**
+         * @brief Add an intermediate image of a processing stage, e.g. the output of a resize.
+         *
+         * @param width Width of the image in pixels
+         * @param height Height of the image in pixels
+         * @param pixformat The pixel format, as defined in the pixel format enum
+         * @param region The memory region the image is placed in (default: CAMERA_MEM_SRAM)
+         * @return CameraMemoryPlan The new plan
+         */
+        constexpr CameraMemoryPlan image(uint32_t width, uint32_t height, int32_t pixformat,
+                int32_t region=CAMERA_MEM_SRAM) const
+        {
+            return bytes(region, cameraImageBytes(width, height, pixformat));
+        }
+
+        /**
+         * @brief Get the number of bytes needed in a memory region.
+         *
+         * @param region The memory region, as defined in the memory region enum
+         * @return uint32_t The number of bytes
+         */
+        constexpr uint32_t total(int32_t region) const
+        {
+            return (region == CAMERA_MEM_SDRAM) ? _sdram : _sram;
+        }
+
+        /**
+         * @brief Get the number of bytes still available in a memory region.
+         *
+         * @param region The memory region, as defined in the memory region enum
+         * @return int32_t The number of free bytes, negative if the region is over budget
+         */
+        constexpr int32_t headroom(int32_t region) const
+        {
+            return (region == CAMERA_MEM_SDRAM) ? (int32_t) CAMERA_SDRAM_SIZE - (int32_t) _sdram
+                                                : (int32_t) CAMERA_SRAM_SIZE - (int32_t) _sram;
+        }
+
+        /**
+         * @brief Check if the plan fits in the memory of the target.
+         *
+         * @return true If all regions are within the budget
+         * @return false Otherwise
+         */
+        constexpr bool fits() const
+        {
+            return (_sram <= CAMERA_SRAM_SIZE) && (_sdram <= CAMERA_SDRAM_SIZE);
+        }
+};
+
+#endif /* __CAMERA_BUDGET_H */
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2021 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Typed image views.
+ */
+
+/**
+ * @file imageview.h
+ * @brief Typed, zero-copy views on the pixels of a frame.
+ *
+ * An ImageView describes a rectangle of pixels in memory (pointer, width, height and stride)
+ * without owning it. The pixel format is a template parameter, so the processing code that
+ * operates on a view knows the pixel type at compile time. Sub-rectangles are views on the
+ * same memory, so a region of interest can be processed without copying it:
+ * @code {.cpp}
+ * if (cam.grabFrame(fb, 3000) == 0) {
+ *     ImageView<PixelGrayscale> frame(fb);
+ *     ImageView<PixelGrayscale> roi = frame.subView(80, 60, 160, 120);
+ *     for (ImageView<PixelGrayscale>::RowIterator it = roi.begin(); it != roi.end(); ++it) {
+ *         uint8_t *row = *it;
+ *         ...
+ *     }
+ * }
+ * @endcode
+ */
+
+#ifndef __IMAGEVIEW_H
+#define __IMAGEVIEW_H
+
+#include "arducam_dvp.h"
+
+/// Pixel format of 8-bit grayscale images
+struct PixelGrayscale {
+    typedef uint8_t pixel_t;
+    static const int32_t format = CAMERA_GRAYSCALE;
+};
+
+/// Pixel format of 8-bit raw Bayer images, of any Bayer phase
+struct PixelBayer {
+    typedef uint8_t pixel_t;
+    static const int32_t format = CAMERA_BAYER;
+};
+
+/// Pixel format of 16-bit big-endian RGB565 images, as stored by the DCMI
+struct PixelRGB565 {
+    typedef uint16_t pixel_t;
+    static const int32_t format = CAMERA_RGB565;
+};
+
+/// Pixel format of 16-bit little-endian RGB565 images
+struct PixelRGB565LE {
+    typedef uint16_t pixel_t;
+    static const int32_t format = CAMERA_RGB565_LE;
+};
+
+/// Pixel format of YUV422 (YUYV) images, every pixel holds its Y byte and either the U or V byte
+struct PixelYUV422 {
+    typedef uint16_t pixel_t;
+    static const int32_t format = CAMERA_YUV422;
+};
+
+/// A 24-bit RGB888 pixel
+struct rgb888_t {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+/// Pixel format of 24-bit RGB888 images
+struct PixelRGB888 {
+    typedef rgb888_t pixel_t;
+    static const int32_t format = CAMERA_RGB888;
+};
+
+/// Pixel format of 32-bit ARGB8888 images, every pixel is a native 0xAARRGGBB word
+struct PixelARGB8888 {
+    typedef uint32_t pixel_t;
+    static const int32_t format = CAMERA_ARGB8888;
+};
+
+/// Pixel format of signed 16-bit images, e.g. image gradients
+struct PixelInt16 {
+    typedef int16_t pixel_t;
+    static const int32_t format = CAMERA_INT16;
+};
+
+/**
+ * @class ImageView
+ * @brief A non-owning view on a rectangle of pixels.
+ *
+ * @param PixelFormat The pixel format of the image, e.g. PixelGrayscale
+ */
+template <typename PixelFormat>
+class ImageView {
+    public:
+        /// The type of a single pixel
+        typedef typename PixelFormat::pixel_t pixel_t;
+
+        /**
+         * @class RowIterator
+         * @brief Iterator over the rows of an ImageView, dereferences to a pointer to the first pixel of the row.
+         */
+        class RowIterator {
+            private:
+                uint8_t *_row;      /// Pointer to the current row
+                uint32_t _stride;   /// Distance in bytes between the start of two rows
+
+            public:
+                RowIterator(uint8_t *row, uint32_t stride) : _row(row), _stride(stride) { }
+                pixel_t *operator*() const { return (pixel_t *) _row; }
+                RowIterator &operator++() { _row += _stride; return *this; }
+                bool operator==(const RowIterator &other) const { return _row == other._row; }
+                bool operator!=(const RowIterator &other) const { return _row != other._row; }
+        };
+
+    private:
+        uint8_t *_data;     /// Pointer to the top-left pixel
+        uint32_t _width;    /// Width in pixels
+        uint32_t _height;   /// Height in pixels
+        uint32_t _stride;   /// Distance in bytes between the start of two rows
+
+    public:
+        /**
+         * @brief Construct an empty view.
+         */
+        ImageView() :
+            _data(NULL),
+            _width(0),
+            _height(0),
+            _stride(0)
+        {
+        }
+
+        /**
+         * @brief Construct a view on a rectangle of pixels.
+         *
+         * @param data Pointer to the top-left pixel
+         * @param width Width in pixels
+         * @param height Height in pixels
+         * @param stride Distance in bytes between the start of two rows (default: 0, tightly packed)
+         */
+        ImageView(void *data, uint32_t width, uint32_t height, uint32_t stride=0) :
+            _data((uint8_t *) data),
+            _width(width),
+            _height(height),
+            _stride(stride ? stride : width * sizeof(pixel_t))
+        {
+        }
+
+        /**
+         * @brief Construct a view on the frame stored in a frame buffer.
+         * The view is empty if the frame doesn't have the pixel format of the view.
+         * A Bayer view accepts frames of any Bayer phase, the phase can be looked up in pixtab.
+         *
+         * @param fb Reference to the FrameBuffer object the frame was captured in
+         */
+        ImageView(FrameBuffer &fb) :
+            _data(NULL),
+            _width(0),
+            _height(0),
+            _stride(0)
+        {
+            int32_t pixformat = fb.getPixelFormat();
+            if (pixformat == PixelFormat::format || (pixformat >= 0 && pixformat < CAMERA_PMAX
+                        && pixtab[pixformat].bayer_phase && pixtab[PixelFormat::format].bayer_phase)) {
+                _data = fb.getBuffer();
+                _width = fb.getWidth();
+                _height = fb.getHeight();
+                _stride = fb.getStride() ? fb.getStride() : _width * sizeof(pixel_t);
+            }
+        }
+
+        /**
+         * @brief Check if the view points to pixels.
+         *
+         * @return true If the view is not empty
+         * @return false Otherwise
+         */
+        bool isValid() const { return _data != NULL && _width && _height; }
+
+        /// Get a pointer to the top-left pixel
+        pixel_t *getData() const { return (pixel_t *) _data; }
+
+        /// Get the width in pixels
+        uint32_t getWidth() const { return _width; }
+
+        /// Get the height in pixels
+        uint32_t getHeight() const { return _height; }
+
+        /// Get the distance in bytes between the start of two rows
+        uint32_t getStride() const { return _stride; }
+
+        /**
+         * @brief Get a pointer to the first pixel of a row.
+         *
+         * @param y The row index
+         * @return pixel_t* Pointer to the first pixel of the row
+         */
+        pixel_t *row(uint32_t y) const { return (pixel_t *) (_data + y * _stride); }
+
+        /**
+         * @brief Get a reference to a pixel.
+         *
+         * @param x The column index
+         * @param y The row index
+         * @return pixel_t& Reference to the pixel
+         */
+        pixel_t &at(uint32_t x, uint32_t y) const { return row(y)[x]; }
+
+        /**
+         * @brief Get a view on a sub-rectangle of this view.
+         * No pixels are copied, the sub-view shares the memory of this view.
+         *
+         * @param x The x-coordinate of the sub-rectangle origin
+         * @param y The y-coordinate of the sub-rectangle origin
+         * @param w The width of the sub-rectangle
+         * @param h The height of the sub-rectangle
+         * @return ImageView The sub-view, empty if the sub-rectangle is outside of this view
+         */
+        ImageView subView(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+        {
+            // Notice that this form prevents uint32_t wraparound, so don't change it
+            if (x > _width || w > (_width - x) || y > _height || h > (_height - y)) {
+                return ImageView();
+            }
+            return ImageView(_data + y * _stride + x * sizeof(pixel_t), w, h, _stride);
+        }
+
+        /// Get an iterator to the first row
+        RowIterator begin() const { return RowIterator(_data, _stride); }
+
+        /// Get an iterator past the last row
+        RowIterator end() const { return RowIterator(_data + _height * _stride, _stride); }
+};
+
+#endif /* __IMAGEVIEW_H */